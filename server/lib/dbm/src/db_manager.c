@@ -203,17 +203,21 @@ static int dbm_statement_query_internal2(sqlite3_stmt *restrict statement,
     }
   }
 
-  // execute query
+  // execute query. `sqlite3_step` keeps failing once it failed, stop on anything which isn't a row
   int step_ret = SQLITE_DONE;
   do {
     step_ret = sqlite3_step(statement);
     if (step_ret == SQLITE_ROW) {
       if (callback) { process_row(statement, callback, arg); }
     }
-  } while (step_ret != SQLITE_DONE);
+  } while (step_ret == SQLITE_ROW);
 
+  // `sqlite3_reset` returns the error of the failed step, if any
   int ret = sqlite3_reset(statement);
-  if (ret != SQLITE_OK) { return ret; }
+  if (ret != SQLITE_OK) {
+    sqlite3_clear_bindings(statement);
+    return ret;
+  }
 
   ret = sqlite3_clear_bindings(statement);
   if (ret != SQLITE_OK) { return ret; }
@@ -252,9 +256,9 @@ int dbm_query2(sqlite3 *restrict db,
 
   va_list args;
   va_start(args, args_count);
-  dbm_statement_query_internal2(statement, callback, arg, args_count, args);
+  int ret = dbm_statement_query_internal2(statement, callback, arg, args_count, args);
   va_end(args);
 
   dbm_statement_destroy(statement);
-  return SQLITE_OK;
+  return ret;
 }
@@ -12,6 +12,7 @@
   "CREATE TABLE IF NOT EXISTS " TABLE_NAME " (id " STRINGIFY(VARCHAR, SIZE) ", data " STRINGIFY(VARCHAR, SIZE) ")"
 #define QUERY_INSERT "INSERT INTO " TABLE_NAME " VALUES (?, ?)"
 #define QUERY_SELECT_ALL "SELECT * FROM " TABLE_NAME
+#define QUERY_STEP_ERROR "SELECT abs(-9223372036854775807 - 1)"  // prepares fine, fails once executed
 
 struct tuple {
   char const *a;
@@ -97,6 +98,12 @@ static void test_select_all2(sqlite3 *restrict db, char const *restrict col_name
   assert(ret == SQLITE_OK);
 }
 
+static void test_step_error2(sqlite3 *restrict db) {
+  int ret = dbm_query2(db, NULL, NULL, QUERY_STEP_ERROR, 0);
+
+  assert(ret != SQLITE_OK);
+}
+
 static sqlite3 *before_all(void) {
   sqlite3 *db = dbm_open(NULL);
   assert(db);
@@ -113,6 +120,7 @@ int main(void) {
   test_create_table2(db);
   test_insert_values2(db, "1", "hello");
   test_select_all2(db, "1", "hello");
+  test_step_error2(db);
 
   after_all(db);
 
@@ -4,7 +4,8 @@
 /**
  * @file logger.h
  * @brief a simple logger for multithreaded environment
- * note that `logger` only blocks `SIGUSR1` during logging. this means that
+ * note that `logger` only blocks the signal it was created with (see `logger_create`) during logging, if any. ftpd
+ * creates it with `SIG_NONE`: tasks are cancelled cooperatively, no signal interrupts a thread while it's logging
  */
 
 #define SIG_NONE -1
@@ -21,6 +21,12 @@ enum command_type {
   CMD_PWD,
   CMD_LIST,
   CMD_ABOR,
+  CMD_ALLO,
+  CMD_STOU,
+  CMD_REST,
+  CMD_CPFR,
+  CMD_CPTO,
+  CMD_STAT,
   CMD_INVALID,
   CMD_UNSUPPORTED,
 };
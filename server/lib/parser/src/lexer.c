@@ -61,28 +61,26 @@ static struct token token_number(char const **ptr) {
   return (struct token){.type = TT_INT, .number = number};
 }
 
-static struct ascii_str token_string(char const **ptr) {
+// the length of the word `*ptr` points to. leaves `*ptr` at its last char. `lexer_lex` increments it as it is
+static size_t token_word(char const **ptr) {
   char const *start = *ptr;
   char const *tmp = *ptr;
 
   for (; *tmp && (isalpha(*tmp) || *tmp == '_'); tmp++) { continue; }
 
   *ptr = tmp - 1;
-  struct ascii_str token_str = ascii_str_create(start, tmp - start);
-  ascii_str_tolower(&token_str);
-
-  return token_str;
+  return tmp - start;
 }
 
-static size_t hash(struct ascii_str *token_str, size_t seed, size_t limit) {
-  if (ascii_str_len(token_str) < 2) return limit + 1;
+static size_t hash(char const *token_str, size_t len, size_t seed, size_t limit) {
+  if (len < 2) return limit + 1;
 
   enum buff_size { local_buf_size = 4 };
   unsigned char buf[local_buf_size] = {0};
 
   // copy the first 2 chars and the last 2 chars of the string into buf
-  memcpy(buf, ascii_str_c_str(token_str), 2);
-  memcpy(buf + 2, ascii_str_c_str(token_str) + ascii_str_len(token_str) - 2, 2);
+  memcpy(buf, token_str, 2);
+  memcpy(buf + 2, token_str + len - 2, 2);
 
   size_t _hash = 0;
   for (size_t i = 0; i < sizeof buf; i++) { _hash = ((_hash << (i * 8)) | (size_t)buf[i]) * seed; }
@@ -90,6 +88,22 @@ static size_t hash(struct ascii_str *token_str, size_t seed, size_t limit) {
   return _hash % limit;
 }
 
+// the keyword a word spells (in any case). `TT_STRING` if it isn't one. looked up on the stack: a keyword costs no
+// allocation
+static enum token_type token_keyword(char const *word, size_t len) {
+  enum keyword_size { keyword_max_len = 4 };
+  if (len > keyword_max_len) return TT_STRING;
+
+  char lower[keyword_max_len + 1] = {0};
+  for (size_t i = 0; i < len; i++) { lower[i] = (char)tolower((unsigned char)word[i]); }
+
+  size_t _hash = hash(lower, len, (size_t)SEED, (size_t)TOKEN_MAPPING_SIZE);
+  if (_hash >= (size_t)TOKEN_MAPPING_SIZE) return TT_STRING;
+  if (!keywords[_hash] || strcmp(lower, keywords[_hash]) != 0) return TT_STRING;
+
+  return (enum token_type)_hash;
+}
+
 struct list lexer_lex(struct ascii_str *text) {
   struct list tokens =
     list_create(sizeof(struct token), token_destroy);  // vec_create(sizeof(struct token), token_destroy);
@@ -108,16 +122,16 @@ struct list lexer_lex(struct ascii_str *text) {
     } else if (isdigit(*curr)) {
       token = token_number(&curr);
     } else {
-      struct ascii_str token_str = token_string(&curr);
-      size_t _hash = hash(&token_str, (size_t)SEED, (size_t)TOKEN_MAPPING_SIZE);
+      char const *word = curr;
+      size_t len = token_word(&curr);
 
-      if (_hash > (size_t)TOKEN_MAPPING_SIZE) {
-        token = (struct token){.type = TT_STRING, .string = token_str};
-      } else if (keywords[_hash] && strcmp(ascii_str_c_str(&token_str), keywords[_hash]) == 0) {  // is a keyword
-        token = (struct token){.type = (enum token_type)_hash};
-        ascii_str_destroy(&token_str);
-      } else {  // not a keyword
+      enum token_type type = token_keyword(word, len);
+      if (type == TT_STRING) {
+        struct ascii_str token_str = ascii_str_create(word, len);
+        ascii_str_tolower(&token_str);
         token = (struct token){.type = TT_STRING, .string = token_str};
+      } else {
+        token = (struct token){.type = type};
       }
     }
 
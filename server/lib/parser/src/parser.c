@@ -6,16 +6,21 @@
 #include "lexer.h"
 
 static struct ascii_str long_to_str(long number) {
-  struct ascii_str str = ascii_str_create(NULL, 0);
-
   enum ltos_size { LTOS_SIZE = 128 };
   char buf[LTOS_SIZE];
 
-  if (snprintf(NULL, 0, "%ld", number) + 1 >= LTOS_SIZE) return str;
-  if (sprintf(buf, "%ld", number) < 0) return str;
+  // formatted on the stack & copied once
+  int len = snprintf(buf, sizeof buf, "%ld", number);
+  if (len < 0 || len >= LTOS_SIZE) return ascii_str_create(NULL, 0);
+
+  return ascii_str_create(buf, (size_t)len);
+}
+
+static void token_destroy(struct token *token) {
+  if (!token) return;
 
-  ascii_str_append(&str, buf);
-  return str;
+  if (token->type == TT_STRING) { ascii_str_destroy(&token->string); }
+  free(token);
 }
 
 static bool parser_consume(struct list *restrict tokens, enum token_type type, struct ascii_str *restrict token) {
@@ -26,7 +31,7 @@ static bool parser_consume(struct list *restrict tokens, enum token_type type, s
   if (!curr) return false;
 
   if (curr->type != type) {
-    free(curr);
+    token_destroy(curr);
     return false;
   }
 
@@ -66,13 +71,6 @@ user_invalid:
   return (struct command){.command = CMD_INVALID};
 }
 
-static void token_destroy(struct token *token) {
-  if (!token) return;
-
-  if (token->type == TT_STRING) { ascii_str_destroy(&token->string); }
-  free(token);
-}
-
 static struct ascii_str parse_password(struct list *restrict tokens) {
   struct ascii_str pass = ascii_str_create(NULL, 0);
   do {
@@ -299,7 +297,7 @@ static struct command stor(struct list *tokens) {
   if (!parser_consume(tokens, TT_SPACE, NULL)) { goto stor_invalid; }
 
   struct ascii_str path;
-  if (!parser_consume(tokens, TT_STRING, &path)) { goto stor_cleanup; }
+  if (!parser_consume(tokens, TT_STRING, &path)) { goto stor_invalid; }
   if (!parser_consume(tokens, TT_CRLF, NULL)) { goto stor_cleanup; }
   if (!parser_consume(tokens, TT_EOF, NULL)) { goto stor_cleanup; }
 
@@ -460,6 +458,131 @@ abor_invalid:
   return (struct command){.command = CMD_INVALID};
 }
 
+// ALLO SPACE INT CRLF EOF
+// or
+// ALLO SPACE INT SPACE R SPACE INT CRLF EOF
+// the optional record size is irrelevant for files and is ignored
+static struct command allo(struct list *tokens) {
+  if (!tokens) { goto allo_invalid; }
+  if (!parser_consume(tokens, TT_ALLO, NULL)) { goto allo_invalid; }
+  if (!parser_consume(tokens, TT_SPACE, NULL)) { goto allo_invalid; }
+
+  struct ascii_str size;
+  if (!parser_consume(tokens, TT_INT, &size)) { goto allo_invalid; }
+
+  struct token *t = list_peek_first(tokens);
+  if (!t) { goto allo_cleanup; }
+
+  if (t->type == TT_SPACE) {
+    parser_consume(tokens, TT_SPACE, NULL);
+
+    t = list_peek_first(tokens);
+    if (!t || t->type != TT_STRING || strcmp(ascii_str_c_str(&t->string), "r") != 0) { goto allo_cleanup; }
+
+    struct ascii_str record;
+    if (!parser_consume(tokens, TT_STRING, &record)) { goto allo_cleanup; }
+    ascii_str_destroy(&record);
+
+    if (!parser_consume(tokens, TT_SPACE, NULL)) { goto allo_cleanup; }
+    if (!parser_consume(tokens, TT_INT, NULL)) { goto allo_cleanup; }
+  }
+
+  if (!parser_consume(tokens, TT_CRLF, NULL)) { goto allo_cleanup; }
+  if (!parser_consume(tokens, TT_EOF, NULL)) { goto allo_cleanup; }
+
+  return (struct command){.command = CMD_ALLO, .arg = size};
+allo_cleanup:
+  ascii_str_destroy(&size);
+allo_invalid:
+  return (struct command){.command = CMD_INVALID};
+}
+
+// REST SPACE INT CRLF EOF
+static struct command rest(struct list *tokens) {
+  if (!tokens) { goto rest_invalid; }
+  if (!parser_consume(tokens, TT_REST, NULL)) { goto rest_invalid; }
+  if (!parser_consume(tokens, TT_SPACE, NULL)) { goto rest_invalid; }
+
+  struct ascii_str marker;
+  if (!parser_consume(tokens, TT_INT, &marker)) { goto rest_invalid; }
+
+  if (!parser_consume(tokens, TT_CRLF, NULL)) { goto rest_cleanup; }
+  if (!parser_consume(tokens, TT_EOF, NULL)) { goto rest_cleanup; }
+
+  return (struct command){.command = CMD_REST, .arg = marker};
+rest_cleanup:
+  ascii_str_destroy(&marker);
+rest_invalid:
+  return (struct command){.command = CMD_INVALID};
+}
+
+// SITE SPACE CPFR SPACE STRING CRLF EOF
+// or
+// SITE SPACE CPTO SPACE STRING CRLF EOF
+static struct command site(struct list *tokens) {
+  if (!tokens) { goto site_invalid; }
+  if (!parser_consume(tokens, TT_SITE, NULL)) { goto site_invalid; }
+  if (!parser_consume(tokens, TT_SPACE, NULL)) { goto site_invalid; }
+
+  struct ascii_str subcommand;
+  if (!parser_consume(tokens, TT_STRING, &subcommand)) { goto site_invalid; }
+
+  enum command_type type = CMD_UNSUPPORTED;
+  if (strcmp(ascii_str_c_str(&subcommand), "cpfr") == 0) {
+    type = CMD_CPFR;
+  } else if (strcmp(ascii_str_c_str(&subcommand), "cpto") == 0) {
+    type = CMD_CPTO;
+  }
+  ascii_str_destroy(&subcommand);
+
+  // any other SITE command is unknown to the server, rather than malformed
+  if (type == CMD_UNSUPPORTED) { return (struct command){.command = CMD_UNSUPPORTED}; }
+
+  if (!parser_consume(tokens, TT_SPACE, NULL)) { goto site_invalid; }
+
+  struct ascii_str path;
+  if (!parser_consume(tokens, TT_STRING, &path)) { goto site_invalid; }
+  if (!parser_consume(tokens, TT_CRLF, NULL)) { goto site_cleanup; }
+  if (!parser_consume(tokens, TT_EOF, NULL)) { goto site_cleanup; }
+
+  return (struct command){.command = type, .arg = path};
+site_cleanup:
+  ascii_str_destroy(&path);
+site_invalid:
+  return (struct command){.command = CMD_INVALID};
+}
+
+// STAT CRLF EOF
+// STAT SPACE STRING CRLF EOF isn't supported
+static struct command stat(struct list *tokens) {
+  if (!tokens) { goto stat_invalid; }
+  if (!parser_consume(tokens, TT_STAT, NULL)) { goto stat_invalid; }
+
+  struct token *t = list_peek_first(tokens);
+  if (t && t->type == TT_SPACE) { return (struct command){.command = CMD_UNSUPPORTED}; }
+
+  if (!parser_consume(tokens, TT_CRLF, NULL)) { goto stat_invalid; }
+  if (!parser_consume(tokens, TT_EOF, NULL)) { goto stat_invalid; }
+
+  return (struct command){.command = CMD_STAT, .arg = ascii_str_create(NULL, 0)};
+stat_invalid:
+  return (struct command){.command = CMD_INVALID};
+}
+
+// STOU CRLF EOF
+static struct command stou(struct list *tokens) {
+  if (!tokens) { goto stou_invalid; }
+  if (!parser_consume(tokens, TT_STOU, NULL)) { goto stou_invalid; }
+  if (!parser_consume(tokens, TT_CRLF, NULL)) { goto stou_invalid; }
+  if (!parser_consume(tokens, TT_EOF, NULL)) { goto stou_invalid; }
+
+  // an empty string is created here for the sake of uniformety. all *valid* commands contains a string even those who
+  // don't really need one. makes it easier on `command_destroy`
+  return (struct command){.command = CMD_STOU, .arg = ascii_str_create(NULL, 0)};
+stou_invalid:
+  return (struct command){.command = CMD_INVALID};
+}
+
 struct command parser_parse(struct list *tokens) {
   struct command cmd = {.command = CMD_INVALID};
 
@@ -518,20 +641,30 @@ struct command parser_parse(struct list *tokens) {
     case TT_ABOR:
       cmd = abor(tokens);
       break;
+    case TT_ALLO:
+      cmd = allo(tokens);
+      break;
+    case TT_STOU:
+      cmd = stou(tokens);
+      break;
+    case TT_REST:
+      cmd = rest(tokens);
+      break;
+    case TT_SITE:
+      cmd = site(tokens);
+      break;
+    case TT_STAT:
+      cmd = stat(tokens);
+      break;
     case TT_ACCT:  // start of fallthrough
     case TT_SMNT:
     case TT_REIN:
     case TT_TYPE:
     case TT_STRU:
     case TT_MODE:
-    case TT_STOU:
     case TT_APPE:
-    case TT_ALLO:
-    case TT_REST:
     case TT_NLST:
-    case TT_SITE:
     case TT_SYST:
-    case TT_STAT:
     case TT_HELP:
     case TT_NOOP:  // end of fallthrough
       cmd = (struct command){.command = CMD_UNSUPPORTED};
@@ -47,6 +47,18 @@ static char const *cmd_type_name(enum command_type cmd) {
       return "LIST";
     case CMD_ABOR:
       return "ABOR";
+    case CMD_ALLO:
+      return "ALLO";
+    case CMD_STOU:
+      return "STOU";
+    case CMD_REST:
+      return "REST";
+    case CMD_CPFR:
+      return "CPFR";
+    case CMD_CPTO:
+      return "CPTO";
+    case CMD_STAT:
+      return "STAT";
     case CMD_INVALID:
       return "INVALID";
     case CMD_UNSUPPORTED:
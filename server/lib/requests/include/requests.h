@@ -26,6 +26,17 @@ enum requests_result {
  */
 enum requests_result requests_send(int sockfd, int flags, struct ascii_str *restrict request);
 
+/**
+ * @brief sends a raw buffer to a socket. blocks until all of `buf` was sent or an error occured
+ *
+ * @param[in] sockfd - a socket file descriptor
+ * @param[in] flags - flags to apply upon sending
+ * @param[in] buf - the data to send
+ * @param[in] len - the number of bytes in `buf`
+ * @return `enum requests_result` - `REQUEST_OK` on success, REQUEST_* otherwise
+ */
+enum requests_result requests_send_buf(int sockfd, int flags, char const *restrict buf, size_t len);
+
 /**
  * @brief recieves a request from a socket
  *
@@ -31,8 +31,12 @@ enum requests_result requests_send(int sockfd, int flags, struct ascii_str *rest
   if (sockfd < 0) return REQUEST_INVALID_SOCKFD;
   if (!request || !ascii_str_len(request)) return REQUEST_INVALID_ARGS;
 
-  char const *buf = ascii_str_c_str(request);
-  size_t len = ascii_str_len(request);
+  return requests_send_buf(sockfd, flags, ascii_str_c_str(request), ascii_str_len(request));
+}
+
+enum requests_result requests_send_buf(int sockfd, int flags, char const *restrict buf, size_t len) {
+  if (sockfd < 0) return REQUEST_INVALID_SOCKFD;
+  if (!buf || !len) return REQUEST_INVALID_ARGS;
 
   size_t sent = 0;
   do {
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+struct task_args;
+
+enum allo_result {
+  ALLO_OK,
+  ALLO_NO_SPACE, /**< either the file system is out of space or the user is out of quota */
+  ALLO_ERROR,
+};
+
+/**
+ * @brief checks whether the file system `path` resides on has room for `size` more bytes. only the blocks available to
+ * unprivileged users are taken into account. `statvfs` runs on the io pool (see `task_args_blocking`)
+ *
+ * @param[in] arg - the arguments of the calling task
+ * @param[in] path - any path on the file system in question
+ * @param[in] size - the number of bytes required
+ * @return `true` if there's enough free space
+ * @return `false` otherwise
+ */
+bool allo_has_room(struct task_args *restrict arg, char const *restrict path, off_t size);
+
+/**
+ * @brief reserves `size` bytes for `fd` with `fallocate` without changing its size. the reservation is made up of as
+ * few extents as the file system can manage which reduces fragmentation & metadata updates during the upload. file
+ * systems which don't support preallocation are treated as if the reservation succeeded. `fallocate` runs on the io
+ * pool (see `task_args_blocking`)
+ *
+ * @param[in] arg - the arguments of the calling task
+ * @param[in] fd - a file opened for writing
+ * @param[in] size - the number of bytes to reserve
+ * @return `ALLO_OK` on success, `ALLO_*` otherwise
+ */
+enum allo_result allo_reserve(struct task_args *arg, int fd, off_t size);
+
+/**
+ * @brief handles ALLO. records the declared size in the session for the next upload. the command is rejected if the
+ * file system doesn't have room for it
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
+ *
+ * @param arg
+ */
+void task_allo(void *arg);
@@ -0,0 +1,45 @@
+#pragma once
+
+/**
+ * @file copy.h
+ * @brief server side copies (SITE CPFR / SITE CPTO). the data never leaves the server, it's copied with
+ * `copy_file_range` which shares the extents (reflink) on file systems which support it (e.g. XFS, btrfs) and copies
+ * them in the kernel otherwise
+ */
+
+#include <stddef.h>
+#include "ascii_str.h"
+
+#define COPY_CHUNK_SIZE (8 * 1024 * 1024)
+
+/**
+ * @brief handles SITE CPFR. records the file to copy in the session for the next SITE CPTO
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
+ *
+ * @param arg
+ */
+void task_cpfr(void *arg);
+
+/**
+ * @brief handles SITE CPTO. copies the file recorded by SITE CPFR to the path given. the copy is written into a
+ * hidden temporary file which replaces the target once its complete.
+ *
+ * the copy runs on the io pool (see `task_args_blocking`), in chunks of `COPY_CHUNK_SIZE` bytes. its progress is
+ * reported by STAT (see `copy_progress`) while its running. a cancelled copy (see `tp_abort_task`) stops at the next
+ * chunk and leaves nothing behind
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
+ *
+ * @param arg
+ */
+void task_cpto(void *arg);
+
+/**
+ * @brief formats the progress of the copies in flight of a session into `buf`, one line per copy. lines which don't fit
+ * are left out
+ *
+ * @param[in] id - the session key (see `task_args::id`)
+ * @param[out] buf
+ * @param[in] size - the size of `buf`
+ * @return `size_t` - the number of chars written into `buf` excluding the null terminator
+ */
+size_t copy_progress(struct ascii_str const *restrict id, char *restrict buf, size_t size);
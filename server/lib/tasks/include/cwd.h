@@ -1,8 +1,8 @@
 #pragma once
 
 /**
- * @brief
- * takes ownership of `arg`
+ * @brief handles CWD
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
  *
  * @param arg
  */
@@ -0,0 +1,9 @@
+#pragma once
+
+/**
+ * @brief streams the listing of a directory into the session's data connection.
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
+ *
+ * @param arg
+ */
+void task_list(void *arg);
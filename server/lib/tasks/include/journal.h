@@ -0,0 +1,80 @@
+#pragma once
+
+/**
+ * @file journal.h
+ * @brief the upload resume journal. an upload records how much of it is known to be on disk (its committed offset)
+ * together with a rolling checksum of said data in the database. a REST+STOR after a crash or a dropped connection
+ * verifies the data against the journal and continues from the restart marker instead of from zero.
+ *
+ * the journal is only written at checkpoints, once every `JOURNAL_CHECKPOINT_INTERVAL` bytes. the hot path only pays
+ * for updating the checksum
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "sqlite3.h"
+
+#define JOURNAL_CHECKPOINT_INTERVAL (64LL * 1024 * 1024)
+#define JOURNAL_CHECKSUM_INIT 1u
+
+struct journal_entry {
+  off_t committed;   /**< the number of bytes which were synced to disk */
+  uint32_t checksum; /**< the checksum of the first `committed` bytes */
+};
+
+/**
+ * @brief creates the journal table if it doesn't exist yet
+ *
+ * @param[in] db
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool journal_init(sqlite3 *db);
+
+/**
+ * @brief looks up the journal entry of an upload
+ *
+ * @param[in] db
+ * @param[in] user - the user who uploaded the file
+ * @param[in] path - the resolved path of the uploaded file
+ * @param[out] entry
+ * @return `true` if an entry was found
+ * @return `false` otherwise
+ */
+bool journal_find(sqlite3 *db, char const *user, char const *path, struct journal_entry *entry);
+
+/**
+ * @brief records a checkpoint of an upload. replaces the previous entry of said upload if there's one.
+ * NOTE: the data must be synced to disk *before* it's committed to the journal
+ *
+ * @param[in] db
+ * @param[in] user
+ * @param[in] path
+ * @param[in] entry
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool journal_commit(sqlite3 *db, char const *user, char const *path, struct journal_entry const *entry);
+
+/**
+ * @brief removes the journal entry of an upload. an upload is removed from the journal once it completes
+ *
+ * @param[in] db
+ * @param[in] user
+ * @param[in] path
+ * @return `true` on success (also if there was no such entry)
+ * @return `false` otherwise
+ */
+bool journal_remove(sqlite3 *db, char const *user, char const *path);
+
+/**
+ * @brief updates the rolling checksum (adler-32) `checksum` with `len` more bytes. the checksum of an empty file is
+ * `JOURNAL_CHECKSUM_INIT`
+ *
+ * @param[in] checksum - the checksum of the data preceding `buf`
+ * @param[in] buf
+ * @param[in] len
+ * @return `uint32_t` - the checksum of the data up to and including `buf`
+ */
+uint32_t journal_checksum(uint32_t checksum, void const *buf, size_t len);
@@ -0,0 +1,47 @@
+#pragma once
+
+/**
+ * @file list_stream.h
+ * @brief a LIST producer which streams a directory listing into the data connection as it reads it. entries are
+ * formatted into a small buffer which is flushed whenever the next entry doesn't fit. the memory used and the time to
+ * the first byte don't depend on the size of the directory
+ */
+
+#define LIST_STREAM_BUF_SIZE 4096
+
+enum list_stream_result {
+  LIST_STREAM_OK,
+  LIST_STREAM_DIR_ERROR,
+  LIST_STREAM_SEND_ERROR,
+  LIST_STREAM_CANCELLED,
+};
+
+struct list_stream;
+
+/**
+ * @brief opens the directory `path` for streaming into `sockfd`. doesn't take ownership of `sockfd`
+ *
+ * @param[in] path - the directory to list
+ * @param[in] sockfd - the data connection
+ * @return `struct list_stream *` on success, `NULL` otherwise
+ */
+struct list_stream *list_stream_create(char const *restrict path, int sockfd);
+
+/**
+ * @brief streams the listing of the directory, one line per entry in the format of `ls -l`.
+ *
+ * the stream checks whether its task was cancelled (see `tp_abort_task`) before every entry. a cancelled stream is
+ * left in a valid state and only has to be destroyed
+ *
+ * @param[in] stream
+ * @return `LIST_STREAM_OK` once all entries were sent, `LIST_STREAM_CANCELLED` if the task was cancelled,
+ * `LIST_STREAM_*` otherwise
+ */
+enum list_stream_result list_stream_run(struct list_stream *stream);
+
+/**
+ * @brief closes the directory and releases the stream. signature is compatible with `task_args::resource_destroy`
+ *
+ * @param[in] stream
+ */
+void list_stream_destroy(void *stream);
@@ -0,0 +1,19 @@
+#pragma once
+
+/**
+ * @file placement.h
+ * @brief the node group of the thread pool a session's tasks go to. a session is served by the threads of the NUMA
+ * node its packets arrive on, next to the buffers the kernel fills for it
+ */
+
+#include "thread_pool.h"
+
+/**
+ * @brief the node group to route the session of `sockfd` to (see `session::node` & `task::node`). the node of the CPU
+ * which processed the last packet received on `sockfd` (`SO_INCOMING_CPU`)
+ *
+ * @param[in] tp
+ * @param[in] sockfd - a connected socket
+ * @return `unsigned` - `TP_NODE_ANY` if the pool isn't split into node groups or the CPU is unknown
+ */
+unsigned socket_node(struct thread_pool *tp, int sockfd);
@@ -0,0 +1,45 @@
+#pragma once
+
+/**
+ * @file priority.h
+ * @brief the priority class of every command & the way its task is added. control commands are interactive so they
+ * never queue behind transfers. a session's commands run on its strand (see `session::strand`), all but ABOR & STAT
+ */
+
+#include "parser.h"
+#include "thread_pool.h"
+
+/**
+ * @brief the priority the task which handles `command` should be added to the pool with (see `task::priority`)
+ *
+ * @param[in] command
+ * @return `enum tp_priority`
+ */
+enum tp_priority command_priority(enum command_type command);
+
+/**
+ * @brief whether the task which handles `command` runs on the session's strand. ABOR & STAT don't: they're about the
+ * transfer or copy which runs right now, they can't wait for it to be done. they're interactive tasks of the pool
+ * instead & see the session as it was when they were taken (see `task_args_session`)
+ *
+ * @param[in] command
+ * @return `true` if the task goes through the strand
+ * @return `false` if it goes straight to the pool
+ */
+bool command_serialized(enum command_type command);
+
+/**
+ * @brief adds the task which handles `command` with the command's priority: to `strand` if the command is serialized
+ * & the session has a strand, to `thread_pool` otherwise
+ *
+ * @param[in] thread_pool
+ * @param[in] strand the session's strand. may be `NULL`
+ * @param[in] command
+ * @param[in] task
+ * @return `true` on success
+ * @return `false` if the task couldn't be added. it's left to the caller in that case
+ */
+bool command_add_task(struct thread_pool *restrict thread_pool,
+                      struct tp_strand *restrict strand,
+                      enum command_type command,
+                      struct task const *restrict task);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+
+/**
+ * @file replies.h
+ * @brief the replies sent over the control connection. see RFC 959 section 4.2
+ */
+
+#define REPLY_150_LIST "150 Here comes the directory listing.\r\n"
+#define REPLY_150_RETR "150 Opening data connection.\r\n"
+#define REPLY_150_STOR "150 Ok to send data.\r\n"
+#define REPLY_150_STOU_FMT "150 FILE: %s\r\n"
+#define REPLY_200_ALLO "200 ALLO command successful.\r\n"
+#define REPLY_211_STAT "211-Status of the server:\r\n"
+#define REPLY_211_STAT_END "211 End of status.\r\n"
+#define REPLY_226 "226 Closing data connection. Requested file action successful.\r\n"
+#define REPLY_226_STOU_FMT "226 Transfer complete. FILE: %s\r\n"
+#define REPLY_250 "250 Requested file action okay, completed.\r\n"
+#define REPLY_350_CPFR "350 File exists, ready for destination name.\r\n"
+#define REPLY_350_REST "350 Restart position accepted. Send STOR or RETR to continue.\r\n"
+#define REPLY_425 "425 Can't open data connection.\r\n"
+#define REPLY_426 "426 Connection closed; transfer aborted.\r\n"
+#define REPLY_450 "450 Requested file action not taken. File unavailable.\r\n"
+#define REPLY_451 "451 Requested action aborted: local error in processing.\r\n"
+#define REPLY_501 "501 Syntax error in parameters or arguments.\r\n"
+#define REPLY_503 "503 Bad sequence of commands.\r\n"
+#define REPLY_550 "550 Requested action not taken. File unavailable.\r\n"
+#define REPLY_552 "552 Requested file action aborted. Exceeded storage allocation.\r\n"
+#define REPLY_553 "553 Requested action not taken. File name not allowed.\r\n"
+#define REPLY_554_REST "554 Requested action not taken: invalid REST parameter.\r\n"
+
+/**
+ * @brief sends a reply over the control connection
+ *
+ * @param[in] sockfd - the control connection
+ * @param[in] reply - one of the `REPLY_*` strings
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool reply_send(int sockfd, char const *reply);
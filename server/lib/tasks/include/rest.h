@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * @brief handles REST. records the restart marker in the session. the next RETR starts sending the file from said
+ * marker. the next STOR continues the upload from it provided the resume journal (see `journal.h`) has verified data up
+ * to it
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
+ *
+ * @param arg
+ */
+void task_rest(void *arg);
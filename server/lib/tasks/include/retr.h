@@ -0,0 +1,15 @@
+#pragma once
+
+#define RETR_ZEROS_SIZE 65536
+
+/**
+ * @brief handles RETR. sends a file over the session's data connection, starting at the restart marker set by REST if
+ * there's one.
+ *
+ * sparse files are read one data region at a time (`SEEK_DATA` / `SEEK_HOLE`). the data is sent with `sendfile`, the
+ * holes are sent as zeros from memory without touching the disk. stream mode has no way to skip them on the wire
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
+ *
+ * @param arg
+ */
+void task_retr(void *arg);
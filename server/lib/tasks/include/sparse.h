@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define SPARSE_BLOCK_SIZE 4096  // the granularity of holes. the block size of most file systems
+
+/**
+ * @brief checks whether `buf` holds nothing but zeros
+ *
+ * @param[in] buf
+ * @param[in] len
+ * @return `true` if all `len` bytes of `buf` are zero (also if `len` is 0)
+ * @return `false` otherwise
+ */
+bool sparse_is_zero(char const *buf, size_t len);
+
+/**
+ * @brief writes `len` bytes at `offset`, the current offset of `fd`. runs of zero blocks are seeked over rather than
+ * written, they read back as zeros. files which are mostly zeros (e.g. VM images) end up sparse on disk. the blocks are
+ * aligned to the file offsets, a hole is only ever made of whole blocks.
+ * NOTE: a run of zeros at the end of the data isn't written either. the caller sets the size of the file once it's
+ * done writing (e.g. with `ftruncate`)
+ *
+ * @param[in] fd
+ * @param[in] offset - the current offset of `fd`
+ * @param[in] buf
+ * @param[in] len
+ * @return `true` on success
+ * @return `false` otherwise. `errno` is set by the `write` or `lseek` which failed
+ */
+bool sparse_write(int fd, off_t offset, char const *buf, size_t len);
@@ -0,0 +1,12 @@
+#pragma once
+
+#define STATUS_REPLY_SIZE 4096
+
+/**
+ * @brief handles STAT without an argument. replies with the status of the session over the control connection,
+ * including the progress of its server side copies (see `copy.h`). may be issued while a copy is in progress
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
+ *
+ * @param arg
+ */
+void task_stat(void *arg);
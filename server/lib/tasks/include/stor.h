@@ -0,0 +1,31 @@
+#pragma once
+
+#define STOR_BUF_SIZE 65536
+
+/**
+ * @brief handles STOR. receives a file over the session's data connection. if a size was declared with ALLO the space
+ * is reserved before the transfer begins and the upload is rejected upfront if it can't fit.
+ *
+ * the upload is atomic. the file replaces its target only once all of the data was received, concurrent readers see
+ * either the old file or the new one in full. an upload which fails or is aborted leaves nothing behind unless it's
+resumable.
+
+large uploads are checkpointed into the resume journal (see `journal.h`). a REST preceding the STOR continues the
+upload from the restart marker, provided the data up to it matches the journal. the restart marker is rejected
+otherwise and the client has to start over.
+
+blocks of zeros aren't written, they're left as holes. uploads of sparse files (e.g. VM images) stay sparse
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
+ *
+ * @param arg
+ */
+void task_stor(void *arg);
+
+/**
+ * @brief handles STOU. same as `task_stor` except that the server picks a unique name for the file. an existing file
+ * is never replaced. the name is reported to the client in the 150 and 226 replies
+ * NOTE: doesn't take ownership of `arg`. the task must be created with `task_args_destroy_wrapper` as its destructor
+ *
+ * @param arg
+ */
+void task_stou(void *arg);
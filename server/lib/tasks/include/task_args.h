@@ -1,12 +1,17 @@
 #pragma once
 
+#include <stdbool.h>
 #include <threads.h>
 #include "ascii_str.h"
 #include "hash_table.h"
 #include "logger.h"
 #include "parser.h"
+#include "session.h"
 #include "sqlite3.h"
 
+struct task;
+struct thread_pool;
+
 struct task_args {
   struct ascii_str id; /**< peer_ip*/
 
@@ -15,12 +20,19 @@ struct task_args {
 
   struct logger *logger;
   sqlite3 *db;
+  struct thread_pool *io_pool; /**< runs the calls which may block for long (see `task_args_blocking`). `NULL` - they
+                                  run on the task's own thread */
 
   struct command cmd;
+
+  void *resource; /**< a resource acquired by the task (e.g. a directory stream). released by `task_args_destroy`,
+                     whether the task completed, failed or was cancelled */
+  void (*resource_destroy)(void *resource);
 };
 
 /**
- * @brief
+ * @brief allocates the arguments from a pool shared by all threads. they must be released with `task_args_destroy`,
+ * never with `free`
  * NOTE: takes ownership of `id` & `command`
  *
  * @param id
@@ -28,6 +40,7 @@ struct task_args {
  * @param sessions
  * @param logger
  * @param db
+ * @param io_pool - optional
  * @param cmd
  * @return struct task_args*
  */
@@ -36,6 +49,93 @@ struct task_args *task_args_create(struct ascii_str id,
                                    struct hash_table *restrict sessions,
                                    struct logger *restrict logger,
                                    sqlite3 *restrict db,
+                                   struct thread_pool *restrict io_pool,
                                    struct command cmd);
 
+/**
+ * @brief like `task_args_create`, but the arguments are stored in `task` itself (see `tp_task_set_args`) rather than
+ * allocated. the dispatch of a command thus takes no allocation. `task::destroy_task` is set to
+ * `task_args_destroy_wrapper`. the handler is passed the arguments as usual
+ * NOTE: takes ownership of `id` & `command` on success
+ *
+ * @param[out] task
+ * @param id
+ * @param sessions_mtx
+ * @param sessions
+ * @param logger
+ * @param db
+ * @param io_pool - optional
+ * @param cmd
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool task_args_embed(struct task *restrict task,
+                     struct ascii_str id,
+                     mtx_t *restrict sessions_mtx,
+                     struct hash_table *restrict sessions,
+                     struct logger *restrict logger,
+                     sqlite3 *restrict db,
+                     struct thread_pool *restrict io_pool,
+                     struct command cmd);
+
 void task_args_destroy(struct task_args *task_args);
+
+/**
+ * @brief a `task::destroy_task` compatible wrapper around `task_args_destroy`. destroys the arguments of `task`, be
+ * they `task::args` or inline ones (see `task_args_embed`)
+ *
+ * @param[in] task a `struct task *` whos arguments are a `struct task_args`
+ */
+void task_args_destroy_wrapper(void *task);
+
+/**
+ * @brief copies the session `task_args::id` refers to into `session`. the session is *shared* with the sessions table,
+ * one must not destroy it. `sessions_mtx` is held for the copy only. the serialized commands of a session run on its
+ * strand (`session::strand`), thus no other one changes the session before the copy is written back. ABOR & STAT skip
+ * the strand (see `command_serialized`) & run beside them: they must not write their copy back & may read only what
+ * the other commands never replace (e.g. the username & the sockets)
+ *
+ * @param[in] task_args
+ * @param[out] session
+ * @return `true` if the session was found
+ * @return `false` otherwise
+ */
+bool task_args_session(struct task_args *restrict task_args, struct session *restrict session);
+
+/**
+ * @brief writes `session` back into the sessions table under `task_args::id`
+ *
+ * @param[in] task_args
+ * @param[in] session - a session previously obtained by `task_args_session`
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool task_args_session_update(struct task_args *restrict task_args, struct session const *restrict session);
+
+/**
+ * @brief runs `call(arg)` on `task_args::io_pool` & waits for it (see `tp_run_on`). meant for the file system calls
+ * which may block for long (e.g. `open` or `fdatasync` on a stalled NFS mount): they hold up a thread of the io pool
+ * rather than one of the threads the commands run on. `call` runs on the calling thread if there's no io pool or it
+ * refused the call
+ *
+ * @param[in] task_args
+ * @param[in] call
+ * @param[in] arg - passed into `call`
+ */
+void task_args_blocking(struct task_args *restrict task_args, void (*call)(void *arg), void *arg);
+
+/**
+ * @brief shuts the data connection `sockfd` down if the task is cancelled (see `tp_abort_task`). a transfer blocked on
+ * it wakes up at once & fails, then notices it was cancelled. must be undone by `task_args_unwatch_socket` before
+ * `sockfd` is closed
+ *
+ * @param[in] sockfd
+ * @return `false` if the task was cancelled already
+ * @return `true` otherwise
+ */
+bool task_args_watch_socket(int sockfd);
+
+/**
+ * @brief undoes `task_args_watch_socket`
+ */
+void task_args_unwatch_socket(void);
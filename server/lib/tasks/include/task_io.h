@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * @file task_io.h
+ * @brief the socket I/O of the tasks. a task running on a fiber (see `tp_options::fibers`) never blocks its thread on a
+ * socket: it does its I/O without waiting & waits for the socket with `tp_wait_fd`, which suspends the fiber. a socket
+ * it can't wait for that way fails the I/O. any other task blocks as usual. files are read & written as usual either
+ * way, a regular file is never waited for
+ */
+
+/**
+ * @brief sends all of `buf`
+ *
+ * @param[in] sockfd
+ * @param[in] buf
+ * @param[in] len
+ * @return `true` on success
+ * @return `false` on failure or if the task was cancelled while waiting for the socket
+ */
+bool task_io_send(int sockfd, void const *buf, size_t len);
+
+/**
+ * @brief receives up to `len` bytes. like `recv`
+ *
+ * @param[in] sockfd
+ * @param[out] buf
+ * @param[in] len
+ * @return `ssize_t` - the number of bytes received, 0 at the end of the stream, -1 on failure or if the task was
+ * cancelled while waiting for the socket
+ */
+ssize_t task_io_recv(int sockfd, void *buf, size_t len);
+
+/**
+ * @brief sends up to `count` bytes of `fd` from `*offset` on. like `sendfile`. on a fiber the socket is switched to non
+ * blocking mode for good, `sendfile` takes no per call flag
+ *
+ * @param[in] sockfd
+ * @param[in] fd
+ * @param[in, out] offset
+ * @param[in] count
+ * @return `ssize_t` - the number of bytes sent, 0 at the end of `fd`, -1 on failure or if the task was cancelled while
+ * waiting for the socket
+ */
+ssize_t task_io_sendfile(int sockfd, int fd, off_t *offset, size_t count);
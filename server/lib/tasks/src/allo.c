@@ -0,0 +1,108 @@
+#include "allo.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/statvfs.h>
+#include "logger.h"
+#include "replies.h"
+#include "session.h"
+#include "task_args.h"
+
+// `statvfs` & `fallocate` may block for long, they run on the io pool (see `task_args_blocking`)
+struct allo_call {
+  char const *path;
+  int fd;
+  off_t size;
+  bool has_room;
+  enum allo_result result;
+};
+
+static void allo_room_call(void *_call) {
+  struct allo_call *call = _call;
+
+  struct statvfs stat;
+  call->has_room = statvfs(call->path, &stat) == 0 &&
+                   (unsigned long long)stat.f_bavail * stat.f_frsize >= (unsigned long long)call->size;
+}
+
+static void allo_reserve_call(void *_call) {
+  struct allo_call *call = _call;
+  if (fallocate(call->fd, FALLOC_FL_KEEP_SIZE, 0, call->size) == 0) {
+    call->result = ALLO_OK;
+    return;
+  }
+
+  switch (errno) {
+    case ENOSPC:  // fallthrough
+    case EDQUOT:
+      call->result = ALLO_NO_SPACE;
+      break;
+    case EOPNOTSUPP:  // fallthrough
+    case ENOSYS:
+      call->result = ALLO_OK;
+      break;
+    default:
+      call->result = ALLO_ERROR;
+      break;
+  }
+}
+
+bool allo_has_room(struct task_args *restrict arg, char const *restrict path, off_t size) {
+  if (!path || size < 0) return false;
+
+  struct allo_call call = {.path = path, .size = size};
+  task_args_blocking(arg, allo_room_call, &call);
+  return call.has_room;
+}
+
+enum allo_result allo_reserve(struct task_args *arg, int fd, off_t size) {
+  if (fd < 0 || size < 0) return ALLO_ERROR;
+  if (!size) return ALLO_OK;
+
+  struct allo_call call = {.fd = fd, .size = size, .result = ALLO_ERROR};
+  task_args_blocking(arg, allo_reserve_call, &call);
+  return call.result;
+}
+
+void task_allo(void *_arg) {
+  if (!_arg) return;
+
+  struct task_args *arg = _arg;
+  if (arg->cmd.command != CMD_ALLO) {
+    LOG(arg->logger, ERROR, "expected command type: %d but recieved %d\n", CMD_ALLO, arg->cmd.command);
+    return;
+  }
+
+  struct session session;
+  if (!task_args_session(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to find a session for key %s\n", ascii_str_c_str(&arg->id));
+    return;
+  }
+
+  char *end = NULL;
+  errno = 0;
+  long long size = strtoll(ascii_str_c_str(&arg->cmd.arg), &end, 10);
+  if (errno || *end || size < 0) {
+    (void)reply_send(session.sockets.control_sockfd, REPLY_501);
+    return;
+  }
+
+  struct ascii_str dir = session_path(&session, NULL);
+  bool has_room = allo_has_room(arg, ascii_str_c_str(&dir), size);
+  ascii_str_destroy(&dir);
+
+  // reject early. there's no point in accepting gigabytes over the wire only to find out they won't fit
+  if (!has_room) {
+    (void)reply_send(session.sockets.control_sockfd, REPLY_552);
+    return;
+  }
+
+  session.allocated = size;
+  if (!task_args_session_update(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to update the session for key %s\n", ascii_str_c_str(&arg->id));
+    (void)reply_send(session.sockets.control_sockfd, REPLY_451);
+    return;
+  }
+
+  (void)reply_send(session.sockets.control_sockfd, REPLY_200_ALLO);
+}
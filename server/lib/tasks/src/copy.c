@@ -0,0 +1,365 @@
+#include "copy.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <threads.h>
+#include <unistd.h>
+#include "logger.h"
+#include "replies.h"
+#include "session.h"
+#include "task_args.h"
+#include "thread_pool.h"
+
+// a copy in flight. lives in `task_args::resource` so a cancelled copy can be cleaned up. registered in `jobs` for STAT
+// to find while it runs
+struct copy_job {
+  struct copy_job *prev;
+  struct copy_job *next;
+  bool registered;
+
+  struct ascii_str id;     /**< the session the copy belongs to */
+  struct ascii_str from;   /**< the resolved source path */
+  struct ascii_str to;     /**< the target as given to SITE CPTO */
+  struct ascii_str target; /**< the resolved target path */
+  struct ascii_str tmp_path;
+
+  int src_fd;
+  int dst_fd;
+  bool published;
+
+  off_t total;
+  atomic_llong copied;
+  atomic_bool cancelled;  // the CPTO task was cancelled. the copy runs on the io pool, `tp_cancelled` can't tell there
+};
+
+static once_flag jobs_once = ONCE_FLAG_INIT;
+static mtx_t jobs_mtx;
+static struct copy_job *jobs;  // the copies in flight. guarded by `jobs_mtx`
+
+static void jobs_init(void) {
+  (void)mtx_init(&jobs_mtx, mtx_plain);
+}
+
+static void job_register(struct copy_job *job) {
+  call_once(&jobs_once, jobs_init);
+  while (mtx_lock(&jobs_mtx) != thrd_success) { continue; }
+
+  job->next = jobs;
+  if (jobs) jobs->prev = job;
+  jobs = job;
+  job->registered = true;
+
+  while (mtx_unlock(&jobs_mtx) != thrd_success) { continue; }
+}
+
+static void job_unregister(struct copy_job *job) {
+  if (!job->registered) return;
+
+  while (mtx_lock(&jobs_mtx) != thrd_success) { continue; }
+
+  if (job->prev) job->prev->next = job->next;
+  if (job->next) job->next->prev = job->prev;
+  if (jobs == job) jobs = job->next;
+  job->registered = false;
+
+  while (mtx_unlock(&jobs_mtx) != thrd_success) { continue; }
+}
+
+static void copy_job_destroy(void *_job) {
+  struct copy_job *job = _job;
+  if (!job) return;
+
+  job_unregister(job);
+
+  if (!job->published && !ascii_str_empty(&job->tmp_path)) (void)unlink(ascii_str_c_str(&job->tmp_path));
+
+  if (job->src_fd >= 0) close(job->src_fd);
+  if (job->dst_fd >= 0) close(job->dst_fd);
+  ascii_str_destroy(&job->id);
+  ascii_str_destroy(&job->from);
+  ascii_str_destroy(&job->to);
+  ascii_str_destroy(&job->target);
+  ascii_str_destroy(&job->tmp_path);
+  free(job);
+}
+
+size_t copy_progress(struct ascii_str const *restrict id, char *restrict buf, size_t size) {
+  if (!id || !buf || !size) return 0;
+
+  call_once(&jobs_once, jobs_init);
+  while (mtx_lock(&jobs_mtx) != thrd_success) { continue; }
+
+  size_t len = 0;
+  for (struct copy_job *job = jobs; job; job = job->next) {
+    if (strcmp(ascii_str_c_str(&job->id), ascii_str_c_str(id)) != 0) continue;
+
+    char const *name = strrchr(ascii_str_c_str(&job->from), '/');
+    name = name ? name + 1 : ascii_str_c_str(&job->from);
+
+    long long copied = atomic_load(&job->copied);
+    int ret = snprintf(buf + len,
+                       size - len,
+                       " Copying %s to %s: %lld of %lld bytes\r\n",
+                       name,
+                       ascii_str_c_str(&job->to),
+                       copied,
+                       (long long)job->total);
+    if (ret < 0 || (size_t)ret >= size - len) break;
+    len += ret;
+  }
+
+  while (mtx_unlock(&jobs_mtx) != thrd_success) { continue; }
+
+  buf[len] = '\0';
+  return len;
+}
+
+// the file system calls may block for long, they run on the io pool (see `task_args_blocking`)
+struct cpfr_stat_call {
+  char const *path;
+  bool regular;
+};
+
+static void cpfr_stat_call(void *_call) {
+  struct cpfr_stat_call *call = _call;
+
+  struct stat st;
+  call->regular = stat(call->path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+void task_cpfr(void *_arg) {
+  if (!_arg) return;
+
+  struct task_args *arg = _arg;
+  if (arg->cmd.command != CMD_CPFR) {
+    LOG(arg->logger, ERROR, "expected command type: %d but recieved %d\n", CMD_CPFR, arg->cmd.command);
+    return;
+  }
+
+  struct session session;
+  if (!task_args_session(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to find a session for key %s\n", ascii_str_c_str(&arg->id));
+    return;
+  }
+
+  struct ascii_str from = session_path(&session, &arg->cmd.arg);
+
+  bool refused = ascii_str_empty(&from);
+  struct cpfr_stat_call stat_call = {.path = ascii_str_c_str(&from)};
+  if (!refused) task_args_blocking(arg, cpfr_stat_call, &stat_call);
+  bool regular = stat_call.regular;
+  if (!regular) ascii_str_destroy(&from);
+
+  if (refused) {
+    (void)reply_send(session.sockets.control_sockfd, REPLY_553);
+    return;
+  }
+
+  if (!regular) {
+    (void)reply_send(session.sockets.control_sockfd, REPLY_550);
+    return;
+  }
+
+  // the sessions table holds on to the previous source until the update went through. it's only released afterwards
+  struct ascii_str copy_from = session.copy_from;
+  session.copy_from = from;
+  if (!task_args_session_update(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to update the session for key %s\n", ascii_str_c_str(&arg->id));
+    ascii_str_destroy(&from);
+    (void)reply_send(session.sockets.control_sockfd, REPLY_451);
+    return;
+  }
+  ascii_str_destroy(&copy_from);
+
+  (void)reply_send(session.sockets.control_sockfd, REPLY_350_CPFR);
+}
+
+enum copy_result {
+  COPY_OK,
+  COPY_NO_SOURCE,  // the source isn't a regular file which can be read
+  COPY_NO_TARGET,  // the temporary copy can't be created next to the target
+  COPY_NO_SPACE,
+  COPY_ERROR,
+  COPY_CANCELLED,
+};
+
+// `copy_file_range` falls back to a copy in the kernel on its own where it can't share extents. older kernels refuse
+// some combinations of file systems altogether, `sendfile` copies in the kernel as well
+static enum copy_result copy(struct copy_job *job) {
+  bool ranges = true;
+  off_t copied = 0;
+
+  while (copied < job->total) {
+    if (atomic_load(&job->cancelled)) return COPY_CANCELLED;
+
+    size_t len = job->total - copied < COPY_CHUNK_SIZE ? (size_t)(job->total - copied) : COPY_CHUNK_SIZE;
+
+    ssize_t ret = ranges ? copy_file_range(job->src_fd, NULL, job->dst_fd, NULL, len, 0)
+                         : sendfile(job->dst_fd, job->src_fd, NULL, len);
+    if (ret == -1) {
+      if (errno == EINTR) continue;
+      if (ranges && (errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP || errno == ENOSYS)) {
+        ranges = false;
+        continue;
+      }
+
+      return errno == ENOSPC || errno == EDQUOT ? COPY_NO_SPACE : COPY_ERROR;
+    }
+
+    if (ret == 0) break;  // the source was truncated in the meantime
+
+    copied += ret;
+    atomic_store(&job->copied, copied);
+  }
+
+  return COPY_OK;
+}
+
+static void copy_cancel(void *_job) {
+  struct copy_job *job = _job;
+
+  atomic_store(&job->cancelled, true);
+}
+
+static enum copy_result copy_run(struct copy_job *job) {
+  struct stat st;
+  job->src_fd = open(ascii_str_c_str(&job->from), O_RDONLY | O_CLOEXEC);
+  if (job->src_fd < 0 || fstat(job->src_fd, &st) != 0 || !S_ISREG(st.st_mode)) return COPY_NO_SOURCE;
+
+  // the copy is written into the directory of its target, i.e. onto the same file system, so it can be renamed over it
+  char const *target_path = ascii_str_c_str(&job->target);
+  char const *slash = strrchr(target_path, '/');
+  char tmp_path[PATH_MAX];
+  int len = slash ? snprintf(tmp_path,
+                             sizeof tmp_path,
+                             "%.*s/.ftpd_copy_XXXXXX",
+                             (int)(slash - target_path),
+                             target_path)
+                  : -1;
+
+  if (len > 0 && (size_t)len < sizeof tmp_path) job->dst_fd = mkostemp(tmp_path, O_CLOEXEC);
+  if (job->dst_fd < 0) return COPY_NO_TARGET;
+
+  job->tmp_path = ascii_str_create(tmp_path, STR_C_STR);
+  job->total = st.st_size;
+  job_register(job);
+
+  (void)fchmod(job->dst_fd, st.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO));
+
+  enum copy_result ret = copy(job);
+
+  // the data must be on disk before the copy becomes visible under its final name
+  if (ret == COPY_OK && fdatasync(job->dst_fd) != 0) ret = COPY_ERROR;
+
+  if (ret == COPY_OK) {
+    job->published = rename(ascii_str_c_str(&job->tmp_path), ascii_str_c_str(&job->target)) == 0;
+    if (!job->published) ret = COPY_ERROR;
+  }
+
+  return ret;
+}
+
+// the whole copy runs on the io pool (see `task_args_blocking`): from opening the source to the rename over the target
+struct cpto_call {
+  struct copy_job *job;
+  enum copy_result result;
+};
+
+static void cpto_call(void *_call) {
+  struct cpto_call *call = _call;
+
+  call->result = copy_run(call->job);
+}
+
+void task_cpto(void *_arg) {
+  if (!_arg) return;
+
+  struct task_args *arg = _arg;
+  if (arg->cmd.command != CMD_CPTO) {
+    LOG(arg->logger, ERROR, "expected command type: %d but recieved %d\n", CMD_CPTO, arg->cmd.command);
+    return;
+  }
+
+  struct session session;
+  if (!task_args_session(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to find a session for key %s\n", ascii_str_c_str(&arg->id));
+    return;
+  }
+
+  int control_sockfd = session.sockets.control_sockfd;
+  if (ascii_str_empty(&session.copy_from)) {
+    (void)reply_send(control_sockfd, REPLY_503);
+    return;
+  }
+
+  struct ascii_str target = session_path(&session, &arg->cmd.arg);
+  if (ascii_str_empty(&target)) {
+    ascii_str_destroy(&target);
+    (void)reply_send(control_sockfd, REPLY_553);
+    return;
+  }
+
+  struct copy_job *job = malloc(sizeof *job);
+  if (!job) ascii_str_destroy(&target);
+  if (job) {
+    *job = (struct copy_job){.id = ascii_str_create(ascii_str_c_str(&arg->id), STR_C_STR),
+                             .from = ascii_str_create(ascii_str_c_str(&session.copy_from), STR_C_STR),
+                             .to = ascii_str_create(ascii_str_c_str(&arg->cmd.arg), STR_C_STR),
+                             .target = target,
+                             .tmp_path = ascii_str_create(NULL, 0),
+                             .src_fd = -1,
+                             .dst_fd = -1};
+    atomic_init(&job->copied, 0);
+    atomic_init(&job->cancelled, false);
+
+    arg->resource = job;
+    arg->resource_destroy = copy_job_destroy;
+  }
+
+  // CPFR applies to a single CPTO
+  struct ascii_str copy_from = session.copy_from;
+  session.copy_from = ascii_str_create(NULL, 0);
+  if (!task_args_session_update(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to update the session for key %s\n", ascii_str_c_str(&arg->id));
+  }
+  ascii_str_destroy(&copy_from);
+
+  if (!job) {
+    (void)reply_send(control_sockfd, REPLY_451);
+    return;
+  }
+
+  // a cancellation reaches the copy on the io pool through the job
+  if (!tp_on_cancel(copy_cancel, job) && tp_cancelled()) atomic_store(&job->cancelled, true);
+
+  struct cpto_call call = {.job = job, .result = COPY_ERROR};
+  task_args_blocking(arg, cpto_call, &call);
+  enum copy_result ret = call.result;
+
+  (void)tp_on_cancel(NULL, NULL);
+
+  switch (ret) {
+    case COPY_OK:
+      (void)reply_send(control_sockfd, REPLY_250);
+      break;
+    case COPY_NO_SOURCE:
+      (void)reply_send(control_sockfd, REPLY_550);
+      break;
+    case COPY_NO_TARGET:
+      (void)reply_send(control_sockfd, REPLY_450);
+      break;
+    case COPY_NO_SPACE:
+      (void)reply_send(control_sockfd, REPLY_552);
+      break;
+    default:
+      (void)reply_send(control_sockfd, REPLY_451);
+      break;
+  }
+}
@@ -0,0 +1,81 @@
+#include "dir_list.h"
+#include <unistd.h>
+#include "list_stream.h"
+#include "logger.h"
+#include "replies.h"
+#include "session.h"
+#include "task_args.h"
+#include "thread_pool.h"
+
+// opening a directory may block for long, it runs on the io pool (see `task_args_blocking`)
+struct list_open_call {
+  char const *path;
+  int sockfd;
+  struct list_stream *stream;
+};
+
+static void list_open_call(void *_call) {
+  struct list_open_call *call = _call;
+
+  call->stream = list_stream_create(call->path, call->sockfd);
+}
+
+void task_list(void *_arg) {
+  if (!_arg) return;
+
+  struct task_args *arg = _arg;
+  if (arg->cmd.command != CMD_LIST) {
+    LOG(arg->logger, ERROR, "expected command type: %d but recieved %d\n", CMD_LIST, arg->cmd.command);
+    return;
+  }
+
+  struct session session;
+  if (!task_args_session(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to find a session for key %s\n", ascii_str_c_str(&arg->id));
+    return;
+  }
+
+  int control_sockfd = session.sockets.control_sockfd;
+  if (session.sockets.data_sockfd < 0) {
+    (void)reply_send(control_sockfd, REPLY_425);
+    return;
+  }
+
+  struct ascii_str path = session_path(&session, &arg->cmd.arg);
+  struct list_open_call open_call = {.path = ascii_str_c_str(&path), .sockfd = session.sockets.data_sockfd};
+  task_args_blocking(arg, list_open_call, &open_call);
+  arg->resource = open_call.stream;
+  arg->resource_destroy = list_stream_destroy;
+  ascii_str_destroy(&path);
+
+  if (!arg->resource) {
+    (void)reply_send(control_sockfd, REPLY_450);
+    return;
+  }
+
+  (void)reply_send(control_sockfd, REPLY_150_LIST);
+
+  enum list_stream_result ret =
+    task_args_watch_socket(session.sockets.data_sockfd) ? list_stream_run(arg->resource) : LIST_STREAM_CANCELLED;
+  task_args_unwatch_socket();
+
+  switch (ret) {
+    case LIST_STREAM_OK:
+      (void)reply_send(control_sockfd, REPLY_226);
+      break;
+    case LIST_STREAM_SEND_ERROR:  // fallthrough
+    case LIST_STREAM_CANCELLED:
+      (void)reply_send(control_sockfd, REPLY_426);
+      break;
+    default:
+      (void)reply_send(control_sockfd, REPLY_451);
+      break;
+  }
+
+  // in stream mode the end of the data is marked by closing the data connection
+  close(session.sockets.data_sockfd);
+  session.sockets.data_sockfd = -1;
+  if (!task_args_session_update(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to update the session for key %s\n", ascii_str_c_str(&arg->id));
+  }
+}
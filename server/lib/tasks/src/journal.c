@@ -0,0 +1,103 @@
+#include "journal.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "db_manager.h"
+
+#define ADLER_MOD 65521u
+#define ADLER_NMAX 5552  // the largest n such that the sums don't overflow 32 bits before they're reduced
+
+// `dbm_query2` passes a row as pairs of (column name, column data). hence every column is selected with its name
+static char const query_create[] = "CREATE TABLE IF NOT EXISTS upload_journal ("
+                                   "username TEXT NOT NULL, "
+                                   "path TEXT NOT NULL, "
+                                   "committed INTEGER NOT NULL, "
+                                   "checksum INTEGER NOT NULL, "
+                                   "PRIMARY KEY (username, path));";
+static char const query_find[] = "SELECT 'committed', committed, 'checksum', checksum FROM upload_journal "
+                                 "WHERE username = ? AND path = ?;";
+static char const query_commit[] = "INSERT OR REPLACE INTO upload_journal (username, path, committed, checksum) "
+                                   "VALUES (?, ?, ?, ?);";
+static char const query_remove[] = "DELETE FROM upload_journal WHERE username = ? AND path = ?;";
+
+bool journal_init(sqlite3 *db) {
+  if (!db) return false;
+
+  return dbm_query2(db, NULL, NULL, query_create, 0) == SQLITE_OK;
+}
+
+struct find_result {
+  struct journal_entry entry;
+  bool committed;
+  bool checksum;
+};
+
+static void process_column(void *restrict arg, char const *restrict col_name, char const *restrict col_data) {
+  struct find_result *result = arg;
+  if (!col_name || !col_data) return;
+
+  char *end = NULL;
+  errno = 0;
+  if (strcmp(col_name, "committed") == 0) {
+    long long committed = strtoll(col_data, &end, 10);
+    result->committed = !errno && !*end && committed >= 0;
+    result->entry.committed = committed;
+  } else if (strcmp(col_name, "checksum") == 0) {
+    unsigned long long checksum = strtoull(col_data, &end, 10);
+    result->checksum = !errno && !*end && checksum <= UINT32_MAX;
+    result->entry.checksum = checksum;
+  }
+}
+
+bool journal_find(sqlite3 *db, char const *user, char const *path, struct journal_entry *entry) {
+  if (!db || !user || !path || !entry) return false;
+
+  struct find_result result = {0};
+  if (dbm_query2(db, process_column, &result, query_find, 2, user, path) != SQLITE_OK) return false;
+  if (!result.committed || !result.checksum) return false;
+
+  *entry = result.entry;
+  return true;
+}
+
+bool journal_commit(sqlite3 *db, char const *user, char const *path, struct journal_entry const *entry) {
+  if (!db || !user || !path || !entry) return false;
+
+  char committed[24];
+  char checksum[16];
+  (void)snprintf(committed, sizeof committed, "%lld", (long long)entry->committed);
+  (void)snprintf(checksum, sizeof checksum, "%" PRIu32, entry->checksum);
+
+  return dbm_query2(db, NULL, NULL, query_commit, 4, user, path, committed, checksum) == SQLITE_OK;
+}
+
+bool journal_remove(sqlite3 *db, char const *user, char const *path) {
+  if (!db || !user || !path) return false;
+
+  return dbm_query2(db, NULL, NULL, query_remove, 2, user, path) == SQLITE_OK;
+}
+
+uint32_t journal_checksum(uint32_t checksum, void const *buf, size_t len) {
+  if (!buf) return checksum;
+
+  unsigned char const *bytes = buf;
+  uint32_t a = checksum & 0xffff;
+  uint32_t b = checksum >> 16;
+
+  while (len) {
+    size_t n = len < ADLER_NMAX ? len : ADLER_NMAX;
+    len -= n;
+
+    while (n--) {
+      a += *bytes++;
+      b += a;
+    }
+
+    a %= ADLER_MOD;
+    b %= ADLER_MOD;
+  }
+
+  return b << 16 | a;
+}
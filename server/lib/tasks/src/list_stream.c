@@ -0,0 +1,133 @@
+#include "list_stream.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "task_io.h"
+#include "thread_pool.h"
+
+struct list_stream {
+  DIR *dir;
+  int sockfd;
+
+  size_t len;
+  char buf[LIST_STREAM_BUF_SIZE];
+};
+
+struct list_stream *list_stream_create(char const *restrict path, int sockfd) {
+  if (!path || sockfd < 0) return NULL;
+
+  struct list_stream *stream = malloc(sizeof *stream);
+  if (!stream) return NULL;
+
+  stream->dir = opendir(path);
+  if (!stream->dir) {
+    free(stream);
+    return NULL;
+  }
+
+  stream->sockfd = sockfd;
+  stream->len = 0;
+  return stream;
+}
+
+void list_stream_destroy(void *_stream) {
+  struct list_stream *stream = _stream;
+  if (!stream) return;
+
+  closedir(stream->dir);
+  free(stream);
+}
+
+static char file_type(mode_t mode) {
+  if (S_ISDIR(mode)) return 'd';
+  if (S_ISLNK(mode)) return 'l';
+  if (S_ISCHR(mode)) return 'c';
+  if (S_ISBLK(mode)) return 'b';
+  if (S_ISFIFO(mode)) return 'p';
+  if (S_ISSOCK(mode)) return 's';
+  return '-';
+}
+
+// formats a single entry into `buf`. returns the number of chars written (excluding the null terminator) or a negative
+// number on failure. same semantics as `snprintf`
+static int format_entry(char *restrict buf, size_t size, char const *restrict name, struct stat const *restrict st) {
+  char perms[] = "----------";
+  perms[0] = file_type(st->st_mode);
+
+  mode_t const bits[] = {S_IRUSR, S_IWUSR, S_IXUSR, S_IRGRP, S_IWGRP, S_IXGRP, S_IROTH, S_IWOTH, S_IXOTH};
+  for (size_t i = 0; i < sizeof bits / sizeof *bits; i++) {
+    if (st->st_mode & bits[i]) perms[i + 1] = "rwx"[i % 3];
+  }
+
+  enum { TIME_SIZE = 32 };
+  char time_rep[TIME_SIZE] = {0};
+  struct tm tm = {0};
+  if (gmtime_r(&st->st_mtime, &tm)) { strftime(time_rep, sizeof time_rep, "%b %e %H:%M", &tm); }
+
+  return snprintf(buf,
+                  size,
+                  "%s %3lu %5u %5u %12lld %s %s\r\n",
+                  perms,
+                  (unsigned long)st->st_nlink,
+                  (unsigned)st->st_uid,
+                  (unsigned)st->st_gid,
+                  (long long)st->st_size,
+                  time_rep,
+                  name);
+}
+
+static bool flush(struct list_stream *stream) {
+  if (!stream->len) return true;
+
+  bool sent = task_io_send(stream->sockfd, stream->buf, stream->len);
+  stream->len = 0;
+
+  return sent;
+}
+
+// formats the entry into the buffer. returns `false` if it didn't fit. an entry which doesn't fit into an empty buffer
+// is dropped
+static bool append_entry(struct list_stream *restrict stream, char const *restrict name, struct stat const *st) {
+  size_t room = sizeof stream->buf - stream->len;
+  int len = format_entry(stream->buf + stream->len, room, name, st);
+  if (len < 0) return true;
+
+  if ((size_t)len >= room) return stream->len == 0;
+
+  stream->len += len;
+  return true;
+}
+
+enum list_stream_result list_stream_run(struct list_stream *stream) {
+  if (!stream) return LIST_STREAM_DIR_ERROR;
+
+  while (true) {
+    if (tp_cancelled()) return LIST_STREAM_CANCELLED;
+
+    bool appended = true;
+    struct stat st;
+    struct dirent *entry = readdir(stream->dir);
+    if (entry && entry->d_name[0] != '.') {
+      if (fstatat(dirfd(stream->dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0) {
+        appended = append_entry(stream, entry->d_name, &st);
+      }
+    }
+
+    if (!entry) break;
+    if (appended) continue;
+
+    // the buffer is full. flush it and reuse it for the entry which didn't fit. `entry` remains valid as long as
+    // `readdir` isn't called again
+    if (!flush(stream)) return tp_cancelled() ? LIST_STREAM_CANCELLED : LIST_STREAM_SEND_ERROR;
+
+    (void)append_entry(stream, entry->d_name, &st);
+  }
+
+  if (flush(stream)) return LIST_STREAM_OK;
+  return tp_cancelled() ? LIST_STREAM_CANCELLED : LIST_STREAM_SEND_ERROR;
+}
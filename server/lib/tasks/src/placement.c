@@ -0,0 +1,12 @@
+#include "placement.h"
+#include <sys/socket.h>
+
+unsigned socket_node(struct thread_pool *tp, int sockfd) {
+  if (tp_nodes_count(tp) < 2) return TP_NODE_ANY;
+
+  int cpu = -1;
+  socklen_t len = sizeof cpu;
+  if (getsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) != 0 || cpu < 0) return TP_NODE_ANY;
+
+  return tp_node_of_cpu(tp, cpu);
+}
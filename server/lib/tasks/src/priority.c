@@ -0,0 +1,41 @@
+#include "priority.h"
+
+enum tp_priority command_priority(enum command_type command) {
+  switch (command) {
+    // transfers & directory listings. they run for as long as the data connection does
+    case CMD_RETR:
+    case CMD_STOR:
+    case CMD_STOU:
+    case CMD_LIST:
+      return TP_PRIORITY_BULK;
+    // server side copies. long & disk bound. the client follows their progress with STAT
+    case CMD_CPTO:
+      return TP_PRIORITY_BACKGROUND;
+    default:
+      return TP_PRIORITY_INTERACTIVE;
+  }
+}
+
+bool command_serialized(enum command_type command) {
+  switch (command) {
+    // out of band. they'd wait for the very command they're about otherwise
+    case CMD_ABOR:
+    case CMD_STAT:
+      return false;
+    default:
+      return true;
+  }
+}
+
+bool command_add_task(struct thread_pool *restrict thread_pool,
+                      struct tp_strand *restrict strand,
+                      enum command_type command,
+                      struct task const *restrict task) {
+  if (!thread_pool || !task) return false;
+
+  struct task copy = *task;
+  copy.priority = command_priority(command);
+  if (strand && command_serialized(command)) return tp_strand_add_task(strand, &copy);
+
+  return tp_add_task(thread_pool, &copy);
+}
@@ -0,0 +1,9 @@
+#include "replies.h"
+#include <string.h>
+#include "task_io.h"
+
+bool reply_send(int sockfd, char const *reply) {
+  if (!reply) return false;
+
+  return task_io_send(sockfd, reply, strlen(reply));
+}
@@ -0,0 +1,40 @@
+#include "rest.h"
+#include <errno.h>
+#include <stdlib.h>
+#include "logger.h"
+#include "replies.h"
+#include "session.h"
+#include "task_args.h"
+
+void task_rest(void *_arg) {
+  if (!_arg) return;
+
+  struct task_args *arg = _arg;
+  if (arg->cmd.command != CMD_REST) {
+    LOG(arg->logger, ERROR, "expected command type: %d but recieved %d\n", CMD_REST, arg->cmd.command);
+    return;
+  }
+
+  struct session session;
+  if (!task_args_session(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to find a session for key %s\n", ascii_str_c_str(&arg->id));
+    return;
+  }
+
+  char *end = NULL;
+  errno = 0;
+  long long marker = strtoll(ascii_str_c_str(&arg->cmd.arg), &end, 10);
+  if (errno || *end || marker < 0) {
+    (void)reply_send(session.sockets.control_sockfd, REPLY_501);
+    return;
+  }
+
+  session.restart = marker;
+  if (!task_args_session_update(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to update the session for key %s\n", ascii_str_c_str(&arg->id));
+    (void)reply_send(session.sockets.control_sockfd, REPLY_451);
+    return;
+  }
+
+  (void)reply_send(session.sockets.control_sockfd, REPLY_350_REST);
+}
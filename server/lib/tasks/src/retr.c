@@ -0,0 +1,198 @@
+#include "retr.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "logger.h"
+#include "replies.h"
+#include "session.h"
+#include "task_args.h"
+#include "task_io.h"
+#include "thread_pool.h"
+
+// the holes of a sparse file are sent from here. never written to, the pages are shared with every other zero page
+static char const zeros[RETR_ZEROS_SIZE];
+
+// lives in `task_args::resource` so the file is closed however the download ends
+struct retr_state {
+  int fd;
+};
+
+static void retr_state_destroy(void *_state) {
+  struct retr_state *state = _state;
+  if (!state) return;
+
+  if (state->fd >= 0) close(state->fd);
+  free(state);
+}
+
+// the open may block for long, it runs on the io pool (see `task_args_blocking`)
+struct retr_open_call {
+  struct retr_state *state;
+  char const *path;
+  struct stat st;
+  bool opened;
+};
+
+static void retr_open_call(void *_call) {
+  struct retr_open_call *call = _call;
+
+  call->state->fd = open(call->path, O_RDONLY | O_CLOEXEC);
+  call->opened = call->state->fd >= 0 && fstat(call->state->fd, &call->st) == 0 && S_ISREG(call->st.st_mode);
+}
+
+enum retr_result {
+  RETR_OK,
+  RETR_SEND_ERROR,
+  RETR_READ_ERROR,
+  RETR_CANCELLED,
+};
+
+static enum retr_result send_zeros(int sockfd, off_t len) {
+  while (len > 0) {
+    if (tp_cancelled()) return RETR_CANCELLED;
+
+    size_t chunk = len < (off_t)sizeof zeros ? (size_t)len : sizeof zeros;
+    if (!task_io_send(sockfd, zeros, chunk)) {
+      return tp_cancelled() ? RETR_CANCELLED : RETR_SEND_ERROR;
+    }
+
+    len -= chunk;
+  }
+
+  return RETR_OK;
+}
+
+static enum retr_result send_data(int sockfd, int fd, off_t offset, off_t end) {
+  while (offset < end) {
+    if (tp_cancelled()) return RETR_CANCELLED;
+
+    ssize_t ret = task_io_sendfile(sockfd, fd, &offset, end - offset);
+    if (ret == -1) {
+      if (tp_cancelled()) return RETR_CANCELLED;
+      return errno == EIO ? RETR_READ_ERROR : RETR_SEND_ERROR;
+    }
+
+    if (ret == 0) return RETR_READ_ERROR;  // the file was truncated in the meantime
+  }
+
+  return RETR_OK;
+}
+
+// sends [offset, size) of `fd` one region at a time. file systems which don't report holes have a single data region
+static enum retr_result send_file(int sockfd, int fd, off_t offset, off_t size) {
+  while (offset < size) {
+    off_t data = lseek(fd, offset, SEEK_DATA);
+    if (data == -1) data = errno == ENXIO ? size : offset;  // ENXIO: there's no data past `offset`
+    if (data > size) data = size;
+
+    if (data > offset) {
+      enum retr_result ret = send_zeros(sockfd, data - offset);
+      if (ret != RETR_OK) return ret;
+
+      offset = data;
+      continue;
+    }
+
+    off_t hole = lseek(fd, offset, SEEK_HOLE);
+    if (hole == -1 || hole > size) hole = size;
+
+    enum retr_result ret = send_data(sockfd, fd, offset, hole);
+    if (ret != RETR_OK) return ret;
+
+    offset = hole;
+  }
+
+  return RETR_OK;
+}
+
+void task_retr(void *_arg) {
+  if (!_arg) return;
+
+  struct task_args *arg = _arg;
+  if (arg->cmd.command != CMD_RETR) {
+    LOG(arg->logger, ERROR, "expected command type: %d but recieved %d\n", CMD_RETR, arg->cmd.command);
+    return;
+  }
+
+  struct session session;
+  if (!task_args_session(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to find a session for key %s\n", ascii_str_c_str(&arg->id));
+    return;
+  }
+
+  int control_sockfd = session.sockets.control_sockfd;
+  if (session.sockets.data_sockfd < 0) {
+    (void)reply_send(control_sockfd, REPLY_425);
+    goto retr_session_update;
+  }
+
+  struct ascii_str path = session_path(&session, &arg->cmd.arg);
+  if (ascii_str_empty(&path)) {
+    ascii_str_destroy(&path);
+    (void)reply_send(control_sockfd, REPLY_553);
+    goto retr_session_update;
+  }
+
+  struct retr_state *state = malloc(sizeof *state);
+  if (state) {
+    *state = (struct retr_state){.fd = -1};
+
+    arg->resource = state;
+    arg->resource_destroy = retr_state_destroy;
+  }
+
+  struct retr_open_call open_call = {.state = state, .path = ascii_str_c_str(&path)};
+  if (state) task_args_blocking(arg, retr_open_call, &open_call);
+  ascii_str_destroy(&path);
+
+  bool opened = open_call.opened;
+  struct stat st = open_call.st;
+
+  if (!state) {
+    (void)reply_send(control_sockfd, REPLY_451);
+    goto retr_session_update;
+  }
+
+  if (!opened) {
+    (void)reply_send(control_sockfd, REPLY_550);
+    goto retr_session_update;
+  }
+
+  if (session.restart > st.st_size) {
+    (void)reply_send(control_sockfd, REPLY_554_REST);
+    goto retr_session_update;
+  }
+
+  (void)reply_send(control_sockfd, REPLY_150_RETR);
+
+  int data_sockfd = session.sockets.data_sockfd;
+  enum retr_result ret = RETR_CANCELLED;
+  if (task_args_watch_socket(data_sockfd)) ret = send_file(data_sockfd, state->fd, session.restart, st.st_size);
+  task_args_unwatch_socket();
+
+  switch (ret) {
+    case RETR_OK:
+      (void)reply_send(control_sockfd, REPLY_226);
+      break;
+    case RETR_SEND_ERROR:  // fallthrough
+    case RETR_CANCELLED:
+      (void)reply_send(control_sockfd, REPLY_426);
+      break;
+    default:
+      (void)reply_send(control_sockfd, REPLY_451);
+      break;
+  }
+
+  // in stream mode the end of the data is marked by closing the data connection
+  close(session.sockets.data_sockfd);
+  session.sockets.data_sockfd = -1;
+
+retr_session_update:
+  session.restart = 0;  // REST applies to a single transfer
+  if (!task_args_session_update(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to update the session for key %s\n", ascii_str_c_str(&arg->id));
+  }
+}
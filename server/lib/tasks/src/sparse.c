@@ -0,0 +1,49 @@
+#include "sparse.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+static bool write_all(int fd, char const *buf, size_t len) {
+  size_t written = 0;
+  while (written < len) {
+    ssize_t ret = write(fd, buf + written, len - written);
+    if (ret == -1) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+
+    written += ret;
+  }
+
+  return true;
+}
+
+// `memcmp` is vectorized by the libc. comparing the buffer with itself shifted by one byte checks all of it in one pass
+bool sparse_is_zero(char const *buf, size_t len) {
+  return !len || (!buf[0] && memcmp(buf, buf + 1, len - 1) == 0);
+}
+
+bool sparse_write(int fd, off_t offset, char const *buf, size_t len) {
+  size_t pos = 0;
+  while (pos < len) {
+    size_t start = pos;
+
+    size_t block = SPARSE_BLOCK_SIZE - (offset + pos) % SPARSE_BLOCK_SIZE;
+    if (block > len - pos) block = len - pos;
+    bool zero = sparse_is_zero(buf + pos, block);
+    pos += block;
+
+    for (; pos < len; pos += block) {
+      block = len - pos < SPARSE_BLOCK_SIZE ? len - pos : SPARSE_BLOCK_SIZE;
+      if (sparse_is_zero(buf + pos, block) != zero) break;
+    }
+
+    if (zero) {
+      if (lseek(fd, pos - start, SEEK_CUR) == -1) return false;
+    } else if (!write_all(fd, buf + start, pos - start)) {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,38 @@
+#include "status.h"
+#include <stdio.h>
+#include <string.h>
+#include "copy.h"
+#include "logger.h"
+#include "replies.h"
+#include "session.h"
+#include "task_args.h"
+
+void task_stat(void *_arg) {
+  if (!_arg) return;
+
+  struct task_args *arg = _arg;
+  if (arg->cmd.command != CMD_STAT) {
+    LOG(arg->logger, ERROR, "expected command type: %d but recieved %d\n", CMD_STAT, arg->cmd.command);
+    return;
+  }
+
+  struct session session;
+  if (!task_args_session(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to find a session for key %s\n", ascii_str_c_str(&arg->id));
+    return;
+  }
+
+  char reply[STATUS_REPLY_SIZE];
+  int len = snprintf(reply, sizeof reply, "%s Logged in as %s\r\n", REPLY_211_STAT, ascii_str_c_str(&session.username));
+  if (len < 0 || (size_t)len + sizeof REPLY_211_STAT_END > sizeof reply) {
+    (void)reply_send(session.sockets.control_sockfd, REPLY_451);
+    return;
+  }
+
+  // leave room for the last line of the reply
+  size_t room = sizeof reply - len - (sizeof REPLY_211_STAT_END - 1);
+  size_t progress = copy_progress(&arg->id, reply + len, room);
+  memcpy(reply + len + progress, REPLY_211_STAT_END, sizeof REPLY_211_STAT_END);
+
+  (void)reply_send(session.sockets.control_sockfd, reply);
+}
@@ -0,0 +1,551 @@
+#include "stor.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "allo.h"
+#include "journal.h"
+#include "logger.h"
+#include "replies.h"
+#include "session.h"
+#include "sparse.h"
+#include "task_args.h"
+#include "task_io.h"
+#include "thread_pool.h"
+
+#define NAME_ATTEMPTS 16
+#define NAME_RANDOM_LEN 8
+
+enum publish_mode {
+  PUBLISH_REPLACE, /**< STOR. replaces the target atomically if it exists */
+  PUBLISH_UNIQUE,  /**< STOU. never replaces an existing file */
+};
+
+// everything an upload holds on to. lives in `task_args::resource` so a cancelled upload can be cleaned up.
+// the data is written into an anonymous file (`O_TMPFILE`) which is only linked into the directory once the upload
+// completed. readers never see a partial file and a failed upload vanishes once `fd` is closed. file systems without
+// `O_TMPFILE` support fall back to a hidden temporary file which is unlinked on failure.
+// an upload which reaches its first checkpoint is linked under its hidden partial name instead and recorded in the
+// resume journal. such an upload is kept around on failure so a REST+STOR can continue it
+struct stor_state {
+  int dirfd;
+  int fd;
+
+  struct ascii_str tmp_name; /**< the name `fd` is currently linked under in `dirfd`. empty while its anonymous */
+  bool published;
+
+  bool journal;   /**< checkpoints are taken. STOR only */
+  bool journaled; /**< `fd` is linked under its partial name and has an entry in the journal */
+  sqlite3 *db;
+  struct ascii_str user;
+  struct ascii_str path; /**< the resolved path of the target. the upload's key in the journal */
+
+  off_t offset;      /**< the size of the file so far */
+  off_t committed;   /**< the offset of the last checkpoint */
+  uint32_t checksum; /**< the checksum of the first `offset` bytes. maintained only while `journal` is set */
+
+  char buf[STOR_BUF_SIZE];
+};
+
+static void stor_state_destroy(void *_state) {
+  struct stor_state *state = _state;
+  if (!state) return;
+
+  if (!state->published && !state->journaled && !ascii_str_empty(&state->tmp_name)) {
+    (void)unlinkat(state->dirfd, ascii_str_c_str(&state->tmp_name), 0);
+  }
+
+  if (state->fd >= 0) close(state->fd);
+  if (state->dirfd >= 0) close(state->dirfd);
+  ascii_str_destroy(&state->tmp_name);
+  ascii_str_destroy(&state->user);
+  ascii_str_destroy(&state->path);
+  free(state);
+}
+
+// the hidden name an upload of `name` is kept under once it's resumable. deterministic, a REST+STOR has to find it.
+// `name` is the last component of the target, the partial file lives next to the target
+static bool partial_name(char *restrict buf, size_t size, char const *restrict name) {
+  int len = snprintf(buf, size, ".ftpd_part_%s", name);
+  return len > 0 && (size_t)len < size;
+}
+
+// splits a resolved path into its directory & its last component. the last component is all the file is ever
+// published under: it names an entry of `dir` & nothing else (e.g. it's never `..`)
+static bool split_path(char const *restrict path,
+                       char *restrict dir,
+                       size_t dir_size,
+                       char *restrict name,
+                       size_t name_size) {
+  char const *slash = strrchr(path, '/');
+  if (!slash || slash == path) return false;
+
+  char const *last = slash + 1;
+  if (!*last || strcmp(last, ".") == 0 || strcmp(last, "..") == 0) return false;
+
+  int name_len = snprintf(name, name_size, "%s", last);
+  int dir_len = snprintf(dir, dir_size, "%.*s", (int)(slash - path), path);
+  return name_len > 0 && (size_t)name_len < name_size && dir_len > 0 && (size_t)dir_len < dir_size;
+}
+
+// generates a name made of `prefix` followed by random lowercase letters. such names can be passed back to the server
+// in a later command as is
+static bool random_name(char *restrict buf, size_t size, char const *restrict prefix) {
+  unsigned char random[NAME_RANDOM_LEN];
+  if (getentropy(random, sizeof random) != 0) return false;
+
+  char suffix[NAME_RANDOM_LEN + 1] = {0};
+  for (size_t i = 0; i < sizeof random; i++) { suffix[i] = 'a' + random[i] % 26; }
+
+  int len = snprintf(buf, size, "%s%s", prefix, suffix);
+  return len > 0 && (size_t)len < size;
+}
+
+// opens the file the upload is written into. `partial` is the partial file of an earlier upload to continue or `NULL`
+// for a new upload
+static bool stor_open(struct stor_state *restrict state, char const *restrict dir, char const *restrict partial) {
+  state->dirfd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (state->dirfd < 0) return false;
+
+  if (partial) {
+    // read as well. the data has to be verified before the upload may continue
+    state->fd = openat(state->dirfd, partial, O_RDWR | O_CLOEXEC);
+    if (state->fd < 0) return false;
+
+    state->tmp_name = ascii_str_create(partial, STR_C_STR);
+    state->journaled = true;
+    return true;
+  }
+
+  state->fd = openat(state->dirfd, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+  if (state->fd >= 0) return true;
+
+  // O_TMPFILE isn't supported by the file system
+  if (errno != EOPNOTSUPP && errno != EISDIR && errno != EINVAL) return false;
+
+  for (size_t i = 0; i < NAME_ATTEMPTS; i++) {
+    char name[NAME_MAX + 1];
+    if (!random_name(name, sizeof name, ".ftpd_")) return false;
+
+    state->fd = openat(state->dirfd, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (state->fd >= 0) {
+      state->tmp_name = ascii_str_create(name, STR_C_STR);
+      return true;
+    }
+
+    if (errno != EEXIST) return false;
+  }
+
+  return false;
+}
+
+// the calls which may block for long run on the io pool (see `task_args_blocking`)
+struct stor_call {
+  struct stor_state *state;
+  char const *dir;
+  char const *partial;
+  bool ok;
+};
+
+static void stor_open_call(void *_call) {
+  struct stor_call *call = _call;
+
+  call->ok = stor_open(call->state, call->dir, call->partial);
+}
+
+static void stor_sync_call(void *_call) {
+  struct stor_call *call = _call;
+
+  call->ok = fdatasync(call->state->fd) == 0;
+}
+
+// links the anonymous `fd` into `dirfd` under `name`. fails with `EEXIST` if `name` exists
+static bool link_anonymous(struct stor_state *restrict state, char const *restrict name) {
+  char proc_path[sizeof "/proc/self/fd/" + 3 * sizeof(int)];
+  (void)snprintf(proc_path, sizeof proc_path, "/proc/self/fd/%d", state->fd);
+
+  return linkat(AT_FDCWD, proc_path, state->dirfd, name, AT_SYMLINK_FOLLOW) == 0;
+}
+
+// makes the uploaded file visible under `name` in a single atomic step. with `PUBLISH_UNIQUE` fails with `EEXIST` if
+// `name` exists
+static bool stor_publish(struct stor_state *restrict state, char const *restrict name, enum publish_mode mode) {
+  if (ascii_str_empty(&state->tmp_name)) {
+    if (mode == PUBLISH_UNIQUE) return state->published = link_anonymous(state, name);
+
+    // link(2) never replaces. link under a temporary name first and rename it over the target
+    for (size_t i = 0; i < NAME_ATTEMPTS && ascii_str_empty(&state->tmp_name); i++) {
+      char tmp_name[NAME_MAX + 1];
+      if (!random_name(tmp_name, sizeof tmp_name, ".ftpd_")) return false;
+
+      if (link_anonymous(state, tmp_name)) {
+        state->tmp_name = ascii_str_create(tmp_name, STR_C_STR);
+      } else if (errno != EEXIST) {
+        return false;
+      }
+    }
+
+    if (ascii_str_empty(&state->tmp_name)) return false;
+  }
+
+  unsigned flags = mode == PUBLISH_UNIQUE ? RENAME_NOREPLACE : 0;
+  return state->published = renameat2(state->dirfd, ascii_str_c_str(&state->tmp_name), state->dirfd, name, flags) == 0;
+}
+
+// links the upload under `partial`. a stale partial file left behind by an earlier upload is replaced. the upload is
+// kept on failure only once it has an entry in the journal
+static bool link_partial(struct stor_state *restrict state, char const *restrict partial) {
+  if (!ascii_str_empty(&state->tmp_name)) {
+    if (renameat(state->dirfd, ascii_str_c_str(&state->tmp_name), state->dirfd, partial) != 0) return false;
+  } else if (!link_anonymous(state, partial)) {
+    if (errno != EEXIST || unlinkat(state->dirfd, partial, 0) != 0 || !link_anonymous(state, partial)) return false;
+  }
+
+  ascii_str_destroy(&state->tmp_name);
+  state->tmp_name = ascii_str_create(partial, STR_C_STR);
+  return true;
+}
+
+// makes everything received so far resumable. the data is synced before it's committed, the journal never refers to
+// data which isn't on disk
+static bool checkpoint(struct stor_state *restrict state, char const *restrict partial) {
+  if (fdatasync(state->fd) != 0) return false;
+
+  bool linked = state->journaled || link_partial(state, partial);
+
+  struct journal_entry entry = {.committed = state->offset, .checksum = state->checksum};
+  bool committed =
+    linked && journal_commit(state->db, ascii_str_c_str(&state->user), ascii_str_c_str(&state->path), &entry);
+
+  if (!committed) return false;
+
+  state->journaled = true;
+  state->committed = state->offset;
+  return true;
+}
+
+static void stor_checkpoint_call(void *_call) {
+  struct stor_call *call = _call;
+
+  call->ok = checkpoint(call->state, call->partial);
+}
+
+// verifies the partial file against its journal entry and positions it at `restart`. the data past the last
+// checkpoint isn't trusted and is discarded
+static bool stor_resume(struct stor_state *restrict state, struct journal_entry const *restrict entry, off_t restart) {
+  uint32_t checksum = JOURNAL_CHECKSUM_INIT;
+  off_t offset = 0;
+
+  while (offset < entry->committed) {
+    off_t left = entry->committed - offset;
+    size_t len = left < (off_t)sizeof state->buf ? (size_t)left : sizeof state->buf;
+
+    ssize_t ret = pread(state->fd, state->buf, len, offset);
+    if (ret == -1) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+
+    if (ret == 0) return false;  // the file is shorter than what was committed
+
+    // the upload continues with the checksum of the data up to the restart marker
+    if (offset < restart && offset + ret >= restart) {
+      state->checksum = journal_checksum(checksum, state->buf, restart - offset);
+    }
+
+    checksum = journal_checksum(checksum, state->buf, ret);
+    offset += ret;
+  }
+
+  if (checksum != entry->checksum) return false;
+  if (ftruncate(state->fd, restart) != 0 || lseek(state->fd, restart, SEEK_SET) != restart) return false;
+
+  state->offset = state->committed = restart;
+  return true;
+}
+
+// the partial file is read back up to the last checkpoint, on the io pool
+struct stor_resume_call {
+  struct stor_state *state;
+  struct journal_entry const *entry;
+  off_t restart;
+  bool ok;
+};
+
+static void stor_resume_call(void *_call) {
+  struct stor_resume_call *call = _call;
+
+  call->ok = stor_resume(call->state, call->entry, call->restart);
+}
+
+enum stor_result {
+  STOR_OK,
+  STOR_RECV_ERROR,
+  STOR_NO_SPACE,
+  STOR_WRITE_ERROR,
+  STOR_CANCELLED,
+};
+
+static enum stor_result receive(struct task_args *restrict arg,
+                                struct stor_state *restrict state,
+                                int sockfd,
+                                char const *restrict partial) {
+  while (true) {
+    if (tp_cancelled()) return STOR_CANCELLED;
+
+    ssize_t ret = task_io_recv(sockfd, state->buf, sizeof state->buf);
+    if (ret == -1) {
+      return tp_cancelled() ? STOR_CANCELLED : STOR_RECV_ERROR;
+    }
+
+    // the client closed the data connection (end of file), unless the connection was shut down by a cancellation
+    if (ret == 0) return tp_cancelled() ? STOR_CANCELLED : STOR_OK;
+
+    if (!sparse_write(state->fd, state->offset, state->buf, ret)) {
+      return errno == ENOSPC || errno == EDQUOT ? STOR_NO_SPACE : STOR_WRITE_ERROR;
+    }
+    state->offset += ret;
+
+    if (!state->journal) continue;
+
+    // the journal is only touched once per `JOURNAL_CHECKPOINT_INTERVAL`. in between only the checksum is updated
+    state->checksum = journal_checksum(state->checksum, state->buf, ret);
+    if (state->offset - state->committed < JOURNAL_CHECKPOINT_INTERVAL) continue;
+
+    struct stor_call call = {.state = state, .partial = partial};
+    task_args_blocking(arg, stor_checkpoint_call, &call);
+    if (!call.ok) {
+      LOG(arg->logger, WARN, "failed to checkpoint %s. the upload won't be resumable\n", ascii_str_c_str(&state->path));
+      state->journal = false;
+    }
+  }
+}
+
+static void reply_send_name(int sockfd, char const *restrict fmt, char const *restrict name) {
+  char reply[NAME_MAX + 64];
+  int len = snprintf(reply, sizeof reply, fmt, name);
+  if (len > 0 && (size_t)len < sizeof reply) (void)reply_send(sockfd, reply);
+}
+
+// the journal is consulted before the upload begins. a REST+STOR continues the partial file if its data checks out,
+// a plain STOR discards the partial file of an earlier upload of the same file
+static void upload(struct task_args *arg, enum publish_mode mode) {
+  struct session session;
+  if (!task_args_session(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to find a session for key %s\n", ascii_str_c_str(&arg->id));
+    return;
+  }
+
+  int control_sockfd = session.sockets.control_sockfd;
+  if (session.sockets.data_sockfd < 0) {
+    (void)reply_send(control_sockfd, REPLY_425);
+    goto upload_session_update;
+  }
+
+  // the upload is written into the directory of its target & published there under the last component of the target.
+  // STOU picks a name of its own in the current directory
+  struct ascii_str path = session_path(&session, mode == PUBLISH_REPLACE ? &arg->cmd.arg : NULL);
+  char dir[PATH_MAX] = {0};
+  char name[NAME_MAX + 1] = {0};
+  char partial[NAME_MAX + 1] = {0};
+  if (mode == PUBLISH_REPLACE) {
+    if (!split_path(ascii_str_c_str(&path), dir, sizeof dir, name, sizeof name) ||
+        !partial_name(partial, sizeof partial, name)) {
+      ascii_str_destroy(&path);
+      (void)reply_send(control_sockfd, REPLY_553);
+      goto upload_session_update;
+    }
+  } else {
+    int len = snprintf(dir, sizeof dir, "%s", ascii_str_c_str(&path));
+    if (len <= 0 || (size_t)len >= sizeof dir || !random_name(name, sizeof name, "stou_")) {
+      ascii_str_destroy(&path);
+      (void)reply_send(control_sockfd, REPLY_451);
+      goto upload_session_update;
+    }
+  }
+
+  struct stor_state *state = malloc(sizeof *state);
+  if (!state) ascii_str_destroy(&path);
+  if (state) {
+    *state = (struct stor_state){.dirfd = -1,
+                                 .fd = -1,
+                                 .tmp_name = ascii_str_create(NULL, 0),
+                                 .db = arg->db,
+                                 .user = ascii_str_create(ascii_str_c_str(&session.username), STR_C_STR),
+                                 .path = path,
+                                 .checksum = JOURNAL_CHECKSUM_INIT};
+
+    arg->resource = state;
+    arg->resource_destroy = stor_state_destroy;
+  }
+
+  // an upload is only resumable if it was journaled up to the restart marker
+  struct journal_entry entry = {0};
+  bool found = false;
+  if (state && mode == PUBLISH_REPLACE) {
+    state->journal = journal_init(state->db);
+    found = state->journal &&
+            journal_find(state->db, ascii_str_c_str(&state->user), ascii_str_c_str(&state->path), &entry);
+  }
+  bool resumable = !session.restart || (found && session.restart <= entry.committed);
+
+  // reject early. the declared size is checked again since the free space might have changed since ALLO
+  bool has_room = !session.allocated || allo_has_room(arg, dir, session.allocated);
+  struct stor_call open_call = {.state = state, .dir = dir};
+  if (session.restart) open_call.partial = partial;
+  if (state && resumable && has_room) task_args_blocking(arg, stor_open_call, &open_call);
+  bool opened = open_call.ok;
+
+  if (!state) {
+    (void)reply_send(control_sockfd, REPLY_451);
+    goto upload_session_update;
+  }
+
+  if (!resumable) {
+    (void)reply_send(control_sockfd, REPLY_554_REST);
+    goto upload_session_update;
+  }
+
+  if (!has_room) {
+    (void)reply_send(control_sockfd, REPLY_552);
+    goto upload_session_update;
+  }
+
+  if (!opened) {
+    (void)reply_send(control_sockfd, REPLY_450);
+    goto upload_session_update;
+  }
+
+  struct stor_resume_call resume_call = {.state = state, .entry = &entry, .restart = session.restart};
+  if (session.restart) task_args_blocking(arg, stor_resume_call, &resume_call);
+  if (session.restart && !resume_call.ok) {
+    // the partial file doesn't match the journal. neither can be trusted, the client has to start over
+    state->journaled = false;
+    (void)reply_send(control_sockfd, REPLY_554_REST);
+    goto upload_journal_remove;
+  }
+
+  if (!session.restart && found) {
+    // a new upload supersedes the partial one
+    (void)unlinkat(state->dirfd, partial, 0);
+    (void)journal_remove(state->db, ascii_str_c_str(&state->user), ascii_str_c_str(&state->path));
+  }
+
+  // the free space was checked before anything was opened. the reservation is made in the upload's own file, never in
+  // the target: a reservation which fails leaves an existing file as it was, the upload's file is discarded along with
+  // `state` (a resumed upload keeps its partial file)
+  switch (allo_reserve(arg, state->fd, session.allocated)) {
+    case ALLO_OK:
+      break;
+    case ALLO_NO_SPACE:
+      (void)reply_send(control_sockfd, REPLY_552);
+      goto upload_session_update;
+    default:
+      LOG(arg->logger, WARN, "failed to reserve %lld bytes for %s\n", (long long)session.allocated, name);
+      break;
+  }
+
+  if (mode == PUBLISH_UNIQUE) {
+    reply_send_name(control_sockfd, REPLY_150_STOU_FMT, name);
+  } else {
+    (void)reply_send(control_sockfd, REPLY_150_STOR);
+  }
+
+  int data_sockfd = session.sockets.data_sockfd;
+  enum stor_result ret =
+    task_args_watch_socket(data_sockfd) ? receive(arg, state, data_sockfd, partial) : STOR_CANCELLED;
+  task_args_unwatch_socket();
+
+  // a declared size larger than the actual upload leaves reserved blocks past the end of the file. give them back. a
+  // file which ends with a hole has to be extended to its size
+  if (session.allocated > state->offset || lseek(state->fd, 0, SEEK_END) != state->offset) {
+    (void)ftruncate(state->fd, state->offset);
+  }
+
+  // the data must be on disk before the file becomes visible under its final name
+  struct stor_call sync_call = {.state = state};
+  if (ret == STOR_OK) task_args_blocking(arg, stor_sync_call, &sync_call);
+  if (ret == STOR_OK && !sync_call.ok) { ret = STOR_WRITE_ERROR; }
+
+  // the connection dropped or the upload was cancelled. keep what arrived since the last checkpoint for the next
+  // attempt
+  bool interrupted = ret == STOR_RECV_ERROR || ret == STOR_CANCELLED;
+  struct stor_call checkpoint_call = {.state = state, .partial = partial};
+  if (interrupted && state->journaled && state->journal && state->offset > state->committed) {
+    task_args_blocking(arg, stor_checkpoint_call, &checkpoint_call);
+  }
+
+  bool published = false;
+  for (size_t i = 0; ret == STOR_OK && !published && i < NAME_ATTEMPTS; i++) {
+    published = stor_publish(state, name, mode);
+
+    // the name picked for STOU was taken in the meantime. pick another one
+    if (!published && mode == PUBLISH_UNIQUE && errno == EEXIST && random_name(name, sizeof name, "stou_")) continue;
+    if (!published) ret = STOR_WRITE_ERROR;
+  }
+
+  switch (ret) {
+    case STOR_OK:
+      if (mode == PUBLISH_UNIQUE) {
+        reply_send_name(control_sockfd, REPLY_226_STOU_FMT, name);
+      } else {
+        (void)reply_send(control_sockfd, REPLY_226);
+      }
+      break;
+    case STOR_RECV_ERROR:  // fallthrough
+    case STOR_CANCELLED:
+      (void)reply_send(control_sockfd, REPLY_426);
+      break;
+    case STOR_NO_SPACE:
+      (void)reply_send(control_sockfd, REPLY_552);
+      break;
+    default:
+      (void)reply_send(control_sockfd, REPLY_451);
+      break;
+  }
+
+  // in stream mode the end of the data is marked by closing the data connection
+  close(session.sockets.data_sockfd);
+  session.sockets.data_sockfd = -1;
+
+  if (!published || !state->journaled) goto upload_session_update;
+
+upload_journal_remove:
+  (void)journal_remove(state->db, ascii_str_c_str(&state->user), ascii_str_c_str(&state->path));
+
+upload_session_update:
+  // ALLO & REST apply to a single upload
+  session.allocated = 0;
+  session.restart = 0;
+  if (!task_args_session_update(arg, &session)) {
+    LOG(arg->logger, ERROR, "failed to update the session for key %s\n", ascii_str_c_str(&arg->id));
+  }
+}
+
+void task_stor(void *_arg) {
+  if (!_arg) return;
+
+  struct task_args *arg = _arg;
+  if (arg->cmd.command != CMD_STOR) {
+    LOG(arg->logger, ERROR, "expected command type: %d but recieved %d\n", CMD_STOR, arg->cmd.command);
+    return;
+  }
+
+  upload(arg, PUBLISH_REPLACE);
+}
+
+void task_stou(void *_arg) {
+  if (!_arg) return;
+
+  struct task_args *arg = _arg;
+  if (arg->cmd.command != CMD_STOU) {
+    LOG(arg->logger, ERROR, "expected command type: %d but recieved %d\n", CMD_STOU, arg->cmd.command);
+    return;
+  }
+
+  upload(arg, PUBLISH_UNIQUE);
+}
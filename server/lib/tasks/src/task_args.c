@@ -1,30 +1,143 @@
 #include "task_args.h"
-#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "thread_pool.h"
+
+// allocated by the thread which reads the commands, freed by the ones which run them. lives as long as the process does
+static struct tp_slab *slab;
+static once_flag slab_once = ONCE_FLAG_INIT;
+
+static void slab_create(void) {
+  slab = tp_slab_create(sizeof(struct task_args));
+}
+
+static bool task_args_valid(mtx_t *restrict sessions_mtx,
+                            struct hash_table *restrict sessions,
+                            struct logger *restrict logger,
+                            sqlite3 *restrict db,
+                            struct command const *cmd) {
+  if (!sessions_mtx || !sessions || !logger || !db) return false;
+  return cmd->command != CMD_INVALID && cmd->command != CMD_UNSUPPORTED;
+}
 
 struct task_args *task_args_create(struct ascii_str id,
                                    mtx_t *restrict sessions_mtx,
                                    struct hash_table *restrict sessions,
                                    struct logger *restrict logger,
                                    sqlite3 *restrict db,
+                                   struct thread_pool *restrict io_pool,
                                    struct command cmd) {
-  if (!sessions_mtx || !sessions || !logger || !db) return NULL;
-  if (cmd.command == CMD_INVALID || cmd.command == CMD_UNSUPPORTED) return NULL;
+  if (!task_args_valid(sessions_mtx, sessions, logger, db, &cmd)) return NULL;
 
-  struct task_args *args = malloc(sizeof *args);
+  call_once(&slab_once, slab_create);
+  struct task_args *args = tp_slab_alloc(slab);
   if (!args) return NULL;
 
   *args = (struct task_args){.id = id,
                              .sessions_mtx = sessions_mtx,
                              .db = db,
                              .logger = logger,
+                             .io_pool = io_pool,
                              .sessions = sessions,
                              .cmd = cmd};
   return args;
 }
 
+bool task_args_embed(struct task *restrict task,
+                     struct ascii_str id,
+                     mtx_t *restrict sessions_mtx,
+                     struct hash_table *restrict sessions,
+                     struct logger *restrict logger,
+                     sqlite3 *restrict db,
+                     struct thread_pool *restrict io_pool,
+                     struct command cmd) {
+  if (!task) return false;
+  if (!task_args_valid(sessions_mtx, sessions, logger, db, &cmd)) return false;
+
+  struct task_args args = {.id = id,
+                           .sessions_mtx = sessions_mtx,
+                           .db = db,
+                           .logger = logger,
+                           .io_pool = io_pool,
+                           .sessions = sessions,
+                           .cmd = cmd};
+  task->destroy_task = task_args_destroy_wrapper;
+  if (tp_task_set_args(task, &args, sizeof args)) return true;
+
+  // too big for the task (i.e. `struct task_args` outgrew `TP_INLINE_ARGS_SIZE`)
+  call_once(&slab_once, slab_create);
+  task->args = tp_slab_alloc(slab);
+  if (!task->args) return false;
+
+  memcpy(task->args, &args, sizeof args);
+  return true;
+}
+
+// releases whatever `task_args` holds but not `task_args` itself
+static void task_args_release(struct task_args *task_args) {
+  if (task_args->resource && task_args->resource_destroy) task_args->resource_destroy(task_args->resource);
+
+  ascii_str_destroy(&task_args->id);
+  command_destroy(&task_args->cmd);
+}
+
 void task_args_destroy(struct task_args *task_args) {
   if (!task_args) return;
 
-  command_destroy(&task_args->cmd);
-  free(task_args);
+  task_args_release(task_args);
+  tp_slab_free(slab, task_args);
+}
+
+void task_args_destroy_wrapper(void *task) {
+  if (!task) return;
+
+  struct task *curr = task;
+  if (curr->inline_size) {
+    task_args_release(tp_task_args(curr));
+  } else {
+    task_args_destroy(curr->args);
+  }
+}
+
+bool task_args_session(struct task_args *restrict task_args, struct session *restrict session) {
+  if (!task_args || !session) return false;
+
+  while (mtx_lock(task_args->sessions_mtx) != thrd_success) { continue; }
+
+  enum ds_error ret = table_get(task_args->sessions, &task_args->id, session);
+
+  while (mtx_unlock(task_args->sessions_mtx) != thrd_success) { continue; }
+
+  return ret == DS_VALUE_OK;
+}
+
+bool task_args_session_update(struct task_args *restrict task_args, struct session const *restrict session) {
+  if (!task_args || !session) return false;
+
+  while (mtx_lock(task_args->sessions_mtx) != thrd_success) { continue; }
+
+  enum ds_error ret = table_put(task_args->sessions, &task_args->id, session, NULL);
+
+  while (mtx_unlock(task_args->sessions_mtx) != thrd_success) { continue; }
+
+  return ret == DS_OK || ret == DS_VALUE_OK;
+}
+
+void task_args_blocking(struct task_args *restrict task_args, void (*call)(void *arg), void *arg) {
+  if (!task_args || !call) return;
+
+  if (!task_args->io_pool || !tp_run_on(task_args->io_pool, call, arg)) call(arg);
+}
+
+static void socket_shutdown(void *sockfd) {
+  (void)shutdown((int)(intptr_t)sockfd, SHUT_RDWR);
+}
+
+bool task_args_watch_socket(int sockfd) {
+  return tp_on_cancel(socket_shutdown, (void *)(intptr_t)sockfd);
+}
+
+void task_args_unwatch_socket(void) {
+  (void)tp_on_cancel(NULL, NULL);
 }
@@ -0,0 +1,55 @@
+#include "task_io.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include "thread_pool.h"
+
+// the socket is full (or empty) & the task may wait for it
+static bool wait_for(int sockfd, unsigned events) {
+  return (errno == EAGAIN || errno == EWOULDBLOCK) && tp_wait_fd(sockfd, events);
+}
+
+static bool set_nonblocking(int sockfd) {
+  int flags = fcntl(sockfd, F_GETFL);
+  if (flags == -1) return false;
+
+  return (flags & O_NONBLOCK) || fcntl(sockfd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+bool task_io_send(int sockfd, void const *buf, size_t len) {
+  int flags = MSG_NOSIGNAL | (tp_in_fiber() ? MSG_DONTWAIT : 0);
+
+  size_t sent = 0;
+  while (sent < len) {
+    ssize_t ret = send(sockfd, (char const *)buf + sent, len - sent, flags);
+    if (ret == -1) {
+      if (errno == EINTR || wait_for(sockfd, TP_WAIT_WRITE)) continue;
+      return false;
+    }
+
+    sent += ret;
+  }
+
+  return true;
+}
+
+ssize_t task_io_recv(int sockfd, void *buf, size_t len) {
+  int flags = tp_in_fiber() ? MSG_DONTWAIT : 0;
+
+  while (true) {
+    ssize_t ret = recv(sockfd, buf, len, flags);
+    if (ret != -1) return ret;
+    if (errno != EINTR && !wait_for(sockfd, TP_WAIT_READ)) return -1;
+  }
+}
+
+ssize_t task_io_sendfile(int sockfd, int fd, off_t *offset, size_t count) {
+  if (tp_in_fiber() && !set_nonblocking(sockfd)) return -1;
+
+  while (true) {
+    ssize_t ret = sendfile(sockfd, fd, offset, count);
+    if (ret != -1) return ret;
+    if (errno != EINTR && !wait_for(sockfd, TP_WAIT_WRITE)) return -1;
+  }
+}
@@ -0,0 +1,88 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "journal.h"
+
+#define USER "user"
+#define PATH "/srv/ftp/user/some_file"
+
+static sqlite3 *before(void) {
+  sqlite3 *db = NULL;
+  assert(sqlite3_open(":memory:", &db) == SQLITE_OK);
+  assert(journal_init(db));
+  return db;
+}
+
+static void after(sqlite3 *db) {
+  assert(sqlite3_close(db) == SQLITE_OK);
+}
+
+static void test_round_trip(void) {
+  sqlite3 *db = before();
+  struct journal_entry entry = {0};
+
+  // given an empty journal
+  assert(!journal_find(db, USER, PATH, &entry));
+  assert(journal_init(db));  // creating the table twice is fine
+
+  // when a checkpoint is committed, then it's found
+  struct journal_entry first = {.committed = JOURNAL_CHECKPOINT_INTERVAL, .checksum = 0xdeadbeefu};
+  assert(journal_commit(db, USER, PATH, &first));
+  assert(journal_find(db, USER, PATH, &entry));
+  assert(entry.committed == first.committed);
+  assert(entry.checksum == first.checksum);
+
+  // a later checkpoint replaces it
+  struct journal_entry second = {.committed = 3 * JOURNAL_CHECKPOINT_INTERVAL, .checksum = UINT32_MAX};
+  assert(journal_commit(db, USER, PATH, &second));
+  assert(journal_find(db, USER, PATH, &entry));
+  assert(entry.committed == second.committed);
+  assert(entry.checksum == second.checksum);
+
+  // the entries are kept per user & path
+  assert(!journal_find(db, "other_user", PATH, &entry));
+  assert(!journal_find(db, USER, "/srv/ftp/user/other_file", &entry));
+
+  // a completed upload is removed. removing it again is fine
+  assert(journal_remove(db, USER, PATH));
+  assert(!journal_find(db, USER, PATH, &entry));
+  assert(journal_remove(db, USER, PATH));
+
+  after(db);
+}
+
+static void test_checksum(char const *data, uint32_t expected) {
+  size_t len = strlen(data);
+  assert(journal_checksum(JOURNAL_CHECKSUM_INIT, data, len) == expected);
+
+  // the checksum rolls: any split of the data adds up to the same one
+  for (size_t i = 0; i <= len; i++) {
+    uint32_t checksum = journal_checksum(JOURNAL_CHECKSUM_INIT, data, i);
+    assert(journal_checksum(checksum, data + i, len - i) == expected);
+  }
+}
+
+static void test_checksum_large(void) {
+  // long enough for the sums to be reduced many times over
+  size_t const len = 1 << 20;
+  unsigned char *data = malloc(len);
+  assert(data);
+  memset(data, 0xff, len);
+
+  assert(journal_checksum(JOURNAL_CHECKSUM_INIT, data, len) == 0x8e88ef11u);
+
+  free(data);
+}
+
+int main(void) {
+  test_round_trip();
+
+  // adler-32 test vectors
+  test_checksum("", JOURNAL_CHECKSUM_INIT);
+  test_checksum("a", 0x00620062u);
+  test_checksum("abc", 0x024d0127u);
+  test_checksum("message digest", 0x29750586u);
+  test_checksum("Wikipedia", 0x11e60398u);
+  test_checksum_large();
+  assert(journal_checksum(0x11e60398u, NULL, 16) == 0x11e60398u);
+}
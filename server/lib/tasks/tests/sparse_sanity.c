@@ -0,0 +1,73 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sparse.h"
+
+static void test_is_zero(void) {
+  char buf[SPARSE_BLOCK_SIZE] = {0};
+
+  assert(sparse_is_zero(buf, 0));
+  assert(sparse_is_zero(buf, 1));
+  assert(sparse_is_zero(buf, sizeof buf));
+
+  // a single byte anywhere tells it apart
+  size_t const positions[] = {0, 1, sizeof buf / 2, sizeof buf - 1};
+  for (size_t i = 0; i < sizeof positions / sizeof *positions; i++) {
+    buf[positions[i]] = 1;
+    assert(!sparse_is_zero(buf, sizeof buf));
+    assert(sparse_is_zero(buf, positions[i]));
+    buf[positions[i]] = 0;
+  }
+}
+
+// writes `data` in chunks of `chunk` bytes & checks it reads back as is. a whole block of zeros must be a hole where
+// the file system reports holes
+static void test_write(char const *data, size_t len, size_t chunk, off_t first_hole) {
+  FILE *file = tmpfile();
+  assert(file);
+  int fd = fileno(file);
+
+  for (size_t offset = 0; offset < len; offset += chunk) {
+    size_t n = len - offset < chunk ? len - offset : chunk;
+    assert(sparse_write(fd, (off_t)offset, data + offset, n));
+    assert(lseek(fd, 0, SEEK_CUR) == (off_t)(offset + n));
+  }
+  assert(ftruncate(fd, (off_t)len) == 0);
+
+  char *read_back = malloc(len);
+  assert(read_back);
+  assert(pread(fd, read_back, len, 0) == (ssize_t)len);
+  assert(memcmp(read_back, data, len) == 0);
+
+  // a file system without holes reports the end of the file
+  off_t hole = lseek(fd, 0, SEEK_HOLE);
+  assert(hole == first_hole || hole == (off_t)len);
+
+  free(read_back);
+  fclose(file);
+}
+
+int main(void) {
+  test_is_zero();
+
+  // given a block of data, two blocks of zeros, a block of data & a run of zeros shorter than a block
+  size_t const len = 4 * SPARSE_BLOCK_SIZE + SPARSE_BLOCK_SIZE / 2;
+  char *data = calloc(len, 1);
+  assert(data);
+  memset(data, 'a', SPARSE_BLOCK_SIZE);
+  memset(data + 3 * SPARSE_BLOCK_SIZE, 'b', SPARSE_BLOCK_SIZE);
+
+  // the zero blocks are skipped no matter how the data is split up
+  test_write(data, len, len, SPARSE_BLOCK_SIZE);
+  test_write(data, len, SPARSE_BLOCK_SIZE, SPARSE_BLOCK_SIZE);
+  test_write(data, len, 1000, SPARSE_BLOCK_SIZE);
+
+  // a zero block which isn't aligned to the file offsets is written out
+  memset(data, 'a', len);
+  memset(data + SPARSE_BLOCK_SIZE / 2, 0, SPARSE_BLOCK_SIZE);
+  test_write(data, len, len, len);
+
+  free(data);
+}
@@ -0,0 +1,65 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "thread_pool.h"
+
+// the amortized cost of adding a task from an external submitter (e.g. the reactor), adding tasks one at a time
+// against adding them in batches of 8 & 64. the tasks themselves do nothing, only the time spent in `tp_add_task` /
+// `tp_add_tasks` is measured
+
+#define TASKS_COUNT (1 << 18)
+#define THREADS_COUNT 16
+
+static atomic_size_t done;
+
+static void handler(void *arg) {
+  (void)arg;
+  atomic_fetch_add_explicit(&done, 1, memory_order_relaxed);
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// returns ns per task
+static double run(enum tp_scheduler scheduler, size_t batch) {
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = THREADS_COUNT,
+                                                                       .scheduler = scheduler,
+                                                                       .ring_capacity = TASKS_COUNT});
+  if (!tp) abort();
+
+  struct task tasks[64];
+  for (size_t i = 0; i < batch; i++) { tasks[i] = (struct task){.handle_task = handler}; }
+
+  atomic_store(&done, 0);
+  double elapsed = 0;
+  for (size_t added = 0; added < TASKS_COUNT; added += batch) {
+    double start = now();
+    size_t ret = batch == 1 ? (size_t)tp_add_task(tp, tasks) : tp_add_tasks(tp, tasks, batch);
+    elapsed += now() - start;
+
+    if (ret != batch) abort();
+  }
+
+  struct timespec remaining = {0};
+  while (atomic_load(&done) != TASKS_COUNT) { nanosleep(&(struct timespec){.tv_nsec = 100 * 1000}, &remaining); }
+
+  tp_destroy(tp);
+  return elapsed * 1e9 / TASKS_COUNT;
+}
+
+int main(void) {
+  enum tp_scheduler schedulers[] = {TP_SCHEDULER_SHARED, TP_SCHEDULER_STEALING, TP_SCHEDULER_RING};
+  char const *names[] = {"shared", "stealing", "ring"};
+  size_t batches[] = {1, 8, 64};
+
+  printf("%-10s %12s %12s %12s\n", "scheduler", "1 ns/task", "8 ns/task", "64 ns/task");
+  for (size_t i = 0; i < sizeof schedulers / sizeof *schedulers; i++) {
+    printf("%-10s", names[i]);
+    for (size_t j = 0; j < sizeof batches / sizeof *batches; j++) { printf(" %12.1f", run(schedulers[i], batches[j])); }
+    printf("\n");
+  }
+}
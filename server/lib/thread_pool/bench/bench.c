@@ -0,0 +1,229 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+#include <unistd.h>
+#include "thread_pool.h"
+
+// the numbers to judge a change to `tp_add_task`, the queues or the wakeups by. every workload runs on every
+// scheduler, for every number of producers & workers. the producers add the tasks one at a time (like the reactor
+// does), each task records the time from being added till it started. prints a CSV line per run:
+// - tasks_per_s: from the first task added till the last one done
+// - add_ns: the mean time a producer spent in `tp_add_task`
+// - p50_ns .. max_ns: the percentiles of the time from a task being added till it started (queueing & wakeup). the
+//   producers add as fast as they can, thus it includes the backlog they build up
+//
+// usage: thread_pool_bench [-n tasks] [-w empty|tiny|mixed] [-s shared|stealing|ring]
+
+#define DEFAULT_COUNT (1 << 16)
+#define MAX_PRODUCERS 4
+#define TINY_SPIN 200            // the work done by a tiny task
+#define MIXED_BLOCKING_EVERY 16  // one task in that many blocks
+#define MIXED_BLOCKING_US 200    // for that long, e.g. a disk read
+
+enum workload {
+  WORKLOAD_EMPTY, /**< tasks which do nothing. the overhead of the pool & nothing else */
+  WORKLOAD_TINY,  /**< tasks which spin for a little while */
+  WORKLOAD_MIXED, /**< tiny tasks, some of which block. the others shouldn't wait for them */
+  WORKLOAD_COUNT,
+};
+
+static char const *const workload_names[WORKLOAD_COUNT] = {"empty", "tiny", "mixed"};
+static char const *const scheduler_names[] = {"shared", "stealing", "ring"};
+static size_t const producers_counts[] = {1, 4};
+static size_t const workers_counts[] = {1, 4, 16};
+
+struct run {
+  struct thread_pool *tp;
+  enum workload workload;
+  size_t count;  // the tasks added by all the producers together
+
+  atomic_size_t next;  // the index of the next task to be added
+  atomic_size_t done;
+  _Atomic uint64_t add_ns;  // the time the producers spent adding tasks, all of them together
+  uint64_t *latencies;      // one per task, in ns
+};
+
+// travels with the task by value (see `tp_task_set_args`)
+struct bench_args {
+  struct run *run;
+  size_t index;
+  uint64_t added_ns;
+};
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000u * 1000u * 1000u + (uint64_t)ts.tv_nsec;
+}
+
+static void spin(void) {
+  for (volatile int i = 0; i < TINY_SPIN; i++) { continue; }
+}
+
+static void handler(void *_args) {
+  struct bench_args *args = _args;
+  struct run *run = args->run;
+
+  uint64_t started_ns = now_ns();
+  run->latencies[args->index] = started_ns > args->added_ns ? started_ns - args->added_ns : 0;
+
+  switch (run->workload) {
+    case WORKLOAD_MIXED:
+      if (args->index % MIXED_BLOCKING_EVERY == 0) {
+        struct timespec remaining = {0};
+        nanosleep(&(struct timespec){.tv_nsec = MIXED_BLOCKING_US * 1000L}, &remaining);
+        break;
+      }
+      // fallthrough
+    case WORKLOAD_TINY:
+      spin();
+      break;
+    default:
+      break;
+  }
+
+  atomic_fetch_add_explicit(&run->done, 1, memory_order_release);
+}
+
+static int produce(void *_run) {
+  struct run *run = _run;
+
+  uint64_t add_ns = 0;
+  size_t index;
+  while ((index = atomic_fetch_add_explicit(&run->next, 1, memory_order_relaxed)) < run->count) {
+    struct task task = {.handle_task = handler};
+    uint64_t start_ns = now_ns();
+    struct bench_args args = {.run = run, .index = index, .added_ns = start_ns};
+    if (!tp_task_set_args(&task, &args, sizeof args)) abort();
+
+    if (!tp_add_task(run->tp, &task)) abort();
+    add_ns += now_ns() - start_ns;
+  }
+
+  atomic_fetch_add_explicit(&run->add_ns, add_ns, memory_order_relaxed);
+  return 0;
+}
+
+static int compare(void const *lhs, void const *rhs) {
+  uint64_t a = *(uint64_t const *)lhs;
+  uint64_t b = *(uint64_t const *)rhs;
+  return (a > b) - (a < b);
+}
+
+// `sorted` holds `count` samples in ascending order
+static uint64_t percentile(uint64_t const *sorted, size_t count, double percentile) {
+  size_t rank = (size_t)(percentile / 100 * (double)count);
+  return sorted[rank < count ? rank : count - 1];
+}
+
+static void bench(enum workload workload, enum tp_scheduler scheduler, size_t producers, size_t workers, size_t count) {
+  struct run run = {.workload = workload, .count = count};
+  atomic_init(&run.next, 0);
+  atomic_init(&run.done, 0);
+  atomic_init(&run.add_ns, 0);
+
+  run.latencies = calloc(count, sizeof *run.latencies);
+  if (!run.latencies) abort();
+
+  // the ring must hold every task, a full ring would measure the overflow policy instead
+  run.tp = tp_create_with_options(
+    &(struct tp_options){.threads_count = workers, .scheduler = scheduler, .ring_capacity = count});
+  if (!run.tp) abort();
+
+  thrd_t threads[MAX_PRODUCERS];
+  if (producers > MAX_PRODUCERS) abort();
+
+  uint64_t start_ns = now_ns();
+  for (size_t i = 0; i < producers; i++) {
+    if (thrd_create(&threads[i], produce, &run) != thrd_success) abort();
+  }
+  for (size_t i = 0; i < producers; i++) { thrd_join(threads[i], NULL); }
+
+  struct timespec remaining = {0};
+  while (atomic_load_explicit(&run.done, memory_order_acquire) != count) {
+    nanosleep(&(struct timespec){.tv_nsec = 50 * 1000}, &remaining);
+  }
+  double elapsed_s = (double)(now_ns() - start_ns) / 1e9;
+
+  tp_destroy(run.tp);
+
+  qsort(run.latencies, count, sizeof *run.latencies, compare);
+  printf("%s,%s,%zu,%zu,%zu,%.0f,%.1f,%llu,%llu,%llu,%llu,%llu\n",
+         workload_names[workload],
+         scheduler_names[scheduler],
+         producers,
+         workers,
+         count,
+         (double)count / elapsed_s,
+         (double)atomic_load(&run.add_ns) / (double)count,
+         (unsigned long long)percentile(run.latencies, count, 50),
+         (unsigned long long)percentile(run.latencies, count, 90),
+         (unsigned long long)percentile(run.latencies, count, 99),
+         (unsigned long long)percentile(run.latencies, count, 99.9),
+         (unsigned long long)run.latencies[count - 1]);
+  fflush(stdout);
+
+  free(run.latencies);
+}
+
+// the index of `name` in `names`. `count` (i.e. none) if it isn't there
+static size_t lookup(char const *const *names, size_t count, char const *name) {
+  for (size_t i = 0; i < count; i++) {
+    if (strcmp(names[i], name) == 0) return i;
+  }
+
+  return count;
+}
+
+int main(int argc, char *argv[]) {
+  size_t const schedulers_count = sizeof scheduler_names / sizeof *scheduler_names;
+
+  size_t count = DEFAULT_COUNT;
+  size_t only_workload = WORKLOAD_COUNT;      // all of them
+  size_t only_scheduler = schedulers_count;  // all of them
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:w:s:")) != -1) {
+    switch (opt) {
+      case 'n':
+        count = strtoull(optarg, NULL, 10);
+        break;
+      case 'w':
+        only_workload = lookup(workload_names, WORKLOAD_COUNT, optarg);
+        if (only_workload == WORKLOAD_COUNT) goto usage;
+        break;
+      case 's':
+        only_scheduler = lookup(scheduler_names, schedulers_count, optarg);
+        if (only_scheduler == schedulers_count) goto usage;
+        break;
+      default:
+        goto usage;
+    }
+  }
+  if (!count) goto usage;
+
+  printf("workload,scheduler,producers,workers,tasks,tasks_per_s,add_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n");
+  for (size_t w = 0; w < WORKLOAD_COUNT; w++) {
+    if (only_workload != WORKLOAD_COUNT && w != only_workload) continue;
+
+    for (size_t s = 0; s < schedulers_count; s++) {
+      if (only_scheduler != schedulers_count && s != only_scheduler) continue;
+
+      for (size_t p = 0; p < sizeof producers_counts / sizeof *producers_counts; p++) {
+        for (size_t t = 0; t < sizeof workers_counts / sizeof *workers_counts; t++) {
+          bench(w, s, producers_counts[p], workers_counts[t], count);
+        }
+      }
+    }
+  }
+
+  return 0;
+
+usage:
+  fprintf(stderr, "usage: %s [-n tasks] [-w empty|tiny|mixed] [-s shared|stealing|ring]\n", argv[0]);
+  return 1;
+}
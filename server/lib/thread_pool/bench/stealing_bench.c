@@ -0,0 +1,122 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "thread_pool.h"
+
+// tasks/second of the shared queue against work stealing at 1 to 64 threads, for 2 workloads:
+// - fan out: a single task spawns a binary tree of tasks from within the pool (recursive decomposition)
+// - flat: the main thread adds every task (an external submitter, e.g. the reactor)
+
+#define FAN_OUT_DEPTH 17  // 2^18 - 1 tasks
+#define FLAT_COUNT (1 << 18)
+#define SPIN 200  // the work done by a single task
+
+struct bench_args {
+  struct thread_pool *tp;
+  unsigned depth;
+  atomic_size_t *done;
+};
+
+static void spin(void) {
+  for (volatile int i = 0; i < SPIN; i++) { continue; }
+}
+
+static void args_destroy(void *_task) {
+  struct task *task = _task;
+
+  free(task->args);
+}
+
+static void fan_out_handler(void *_args) {
+  struct bench_args *args = _args;
+
+  for (int i = 0; args->depth && i < 2; i++) {
+    struct bench_args *child = malloc(sizeof *child);
+    if (!child) abort();
+
+    *child = (struct bench_args){.tp = args->tp, .depth = args->depth - 1, .done = args->done};
+    struct task task = {.args = child, .handle_task = fan_out_handler, .destroy_task = args_destroy};
+    if (!tp_add_task(args->tp, &task)) abort();
+  }
+
+  spin();
+  atomic_fetch_add_explicit(args->done, 1, memory_order_relaxed);
+}
+
+static void flat_handler(void *_args) {
+  struct bench_args *args = _args;
+
+  spin();
+  atomic_fetch_add_explicit(args->done, 1, memory_order_relaxed);
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void wait_for(atomic_size_t *done, size_t expected) {
+  struct timespec remaining = {0};
+  while (atomic_load(done) != expected) { nanosleep(&(struct timespec){.tv_nsec = 100 * 1000}, &remaining); }
+}
+
+static double run(enum tp_scheduler scheduler, uint8_t threads_count, bool fan_out) {
+  struct thread_pool *tp =
+    tp_create_with_options(&(struct tp_options){.threads_count = threads_count, .scheduler = scheduler});
+  if (!tp) abort();
+
+  atomic_size_t done;
+  atomic_init(&done, 0);
+
+  double start = now();
+  size_t expected;
+  if (fan_out) {
+    expected = (2u << FAN_OUT_DEPTH) - 1;
+
+    struct bench_args *root = malloc(sizeof *root);
+    if (!root) abort();
+
+    *root = (struct bench_args){.tp = tp, .depth = FAN_OUT_DEPTH, .done = &done};
+    if (!tp_add_task(tp, &(struct task){.args = root, .handle_task = fan_out_handler, .destroy_task = args_destroy})) {
+      abort();
+    }
+  } else {
+    expected = FLAT_COUNT;
+
+    for (size_t i = 0; i < FLAT_COUNT; i++) {
+      struct bench_args *args = malloc(sizeof *args);
+      if (!args) abort();
+
+      *args = (struct bench_args){.tp = tp, .done = &done};
+      if (!tp_add_task(tp, &(struct task){.args = args, .handle_task = flat_handler, .destroy_task = args_destroy})) {
+        abort();
+      }
+    }
+  }
+
+  wait_for(&done, expected);
+  double elapsed = now() - start;
+
+  tp_destroy(tp);
+  return expected / elapsed;
+}
+
+int main(void) {
+  printf("%-8s %-8s %16s %16s %8s\n", "workload", "threads", "shared tasks/s", "stealing tasks/s", "ratio");
+
+  for (int fan_out = 1; fan_out >= 0; fan_out--) {
+    for (unsigned threads_count = 1; threads_count <= 64; threads_count *= 2) {
+      double shared = run(TP_SCHEDULER_SHARED, threads_count, fan_out);
+      double stealing = run(TP_SCHEDULER_STEALING, threads_count, fan_out);
+
+      printf("%-8s %-8u %16.0f %16.0f %8.2f\n",
+             fan_out ? "fan out" : "flat",
+             threads_count,
+             shared,
+             stealing,
+             stealing / shared);
+    }
+  }
+}
@@ -2,15 +2,52 @@
 /**
  * @file thread_pool.h
  */
+#include <stdalign.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+/**
+ * @brief the priority classes of tasks. every class has its own lane. the threads take tasks from the lanes in
+ * weighted rounds: up to `TP_WEIGHT_INTERACTIVE` interactive tasks, then up to `TP_WEIGHT_BULK` bulk tasks, then up to
+ * `TP_WEIGHT_BACKGROUND` background tasks. a lane with no tasks in it gives its turn away. no lane starves: a task at
+ * the head of any lane waits for no more than a round's worth of tasks from the other lanes (per thread)
+ */
+enum tp_priority {
+  TP_PRIORITY_INTERACTIVE, /**< short tasks someone waits for (e.g. control commands). the default */
+  TP_PRIORITY_BULK,        /**< long running tasks (e.g. transfers) */
+  TP_PRIORITY_BACKGROUND,  /**< tasks no one waits for */
+  TP_PRIORITY_COUNT,
+};
+
+#define TP_WEIGHT_INTERACTIVE 8
+#define TP_WEIGHT_BULK 2
+#define TP_WEIGHT_BACKGROUND 1
+
+/**
+ * @brief the values of `task::node`. a task with a node goes to the threads of said node first
+ * (`TP_PLACEMENT_NODE` only). see `tp_node_of_cpu`
+ */
+#define TP_NODE_ANY 0
+#define TP_NODE(node) ((node) + 1u)
+
+/**
+ * @brief the size of `task::inline_args`. arguments which fit are copied along with the task rather than allocated
+ */
+#define TP_INLINE_ARGS_SIZE 128
+
 /**
  * @struct a task object
  */
 struct task {
-  size_t id;
+  size_t id; /**< identifies the task for `tp_abort_task` & `tp_query_task`. several tasks may share an id. 0 (the
+                default) for a task which is never looked up: such tasks cost nothing to index */
+  enum tp_priority priority;
+  unsigned node; /**< `TP_NODE(n)` if the task's data (e.g. its session's buffers) lives on node `n`. `TP_NODE_ANY`
+                    (the default) otherwise */
+
+  uint64_t added_ns; /**< set by the pool: the time the task was added at (`CLOCK_MONOTONIC`) if it's timed, 0
+                        otherwise. see `tp_options::stats_every` */
 
   void *args; /**< the arguments require to execute the task casted to a `void *`. the argument must live long enough
                  for the task to use it. prefer having the task own `arg` with heap allocation if possible */
@@ -20,31 +57,252 @@ struct task {
   void (*destroy_task)(void *task); /**< the destructor of a task. this destructor is intended to cleanup `task::args`
                                        only! one must not try to `free` the `task` itself in any way. the thread will
                                        call the destructor in this manner: `task::destroy_task(task)` */
+
+  size_t inline_size; /**< the size of the arguments in `inline_args`. 0 if there are none. see `tp_task_set_args` */
+  alignas(max_align_t) unsigned char inline_args[TP_INLINE_ARGS_SIZE];
 };
 
 /**
- * @brief
- * NOTE: the pool uses `SIGUSR1` to signal threads to 'abort' their current task. one must not raise said signal
+ * @brief copies `size` bytes of arguments into `task::inline_args`. the arguments travel with the task by value thus
+ * need no allocation. they move whenever the task does: the handler is passed a pointer to the copy held by the thread
+ * which runs the task, the destructor gets the same copy. one must find them with `tp_task_args` & must not keep
+ * pointers into them
+ *
+ * @param[in] task
+ * @param[in] args
+ * @param[in] size
+ * @return `true` on success
+ * @return `false` if `size` is greater than `TP_INLINE_ARGS_SIZE`. `task` is left as is
  */
+bool tp_task_set_args(struct task *restrict task, void const *restrict args, size_t size);
+
+/**
+ * @brief the arguments of a task: `task::inline_args` if the task has inline arguments, `task::args` otherwise. e.g.
+ * for a destructor to find them
+ *
+ * @param[in] task
+ * @return `void *`
+ */
+void *tp_task_args(struct task *task);
+
 struct thread_pool;
 
 /**
- * @brief creates a thread pool with `threads_count` threads
+ * @brief the way tasks are handed to the threads of a pool
+ */
+enum tp_scheduler {
+  TP_SCHEDULER_SHARED,   /**< all threads take tasks from a single queue guarded by a single mutex (the default) */
+  TP_SCHEDULER_STEALING, /**< every thread owns a deque. a task added by one of the pool's threads goes to its own
+                            deque regardless of its priority, any other task goes to a shared injection queue. idle
+                            threads steal from random threads */
+  TP_SCHEDULER_RING,     /**< all threads take tasks from bounded lock free queues (one per priority). every task
+                            added wakes at most a single idle thread */
+};
+
+/**
+ * @brief what `tp_add_task` does when the queue of a `TP_SCHEDULER_RING` pool is full
+ */
+enum tp_overflow {
+  TP_OVERFLOW_BLOCK, /**< wait for a free slot (the default). a task added by one of the pool's own threads spills
+                        instead, since all of them might be waiting */
+  TP_OVERFLOW_FAIL,  /**< return `false` at once */
+  TP_OVERFLOW_SPILL, /**< put the task into an unbounded queue guarded by a mutex */
+};
+
+/**
+ * @brief the way the threads of a pool are placed on the CPUs
+ */
+enum tp_placement {
+  TP_PLACEMENT_NONE, /**< the threads may run on any of the pool's CPUs (the default) */
+  TP_PLACEMENT_CPU,  /**< every thread is pinned to a single CPU. the threads are spread over the CPUs round robin */
+  TP_PLACEMENT_NODE, /**< the threads are split into a group per NUMA node, spread over the nodes round robin. every
+                        group is pinned to its node's CPUs, takes the tasks of its node first & steals from its own
+                        node first. memory a thread allocates thus stays on its node */
+};
+
+#define TP_RING_CAPACITY 1024
+#define TP_TARGET_WAIT_MS 10
+#define TP_IDLE_COOLDOWN_MS 10000
+#define TP_FIBER_STACK_SIZE (256 * 1024)
+#define TP_SPIN_US 50
+#define TP_STATS_EVERY 16
+#define TP_NAME "tp"
+#define TP_NAME_SIZE 16  // the kernel's limit on a thread's name, the null terminator included
+
+/**
+ * @struct the configuration of a thread pool. zero initialized fields take their defaults
+ */
+struct tp_options {
+  char const *name; /**< names the pool & its threads (e.g. "io:3" in `top -H`). a process may run any number of pools,
+                       e.g. one for short CPU bound tasks & one for calls which may block for long. copied, truncated
+                       to fit `TP_NAME_SIZE` along with the thread's number. `TP_NAME` if `NULL` */
+  size_t threads_count; /**< the number of threads to spawn. the pool never shrinks below it */
+  enum tp_scheduler scheduler;
+
+  size_t max_threads;        /**< the pool grows up to `max_threads` threads while tasks wait for longer than
+                                `target_wait_ms` to be taken. `threads_count` if 0 (i.e. a pool of a fixed size) */
+  unsigned target_wait_ms;   /**< `TP_TARGET_WAIT_MS` if 0 */
+  unsigned idle_cooldown_ms; /**< a thread beyond the first `threads_count` exits once it was idle for that long.
+                                `TP_IDLE_COOLDOWN_MS` if 0 */
+
+  size_t interactive_threads; /**< the number of threads which take `TP_PRIORITY_INTERACTIVE` tasks only. such
+                                 tasks never wait for long running ones to free a thread up. must be less than
+                                 `threads_count` */
+
+  size_t spinning_threads; /**< the number of idle threads which may spin at once, waiting for tasks, before they go to
+                              sleep. a spinning thread takes a task within a fraction of a microsecond, a sleeping one
+                              has to be woken up first (tens of microseconds). every spinning thread burns a CPU for up
+                              to `spin_us` at a time. 0 (the default) - idle threads go to sleep at once */
+  unsigned spin_us; /**< the longest an idle thread spins for. its window shrinks while spinning doesn't pay off & grows
+                       back while it does. `TP_SPIN_US` if 0 */
+
+  size_t ring_capacity; /**< `TP_SCHEDULER_RING` only. the capacity of each lane. rounded up to a power of 2.
+                           `TP_RING_CAPACITY` if 0 */
+  enum tp_overflow overflow; /**< `TP_SCHEDULER_RING` only */
+
+  enum tp_placement placement;
+  char const *cpus; /**< the CPUs the threads may run on, a list in the kernel's format (e.g. "0-3,8"). every CPU the
+                       calling thread may run on if `NULL` */
+
+  bool fibers; /**< every task runs on a fiber of its own: a stack of its own the thread switches to & from. a task
+                  waiting for an fd with `tp_wait_fd` suspends its fiber & the thread goes on with other tasks, thus
+                  a few threads run as many blocked tasks as there are fibers. a fiber stays on the thread which
+                  started it */
+  unsigned stats_every; /**< one task in `stats_every` a thread adds is timed (see `tp_stats`), the rest cost no clock
+                           reads. 1 times every task. `TP_STATS_EVERY` if 0 */
+
+  size_t fiber_stack_size; /**< `fibers` only. rounded up to whole pages. the pages a fiber never touches cost nothing.
+                              `TP_FIBER_STACK_SIZE` if 0 */
+};
+
+/**
+ * @brief creates a thread pool with `threads_count` threads and the default scheduler
  *
  * @param[in] threads_count the number of threads to spawn
  * @return `struct thread_pool`
  */
-struct thread_pool *tp_create(uint8_t threads_count);
+struct thread_pool *tp_create(size_t threads_count);
 
 /**
- * @brief terminates all threads gracefully and destroys a thread pool
+ * @brief creates a thread pool configured by `options`
+ *
+ * @param[in] options
+ * @return `struct thread_pool`
+ */
+struct thread_pool *tp_create_with_options(struct tp_options const *options);
+
+/**
+ * @brief the name of the pool (see `tp_options::name`)
+ *
+ * @param[in] thread_pool
+ * @return `char const *`
+ */
+char const *tp_name(struct thread_pool *thread_pool);
+
+/**
+ * @brief the pool the calling thread belongs to
+ *
+ * @return `struct thread_pool *`
+ * @return `NULL` if the calling thread isn't one of a pool's threads
+ */
+struct thread_pool *tp_current(void);
+
+#define TP_STATS_BUCKETS 40
+
+/**
+ * @struct a histogram of durations. bucket `i` counts the ones in [2^i, 2^(i+1)) ns (the first one 0 & 1 as well), the
+ * last one every longer one (~9 minutes & up)
+ */
+struct tp_histogram {
+  size_t buckets[TP_STATS_BUCKETS];
+  size_t count;
+  uint64_t sum_ns;
+  uint64_t max_ns;
+};
+
+/**
+ * @struct the telemetry of a pool (see `tp_stats`). the counters run from the pool's creation on
+ */
+struct tp_stats {
+  size_t threads;           /**< running right now */
+  size_t taken;             /**< the tasks the threads took, the aborted ones included */
+  size_t queued;            /**< the tasks waiting to be taken right now */
+  size_t queued_max;        /**< the high-water mark of `queued`. sampled by every thread as it takes a timed task,
+                               no more than once per `TP_STATS_SAMPLE_US` */
+  size_t aborted;           /**< the tasks cancelled (see `tp_abort_task`), be it while queued or while running */
+  uint64_t busy_ns;         /**< the time the threads spent on anything but waiting for tasks, i.e. mostly running
+                               them. `busy_ns / (busy_ns + idle_ns)` is the pool's utilization */
+  uint64_t idle_ns;         /**< the time the threads spent waiting (or spinning) for tasks */
+  struct tp_histogram wait; /**< of the timed tasks (see `tp_options::stats_every`): from a task being added till a
+                               thread takes it. tells queueing delays apart from slow tasks */
+  struct tp_histogram run;  /**< of the timed tasks: from a task being taken till it's done with, a fiber's
+                               suspensions included */
+};
+
+#define TP_STATS_SAMPLE_US 1000
+
+/**
+ * @brief takes a snapshot of the telemetry of a pool. every thread keeps its own counters & histograms, a snapshot adds
+ * them up. a timed task costs 3 clock reads, any other one none, a thread going idle 2. thread safe. the counters of
+ * different threads aren't read at the same instant, thus a snapshot taken while tasks complete might be off by those
+ * tasks
+ *
+ * @param[in] thread_pool
+ * @param[out] stats
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool tp_stats(struct thread_pool *restrict thread_pool, struct tp_stats *restrict stats);
+
+/**
+ * @brief an estimate of a percentile of a histogram: the upper bound of the bucket the sample of said rank fell into,
+ * thus within a factor of 2 of the actual sample. never more than `tp_histogram::max_ns`
+ *
+ * @param[in] histogram
+ * @param[in] percentile - in [0, 100]
+ * @return `uint64_t` - in ns. 0 if the histogram is empty
+ */
+uint64_t tp_histogram_percentile(struct tp_histogram const *histogram, double percentile);
+
+/**
+ * @brief the number of threads currently running in the pool
+ *
+ * @param[in] thread_pool
+ * @return `size_t`
+ */
+size_t tp_threads_count(struct thread_pool *thread_pool);
+
+/**
+ * @brief the number of node groups the threads are split into. 1 unless the pool was created with `TP_PLACEMENT_NODE`
+ *
+ * @param[in] thread_pool
+ * @return `size_t`
+ */
+size_t tp_nodes_count(struct thread_pool *thread_pool);
+
+/**
+ * @brief the node group which runs on `cpu`. lets one route a session to the threads next to its data, e.g. the CPU
+ * its socket receives packets on (`SO_INCOMING_CPU`)
+ *
+ * @param[in] thread_pool
+ * @param[in] cpu
+ * @return `unsigned` - a `task::node` value. `TP_NODE_ANY` unless the pool was created with `TP_PLACEMENT_NODE` &
+ * `cpu` is one of its CPUs
+ */
+unsigned tp_node_of_cpu(struct thread_pool *thread_pool, int cpu);
+
+/**
+ * @brief terminates all threads gracefully and destroys a thread pool. the tasks added once it started (e.g. by a
+ * task's destructor) are refused
  *
  * @param[in] thread_pool
  */
 void tp_destroy(struct thread_pool *thread_pool);
 
 /**
- * @brief adds a task to be executes asynchronously
+ * @brief adds a task to be executes asynchronously. with `TP_SCHEDULER_STEALING` tasks added by the pool's own threads
+ * are executed in LIFO order by the adding thread unless stolen by an idle one. tasks added by any other thread are
+ * executed in FIFO order
  *
  * @param[in] thread_pool
  * @param[in] task the task to execute
@@ -54,41 +312,308 @@ void tp_destroy(struct thread_pool *thread_pool);
 bool tp_add_task(struct thread_pool *restrict thread_pool, struct task const *restrict task);
 
 /**
- * @brief aborts a task if said task is currently being executed
+ * @brief adds `count` tasks at once. the pool is synchronized with once for all of them rather than once per task, and
+ * no more threads than `count` are woken up. tasks are added in order. if one of them can't be added neither it nor
+ * the ones after it are
  *
- * NOTE: this function is expensive. the calling thread might block for a long time
- * NOTE: the use of this function impose the following restrictions on the task one wish to abort:
- * 1. any critical section within `task::handle_task` must first call `tp_critical_section_begin` then aquire the mutex
- * / semaphore. `tp_critical_section_end` must be called after exiting said section. failure to comply with this
- * restriction might cause a deadlock
- * 2. any heap allocation within `task::handle_task` which isn't saved into `task::args` in some way - will not be
- * cleaned up.
- * 3. using non signal-safe functions without blocking `SIGUSR1` might cause weird or even undefined behavior. for a
- * list of signal safe functions for linux please refer to https://man7.org/linux/man-pages/man7/signal-safety.7.html.
- * one can call `tp_critical_section_begin` & `tp_critical_section_end` before and after said function call to remedy
- * the issue.
- * 4. `tp_abort_task` is signal-safe & thread safe
+ * @param[in] thread_pool
+ * @param[in] tasks - an array of `count` tasks
+ * @param[in] count
+ * @return `size_t` - the number of tasks added
+ */
+size_t tp_add_tasks(struct thread_pool *restrict thread_pool, struct task const *restrict tasks, size_t count);
+
+/**
+ * @brief adds a task to be executed once `delay_ms` elapsed. the task is added to the pool as is by then (as if by
+ * `tp_add_task`), thus it may wait in the pool a while longer. a task the pool refuses at that point (e.g. a full
+ * `TP_OVERFLOW_FAIL` ring) is destroyed. the timers of a pool are kept by a single thread, started on first use
  *
  * @param[in] thread_pool
- * @param[in] task_id
- * @return true
- * @return false
+ * @param[in] task the task to execute
+ * @param[in] delay_ms
+ * @return `size_t` - the id of the timer, see `tp_cancel_timer`. 0 on failure, the task is left to the caller in that
+ * case
  */
-bool tp_abort_task(struct thread_pool *restrict thread_pool, size_t task_id);
+size_t tp_add_delayed_task(struct thread_pool *restrict thread_pool,
+                           struct task const *restrict task,
+                           unsigned delay_ms);
+
+/**
+ * @brief adds a task to be executed once `delay_ms` elapsed & then every `period_ms` until the timer is cancelled.
+ * `period_ms` is counted from the end of a run (a fixed delay rather than a fixed rate): no two runs ever overlap. a
+ * run which the pool refuses ends the timer. `task::destroy_task` is called once, when the timer ends
+ *
+ * @param[in] thread_pool
+ * @param[in] task the task to execute
+ * @param[in] delay_ms
+ * @param[in] period_ms - must be greater than 0
+ * @return `size_t` - the id of the timer, see `tp_cancel_timer`. 0 on failure, the task is left to the caller in that
+ * case
+ */
+size_t tp_add_periodic_task(struct thread_pool *restrict thread_pool,
+                            struct task const *restrict task,
+                            unsigned delay_ms,
+                            unsigned period_ms);
 
 /**
- * @brief does the necessary work to make a critical section signal safe in regard to `SIGUSR1`
- * NOTE: must be accompanied with a `tp_critical_section_end` call
+ * @brief cancels a timer. a task which isn't due yet is destroyed without being executed. a periodic task which is
+ * running completes its current run & is destroyed right after it. takes O(log n) in the number of timers. thread safe
  *
+ * @param[in] thread_pool
+ * @param[in] timer_id
+ * @return `true` if the timer was cancelled
+ * @return `false` if there's no such timer: its task was added to the pool already (once), it was cancelled already or
+ * it never existed
+ */
+bool tp_cancel_timer(struct thread_pool *thread_pool, size_t timer_id);
+
+/**
+ * @brief a serial executor on top of a pool: the tasks added to a strand run one at a time, in the order they were
+ * added, while the tasks of different strands run in parallel. e.g. one per session, so two commands of a session
+ * never race on it. a strand holds no thread while it has no tasks. its tasks go through the pool as themselves, one at
+ * a time: each keeps its id, priority & node
+ */
+struct tp_strand;
+
+/**
+ * @brief creates a strand on `thread_pool`. the pool must outlive it
+ *
+ * @param[in] thread_pool
+ * @return `struct tp_strand *` - `NULL` on failure
+ */
+struct tp_strand *tp_strand_create(struct thread_pool *thread_pool);
+
+/**
+ * @brief adds a task to run once the tasks added to the strand before it are done (their destructors returned). a task
+ * the pool refuses once its turn comes (e.g. the pool is being destroyed) is destroyed without being executed. thread
+ * safe
+ *
+ * @param[in] strand
+ * @param[in] task the task to execute
  * @return `true` on success
- * @return `false` otherwise
+ * @return `false` if the task couldn't be added. it's left to the caller in that case
+ */
+bool tp_strand_add_task(struct tp_strand *restrict strand, struct task const *restrict task);
+
+/**
+ * @brief releases a strand. the tasks in it still run in order, the strand is freed once they're done. no task may be
+ * added from then on
+ *
+ * @param[in] strand
+ */
+void tp_strand_destroy(struct tp_strand *strand);
+
+/**
+ * @brief the state of a `tp_future`
+ */
+enum tp_future_status {
+  TP_FUTURE_PENDING, /**< the task didn't complete yet */
+  TP_FUTURE_DONE,    /**< the task ran. its destructor was called */
+  TP_FUTURE_DROPPED, /**< the task never ran, the pool was destroyed before any thread took it. its destructor was
+                        called */
+};
+
+/**
+ * @brief a handle to the completion of a task added with `tp_submit`. lets one wait for the task, poll it, or chain
+ * continuations to it. a continuation runs right after the task completes, on the thread which ran it, without being
+ * added to the pool. e.g. "authenticate, then open the home directory, then reply" takes a single thread for as long
+ * as the three steps take & no thread waits in between
+ */
+struct tp_future;
+
+/**
+ * @brief adds a task like `tp_add_task` does & returns a handle to its completion. the task completes once
+ * `task::handle_task`, `task::destroy_task` & the continuations chained to it returned. the handle must be released
+ * with `tp_future_release`
+ *
+ * @param[in] thread_pool
+ * @param[in] task the task to execute
+ * @return `struct tp_future *` - `NULL` if the task couldn't be added. the task is left to the caller in that case
+ */
+struct tp_future *tp_submit(struct thread_pool *restrict thread_pool, struct task const *restrict task);
+
+/**
+ * @brief checks whether the task completed. never blocks
+ *
+ * @param[in] future
+ * @return `enum tp_future_status`
  */
-bool tp_critical_section_begin(void);
+enum tp_future_status tp_future_poll(struct tp_future *future);
 
 /**
- * @brief restore previous state after a `tp_critical_section_begin` call
+ * @brief waits for the task to complete. a pool's own thread must not wait for a task of the same pool: the task
+ * might never be taken. chain a continuation instead
  *
+ * @param[in] future
+ * @return `enum tp_future_status` - `TP_FUTURE_DONE` or `TP_FUTURE_DROPPED`
+ */
+enum tp_future_status tp_future_wait(struct tp_future *future);
+
+/**
+ * @brief chains `continuation` to the task. once the task is done, `continuation->handle_task` is called followed by
+ * `continuation->destroy_task`, on the thread which ran the task, in the order the continuations were chained. a
+ * continuation of a task which is done already runs on the calling thread at once. a continuation of a dropped task
+ * is destroyed without being run. `continuation::id`, `continuation::priority` & `continuation::node` are ignored
+ *
+ * @param[in] future
+ * @param[in] continuation
  * @return `true` on success
+ * @return `false` if the continuation couldn't be chained. it's left to the caller in that case
+ */
+bool tp_future_then(struct tp_future *restrict future, struct task const *restrict continuation);
+
+/**
+ * @brief releases a handle. the task isn't affected by it, nor are its continuations
+ *
+ * @param[in] future
+ */
+void tp_future_release(struct tp_future *future);
+
+/**
+ * @brief cancels the tasks of `task_id`, queued or running. a queued task is dropped: it's destroyed without being
+ * executed once a thread takes it. cancelling a running task is cooperative: the task is never interrupted. it's
+ * flagged as cancelled (see `tp_cancelled`) & the wakeup it registered, if any, is run (see `tp_on_cancel`). the task
+ * is expected to check `tp_cancelled` at its I/O & loop boundaries and return. it releases whatever it holds on its way
+ * out, like on any other failure. takes constant time. thread safe
+ *
+ * tasks of id 0 aren't indexed: only a running one is cancelled, found by going over the threads. one which runs on a
+ * fiber isn't found
+ *
+ * @param[in] thread_pool
+ * @param[in] task_id
+ * @return `true` if a task was found & cancelled
  * @return `false` otherwise
  */
-bool tp_critical_section_end(void);
+bool tp_abort_task(struct thread_pool *restrict thread_pool, size_t task_id);
+
+/**
+ * @brief the state of a task, see `tp_query_task`
+ */
+enum tp_task_state {
+  TP_TASK_UNKNOWN, /**< no such task was added, it's done already, or it was cancelled while queued */
+  TP_TASK_QUEUED,
+  TP_TASK_RUNNING, /**< takes precedence if some tasks of the id are queued & some are running */
+};
+
+/**
+ * @brief looks a task up by its id. takes constant time. the answer may be stale by the time it's returned. thread safe
+ *
+ * @param[in] thread_pool
+ * @param[in] task_id - not 0
+ * @return `enum tp_task_state`
+ */
+enum tp_task_state tp_query_task(struct thread_pool *restrict thread_pool, size_t task_id);
+
+/**
+ * @brief checks whether the task the calling thread executes was cancelled. cheap enough to be called once per
+ * iteration of a data pump
+ *
+ * @return `true` if the task was cancelled
+ * @return `false` otherwise, or if the calling thread isn't one of a pool's threads
+ */
+bool tp_cancelled(void);
+
+/**
+ * @brief the events `tp_wait_fd` waits for
+ */
+enum tp_wait {
+  TP_WAIT_READ = 1 << 0,
+  TP_WAIT_WRITE = 1 << 1,
+};
+
+/**
+ * @brief checks whether the calling task runs on a fiber (see `tp_options::fibers`), i.e. whether `tp_wait_fd`
+ * suspends it rather than block its thread. such a task does its I/O on non blocking fds & waits for them with
+ * `tp_wait_fd`
+ *
+ * @return `true` if the calling task runs on a fiber
+ * @return `false` otherwise
+ */
+bool tp_in_fiber(void);
+
+/**
+ * @brief waits until `fd` is ready for `events` (a mask of `enum tp_wait`), or hung up. a task running on a fiber is
+ * suspended: its thread runs other tasks & resumes it once `fd` is ready. any other thread blocks in `poll`. an fd
+ * which can't be waited for without blocking (e.g. a regular file) is reported ready. a fiber never blocks its thread:
+ * if `fd` can't be registered (e.g. another fiber of the same thread waits for it already) the wait fails & the
+ * caller picks its own fallback. a wakeup registered with
+ * `tp_on_cancel` which shuts `fd` down ends the wait. a task on a fiber must not hold a lock across the wait: the
+ * next task its thread runs might wait for the same lock
+ *
+ * @param[in] fd
+ * @param[in] events
+ * @return `true` once `fd` is ready
+ * @return `false` if the task was cancelled, before or during the wait, or the wait failed
+ */
+bool tp_wait_fd(int fd, unsigned events);
+
+/**
+ * @brief registers a wakeup for the task the calling thread executes. `wake(arg)` is run (once) by the thread which
+ * cancels the task, e.g. to shut down a socket the task is blocked on. replaces the previous wakeup. `NULL` removes it.
+ * the wakeup is removed once the task completes. one must remove it earlier if `arg` goes away before that (e.g. the
+ * socket is closed). `wake` must not call into the pool
+ *
+ * @param[in] wake
+ * @param[in] arg - passed into `wake`
+ * @return `false` if the task was cancelled already (`wake` isn't registered) or the calling thread isn't one of a
+ * pool's threads
+ * @return `true` otherwise
+ */
+bool tp_on_cancel(void (*wake)(void *arg), void *arg);
+
+/**
+ * @brief runs `call(arg)` on one of the threads of `thread_pool` & waits for it to return. lets the tasks of one pool
+ * hand calls which may block for long (e.g. `open` or `fsync` on a stalled mount) to another pool, thus they never hold
+ * up the threads of the first one. a task running on a fiber is suspended meanwhile (see `tp_wait_fd`), any other
+ * caller blocks. a cancelled caller waits for `call` all the same, `call` isn't interrupted. called by one of the
+ * threads of `thread_pool` itself, `call` runs right away on the calling thread
+ *
+ * @param[in] thread_pool
+ * @param[in] call
+ * @param[in] arg - passed into `call`
+ * @return `true` once `call` returned
+ * @return `false` if `call` wasn't run (e.g. the pool is being destroyed)
+ */
+bool tp_run_on(struct thread_pool *restrict thread_pool, void (*call)(void *arg), void *arg);
+
+#define TP_SLAB_CACHE 32 /**< the free objects a thread keeps for itself per slab */
+
+/**
+ * @brief a pool of objects of a single size, e.g. one per type which is allocated & freed per command. every thread
+ * keeps up to `TP_SLAB_CACHE` free objects for itself, thus most allocations & frees take no lock. an object may be
+ * freed by a thread other than the one which allocated it: a thread which has too many hands half of them over to a
+ * shared depot, a thread which has none takes a batch from it. the memory is returned to the system once the slab is
+ * destroyed, not before
+ */
+struct tp_slab;
+
+/**
+ * @brief creates a slab
+ *
+ * @param[in] object_size - rounded up so every object is suitably aligned for any type
+ * @return `struct tp_slab *` - `NULL` on failure
+ */
+struct tp_slab *tp_slab_create(size_t object_size);
+
+/**
+ * @brief allocates an object. thread safe
+ *
+ * @param[in] slab
+ * @return `void *` - an uninitialized object. `NULL` on failure
+ */
+void *tp_slab_alloc(struct tp_slab *slab);
+
+/**
+ * @brief returns an object to the slab it was allocated from. thread safe
+ *
+ * @param[in] slab
+ * @param[in] object - may be `NULL`
+ */
+void tp_slab_free(struct tp_slab *restrict slab, void *restrict object);
+
+/**
+ * @brief destroys a slab along with every object allocated from it. no thread may use it by then
+ *
+ * @param[in] slab
+ */
+void tp_slab_destroy(struct tp_slab *slab);
@@ -0,0 +1,151 @@
+#include "deque.h"
+#include <stdlib.h>
+
+struct deque_array {
+  struct deque_array *next;  // the next retired array
+  size_t capacity;
+  _Atomic(void *) buffer[];
+};
+
+static struct deque_array *array_create(size_t capacity) {
+  struct deque_array *array = malloc(sizeof *array + capacity * sizeof *array->buffer);
+  if (!array) return NULL;
+
+  array->next = NULL;
+  array->capacity = capacity;
+  for (size_t i = 0; i < capacity; i++) { atomic_init(&array->buffer[i], NULL); }
+  return array;
+}
+
+static void *array_get(struct deque_array *array, long idx) {
+  return atomic_load_explicit(&array->buffer[(size_t)idx & (array->capacity - 1)], memory_order_relaxed);
+}
+
+static void array_put(struct deque_array *array, long idx, void *elem) {
+  atomic_store_explicit(&array->buffer[(size_t)idx & (array->capacity - 1)], elem, memory_order_relaxed);
+}
+
+bool deque_init(struct deque *deque, size_t capacity) {
+  if (!deque || !capacity || (capacity & (capacity - 1))) return false;
+
+  struct deque_array *array = array_create(capacity);
+  if (!array) return false;
+
+  atomic_init(&deque->top, 0);
+  atomic_init(&deque->bottom, 0);
+  atomic_init(&deque->array, array);
+  deque->retired = NULL;
+  return true;
+}
+
+void deque_destroy(struct deque *deque, void (*destroy)(void *elem)) {
+  if (!deque) return;
+
+  struct deque_array *array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+  if (!array) return;
+
+  long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+  long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  for (long i = top; destroy && i < bottom; i++) { destroy(array_get(array, i)); }
+
+  free(array);
+  while (deque->retired) {
+    struct deque_array *next = deque->retired->next;
+    free(deque->retired);
+    deque->retired = next;
+  }
+
+  atomic_store_explicit(&deque->array, NULL, memory_order_relaxed);
+}
+
+// copies the live elements into an array twice the size. the old array is retired, a thief may still be reading it
+static struct deque_array *grow(struct deque *deque, struct deque_array *array, long top, long bottom) {
+  struct deque_array *bigger = array_create(array->capacity * 2);
+  if (!bigger) return NULL;
+
+  for (long i = top; i < bottom; i++) { array_put(bigger, i, array_get(array, i)); }
+
+  array->next = deque->retired;
+  deque->retired = array;
+
+  atomic_store_explicit(&deque->array, bigger, memory_order_release);
+  return bigger;
+}
+
+bool deque_push(struct deque *deque, void *elem) {
+  long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+  struct deque_array *array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+
+  if (bottom - top > (long)array->capacity - 1) {
+    array = grow(deque, array, top, bottom);
+    if (!array) return false;
+  }
+
+  array_put(array, bottom, elem);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+  return true;
+}
+
+void *deque_pop(struct deque *deque) {
+  long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  struct deque_array *array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+  atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+  // empty. restore the bottom
+  if (top > bottom) {
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return NULL;
+  }
+
+  void *elem = array_get(array, bottom);
+  if (top < bottom) return elem;
+
+  // the last element. race the thieves for it
+  if (!atomic_compare_exchange_strong_explicit(&deque->top,
+                                               &top,
+                                               top + 1,
+                                               memory_order_seq_cst,
+                                               memory_order_relaxed)) {
+    elem = NULL;
+  }
+
+  atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+  return elem;
+}
+
+enum deque_result deque_steal(struct deque *deque, void **elem) {
+  long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+  if (top >= bottom) return DEQUE_EMPTY;
+
+  struct deque_array *array = atomic_load_explicit(&deque->array, memory_order_acquire);
+  void *stolen = array_get(array, top);
+  if (!atomic_compare_exchange_strong_explicit(&deque->top,
+                                               &top,
+                                               top + 1,
+                                               memory_order_seq_cst,
+                                               memory_order_relaxed)) {
+    return DEQUE_ABORT;
+  }
+
+  *elem = stolen;
+  return DEQUE_OK;
+}
+
+size_t deque_size(struct deque *deque) {
+  long top = atomic_load(&deque->top);
+  long bottom = atomic_load(&deque->bottom);
+  return bottom > top ? (size_t)(bottom - top) : 0;
+}
+
+bool deque_empty(struct deque *deque) {
+  long top = atomic_load(&deque->top);
+  long bottom = atomic_load(&deque->bottom);
+  return bottom <= top;
+}
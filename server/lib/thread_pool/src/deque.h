@@ -0,0 +1,95 @@
+#pragma once
+
+/**
+ * @file deque.h
+ * @brief a Chase-Lev work stealing deque ("Dynamic Circular Work-Stealing Deque", Chase & Lev 2005. the memory orders
+ * follow "Correct and Efficient Work-Stealing for Weak Memory Models", Lê et al. 2013).
+ *
+ * the owner pushes and pops at the bottom without taking any lock. any other thread may steal from the top. the
+ * deque grows as needed. arrays which were outgrown are retired rather than freed since a thief might still be reading
+ * from them. they're released by `deque_destroy`
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct deque_array;
+
+struct deque {
+  atomic_long top;
+  atomic_long bottom;
+  _Atomic(struct deque_array *) array;
+
+  struct deque_array *retired;  // owned by the owner of the deque
+};
+
+enum deque_result {
+  DEQUE_OK,
+  DEQUE_EMPTY,
+  DEQUE_ABORT, /**< lost a race against another thief or the owner. the deque might not be empty */
+};
+
+/**
+ * @brief initializes an empty deque
+ *
+ * @param[out] deque
+ * @param[in] capacity - the initial capacity. must be a power of 2
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool deque_init(struct deque *deque, size_t capacity);
+
+/**
+ * @brief destroys a deque. `destroy` is called for every element left in it. may be `NULL`. no other thread may access
+ * the deque
+ *
+ * @param[in] deque
+ * @param[in] destroy
+ */
+void deque_destroy(struct deque *deque, void (*destroy)(void *elem));
+
+/**
+ * @brief pushes `elem` at the bottom of the deque. may only be called by the owner
+ *
+ * @param[in] deque
+ * @param[in] elem - may not be `NULL`
+ * @return `true` on success
+ * @return `false` if the deque had to grow and failed to
+ */
+bool deque_push(struct deque *deque, void *elem);
+
+/**
+ * @brief pops the element at the bottom of the deque (LIFO). may only be called by the owner
+ *
+ * @param[in] deque
+ * @return `void *` - the element or `NULL` if the deque is empty
+ */
+void *deque_pop(struct deque *deque);
+
+/**
+ * @brief steals the element at the top of the deque (FIFO). may be called by any thread
+ *
+ * @param[in] deque
+ * @param[out] elem - the stolen element. only valid if `DEQUE_OK` was returned
+ * @return `DEQUE_OK` on success, `DEQUE_EMPTY` or `DEQUE_ABORT` otherwise
+ */
+enum deque_result deque_steal(struct deque *deque, void **elem);
+
+/**
+ * @brief the number of elements in the deque. may be stale by the time it's returned
+ *
+ * @param[in] deque
+ * @return `size_t`
+ */
+size_t deque_size(struct deque *deque);
+
+/**
+ * @brief checks whether the deque is empty. the answer may be stale by the time it's returned unless the caller
+ * synchronizes with pushers in some other way. sequentially consistent
+ *
+ * @param[in] deque
+ * @return `true` if the deque is empty
+ * @return `false` otherwise
+ */
+bool deque_empty(struct deque *deque);
@@ -0,0 +1,51 @@
+#include "fiber.h"
+#include <sys/mman.h>
+#include <unistd.h>
+
+static size_t page_size(void) {
+  long size = sysconf(_SC_PAGESIZE);
+  return size > 0 ? (size_t)size : 4096;
+}
+
+bool fiber_init(struct fiber *fiber, size_t stack_size) {
+  if (!fiber || !stack_size) return false;
+
+  size_t page = page_size();
+  size_t size = (stack_size + page - 1) / page * page + page;
+
+  // the stack grows down, the guard page goes at the bottom of the mapping
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK;
+  void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mapping == MAP_FAILED) return false;
+
+  if (mprotect(mapping, page, PROT_NONE) != 0) {
+    (void)munmap(mapping, size);
+    return false;
+  }
+
+  *fiber = (struct fiber){.mapping = mapping, .size = size};
+  return true;
+}
+
+void fiber_destroy(struct fiber *fiber) {
+  if (!fiber || !fiber->mapping) return;
+
+  (void)munmap(fiber->mapping, fiber->size);
+  fiber->mapping = NULL;
+}
+
+bool fiber_reset(struct fiber *fiber, void (*entry)(void)) {
+  if (!fiber || !entry) return false;
+  if (getcontext(&fiber->context) != 0) return false;
+
+  size_t page = page_size();
+  fiber->context.uc_stack.ss_sp = (char *)fiber->mapping + page;
+  fiber->context.uc_stack.ss_size = fiber->size - page;
+  fiber->context.uc_link = NULL;
+  makecontext(&fiber->context, entry, 0);
+  return true;
+}
+
+void fiber_switch(ucontext_t *restrict from, ucontext_t *restrict to) {
+  (void)swapcontext(from, to);
+}
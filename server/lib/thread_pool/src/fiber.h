@@ -0,0 +1,57 @@
+#pragma once
+
+/**
+ * @file fiber.h
+ * @brief a stackful coroutine: a context of its own on a stack of its own. the stack is mapped lazily, thus a fiber
+ * costs the pages it actually touches. the page below the stack is a guard page: a fiber which overflows its stack
+ * faults right away rather than scribbling over a neighbour's memory.
+ *
+ * a fiber is switched to & from explicitly, it's never preempted. `swapcontext` saves & restores the signal mask,
+ * which costs a syscall per switch
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <ucontext.h>
+
+struct fiber {
+  ucontext_t context;
+  void *mapping;  // the stack along with its guard page
+  size_t size;    // of `mapping`
+};
+
+/**
+ * @brief maps a fiber's stack
+ *
+ * @param[out] fiber
+ * @param[in] stack_size - rounded up to whole pages
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool fiber_init(struct fiber *fiber, size_t stack_size);
+
+/**
+ * @brief unmaps a fiber's stack. the fiber mustn't be running nor suspended midway
+ *
+ * @param[in] fiber
+ */
+void fiber_destroy(struct fiber *fiber);
+
+/**
+ * @brief makes the fiber start over at `entry` the next time it's switched to. `entry` must never return, it switches
+ * away once done instead
+ *
+ * @param[in] fiber
+ * @param[in] entry
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool fiber_reset(struct fiber *fiber, void (*entry)(void));
+
+/**
+ * @brief saves the calling context into `from` & switches to `to`. returns once something switches back to `from`
+ *
+ * @param[out] from
+ * @param[in] to
+ */
+void fiber_switch(ucontext_t *restrict from, ucontext_t *restrict to);
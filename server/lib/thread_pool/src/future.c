@@ -0,0 +1,168 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <threads.h>
+#include "thread_pool.h"
+
+struct continuation {
+  struct continuation *next;
+  struct task task;
+};
+
+struct tp_future {
+  atomic_uint refs;  // the submitter's & the pool's
+  _Atomic(enum tp_future_status) status;  // written to only if `mtx` is acquired
+  bool ran;                               // written to by the thread which runs the task only
+
+  mtx_t mtx;
+  cnd_t cnd;
+  struct continuation *continuations;  // the last one chained first. guarded by `mtx`
+
+  struct task task;  // the submitted task
+};
+
+static void run_continuation(struct task *continuation, enum tp_future_status status) {
+  if (status == TP_FUTURE_DONE && continuation->handle_task) continuation->handle_task(tp_task_args(continuation));
+  if (continuation->destroy_task) continuation->destroy_task(continuation);
+}
+
+// the continuations run before the future completes, thus one which waits for it waits for them as well. a
+// continuation chained while they run is run in the next round
+static void complete(struct tp_future *future, enum tp_future_status status) {
+  while (true) {
+    while (mtx_lock(&future->mtx) != thrd_success) { continue; }
+
+    struct continuation *continuations = future->continuations;
+    future->continuations = NULL;
+    if (!continuations) {
+      atomic_store_explicit(&future->status, status, memory_order_release);
+      while (cnd_broadcast(&future->cnd) != thrd_success) { continue; }
+    }
+
+    while (mtx_unlock(&future->mtx) != thrd_success) { continue; }
+    if (!continuations) return;
+
+    // restore the order they were chained in
+    struct continuation *ordered = NULL;
+    while (continuations) {
+      struct continuation *next = continuations->next;
+      continuations->next = ordered;
+      ordered = continuations;
+      continuations = next;
+    }
+
+    while (ordered) {
+      struct continuation *next = ordered->next;
+      run_continuation(&ordered->task, status);
+      free(ordered);
+      ordered = next;
+    }
+  }
+}
+
+static void future_handle_task(void *_future) {
+  struct tp_future *future = _future;
+
+  future->ran = true;
+  if (future->task.handle_task) future->task.handle_task(tp_task_args(&future->task));
+}
+
+// the pool destroys every task, whether it ran or not. thus it's where a future completes
+static void future_destroy_task(void *_task) {
+  struct task *task = _task;
+  struct tp_future *future = task->args;
+
+  if (future->task.destroy_task) future->task.destroy_task(&future->task);
+  complete(future, future->ran ? TP_FUTURE_DONE : TP_FUTURE_DROPPED);
+  tp_future_release(future);
+}
+
+struct tp_future *tp_submit(struct thread_pool *restrict thread_pool, struct task const *restrict task) {
+  if (!thread_pool || !task) return NULL;
+
+  struct tp_future *future = malloc(sizeof *future);
+  if (!future) return NULL;
+
+  if (mtx_init(&future->mtx, mtx_plain) != thrd_success) goto future_cleanup;
+  if (cnd_init(&future->cnd) != thrd_success) goto mtx_cleanup;
+
+  atomic_init(&future->refs, 2);
+  atomic_init(&future->status, TP_FUTURE_PENDING);
+  future->ran = false;
+  future->continuations = NULL;
+  future->task = *task;
+
+  struct task wrapper = {.id = task->id,
+                         .priority = task->priority,
+                         .node = task->node,
+                         .args = future,
+                         .handle_task = future_handle_task,
+                         .destroy_task = future_destroy_task};
+  if (!tp_add_task(thread_pool, &wrapper)) goto cnd_cleanup;
+
+  return future;
+
+cnd_cleanup:
+  cnd_destroy(&future->cnd);
+mtx_cleanup:
+  mtx_destroy(&future->mtx);
+future_cleanup:
+  free(future);
+  return NULL;
+}
+
+enum tp_future_status tp_future_poll(struct tp_future *future) {
+  if (!future) return TP_FUTURE_DROPPED;
+
+  return atomic_load_explicit(&future->status, memory_order_acquire);
+}
+
+enum tp_future_status tp_future_wait(struct tp_future *future) {
+  if (!future) return TP_FUTURE_DROPPED;
+
+  enum tp_future_status status = tp_future_poll(future);
+  if (status != TP_FUTURE_PENDING) return status;
+
+  while (mtx_lock(&future->mtx) != thrd_success) { continue; }
+
+  while ((status = atomic_load_explicit(&future->status, memory_order_relaxed)) == TP_FUTURE_PENDING) {
+    while (cnd_wait(&future->cnd, &future->mtx) != thrd_success) { continue; }
+  }
+
+  while (mtx_unlock(&future->mtx) != thrd_success) { continue; }
+  return status;
+}
+
+bool tp_future_then(struct tp_future *restrict future, struct task const *restrict continuation) {
+  if (!future || !continuation) return false;
+
+  struct continuation *node = malloc(sizeof *node);
+  if (!node) return false;
+
+  node->task = *continuation;
+
+  while (mtx_lock(&future->mtx) != thrd_success) { continue; }
+
+  enum tp_future_status status = atomic_load_explicit(&future->status, memory_order_relaxed);
+  if (status == TP_FUTURE_PENDING) {
+    node->next = future->continuations;
+    future->continuations = node;
+  }
+
+  while (mtx_unlock(&future->mtx) != thrd_success) { continue; }
+
+  if (status == TP_FUTURE_PENDING) return true;
+
+  // completed in the meantime. runs right here
+  run_continuation(&node->task, status);
+  free(node);
+  return true;
+}
+
+void tp_future_release(struct tp_future *future) {
+  if (!future) return;
+  if (atomic_fetch_sub(&future->refs, 1) != 1) return;
+
+  cnd_destroy(&future->cnd);
+  mtx_destroy(&future->mtx);
+  free(future);
+}
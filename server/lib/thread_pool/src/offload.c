@@ -0,0 +1,65 @@
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "thread_pool.h"
+
+struct offload {
+  void (*call)(void *arg);
+  void *arg;
+  bool ran;  // written to by the thread which runs the call only
+  int done;  // an eventfd. written to once the call is done with, whether it ran or not
+};
+
+static void offload_handle_task(void *_offload) {
+  struct offload *offload = _offload;
+
+  offload->call(offload->arg);
+  offload->ran = true;
+}
+
+// the pool destroys every task, whether it ran or not. the caller may return (& `offload` go away) as soon as `done` is
+// written to
+static void offload_destroy_task(void *_task) {
+  struct task *task = _task;
+  struct offload *offload = task->args;
+
+  int done = offload->done;
+  uint64_t one = 1;
+  while (write(done, &one, sizeof one) == -1 && errno == EINTR) { continue; }
+}
+
+// a cancelled task can't be suspended anymore, nor can one whose wait failed. it blocks until the call is done with
+static void wait_done(int done) {
+  bool suspend = true;
+  uint64_t value;
+  while (read(done, &value, sizeof value) != sizeof value) {
+    if (errno == EINTR) continue;
+    if (suspend) {
+      suspend = tp_wait_fd(done, TP_WAIT_READ);
+      continue;
+    }
+
+    (void)poll(&(struct pollfd){.fd = done, .events = POLLIN}, 1, -1);
+  }
+}
+
+bool tp_run_on(struct thread_pool *restrict thread_pool, void (*call)(void *arg), void *arg) {
+  if (!thread_pool || !call) return false;
+
+  // waiting for a thread of its own pool might wait forever, e.g. if every one of them is waiting
+  if (tp_current() == thread_pool) {
+    call(arg);
+    return true;
+  }
+
+  struct offload offload = {.call = call, .arg = arg, .done = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)};
+  if (offload.done < 0) return false;
+
+  struct task task = {.args = &offload, .handle_task = offload_handle_task, .destroy_task = offload_destroy_task};
+  if (tp_add_task(thread_pool, &task)) wait_done(offload.done);
+
+  close(offload.done);
+  return offload.ran;
+}
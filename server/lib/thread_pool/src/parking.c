@@ -0,0 +1,57 @@
+#include "parking.h"
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(atomic_uint) == sizeof(uint32_t), "a futex word must be 32 bits wide");
+
+// returns `false` if `timeout` expired
+static bool futex_wait(atomic_uint *word, unsigned expected, struct timespec const *timeout) {
+  return syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0) == 0 ||
+         errno != ETIMEDOUT;
+}
+
+// returns the number of threads woken up
+static size_t futex_wake(atomic_uint *word, int count) {
+  long ret = syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+  return ret > 0 ? (size_t)ret : 0;
+}
+
+void parking_init(struct parking *lot) {
+  atomic_init(&lot->epoch, 0);
+  atomic_init(&lot->waiters, 0);
+}
+
+bool parking_park(struct parking *lot, bool (*ready)(void *arg), void *arg, struct timespec const *timeout) {
+  atomic_fetch_add(&lot->waiters, 1);
+
+  // an unpark after this load changes `epoch` thus the wait returns at once
+  bool woken = true;
+  unsigned epoch = atomic_load(&lot->epoch);
+  if (!ready || !ready(arg)) woken = futex_wait(&lot->epoch, epoch, timeout);
+
+  atomic_fetch_sub(&lot->waiters, 1);
+  return woken;
+}
+
+size_t parking_unpark_many(struct parking *lot, size_t count) {
+  if (!count) return 0;
+
+  // orders the caller's publication before the load of `waiters`
+  atomic_thread_fence(memory_order_seq_cst);
+  if (!atomic_load(&lot->waiters)) return 0;
+
+  atomic_fetch_add(&lot->epoch, 1);
+  return futex_wake(&lot->epoch, count < INT_MAX ? (int)count : INT_MAX);
+}
+
+void parking_unpark_one(struct parking *lot) {
+  (void)parking_unpark_many(lot, 1);
+}
+
+void parking_unpark_all(struct parking *lot) {
+  (void)parking_unpark_many(lot, INT_MAX);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * @file parking.h
+ * @brief a parking lot for threads waiting on a condition which is published without a lock (e.g. a lock free queue
+ * becoming non empty). built directly on a futex: parking & unparking cost no syscall while nobody waits, and
+ * `parking_unpark_one` wakes a single thread rather than all of them.
+ *
+ * the publisher must make its change visible before calling `parking_unpark_*`. a parked thread checks the condition
+ * after it registered itself as a waiter. one of them is bound to see the other, thus no wakeup is lost
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+struct parking {
+  atomic_uint epoch;    // the futex word. bumped by every unpark so a thread about to wait notices it missed one
+  atomic_uint waiters;  // the number of threads in `parking_park`
+};
+
+/**
+ * @brief initializes an empty parking lot
+ *
+ * @param[out] lot
+ */
+void parking_init(struct parking *lot);
+
+/**
+ * @brief blocks the calling thread until it's unparked unless `ready(arg)` holds. may return spuriously. the caller is
+ * expected to recheck its condition and park again
+ *
+ * @param[in] lot
+ * @param[in] ready - the condition the caller waits for
+ * @param[in] arg - passed into `ready`
+ * @param[in] timeout - the longest time to wait for (relative). `NULL` to wait for as long as it takes
+ * @return `false` if `timeout` expired
+ * @return `true` otherwise
+ */
+bool parking_park(struct parking *lot, bool (*ready)(void *arg), void *arg, struct timespec const *timeout);
+
+/**
+ * @brief wakes a single parked thread, if there's any
+ *
+ * @param[in] lot
+ */
+void parking_unpark_one(struct parking *lot);
+
+/**
+ * @brief wakes up to `count` parked threads
+ *
+ * @param[in] lot
+ * @param[in] count
+ * @return `size_t` - the number of threads woken up
+ */
+size_t parking_unpark_many(struct parking *lot, size_t count);
+
+/**
+ * @brief wakes all parked threads
+ *
+ * @param[in] lot
+ */
+void parking_unpark_all(struct parking *lot);
@@ -0,0 +1,153 @@
+#include "ring.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool ring_init(struct ring *ring, size_t elem_size, size_t capacity) {
+  if (!ring || !elem_size || !capacity || (capacity & (capacity - 1))) return false;
+
+  *ring = (struct ring){.elem_size = elem_size, .mask = capacity - 1};
+  ring->sequences = malloc(capacity * sizeof *ring->sequences);
+  ring->elems = malloc(capacity * elem_size);
+  if (!ring->sequences || !ring->elems) goto ring_cleanup;
+
+  // slot `i` is free for the producer at position `i`
+  for (size_t i = 0; i < capacity; i++) { atomic_init(&ring->sequences[i], i); }
+  atomic_init(&ring->enqueue_pos, 0);
+  atomic_init(&ring->dequeue_pos, 0);
+  return true;
+
+ring_cleanup:
+  free(ring->sequences);
+  free(ring->elems);
+  *ring = (struct ring){0};
+  return false;
+}
+
+void ring_destroy(struct ring *ring, void (*destroy)(void *elem)) {
+  if (!ring || !ring->sequences) return;
+
+  size_t dequeue_pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+  size_t enqueue_pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+  for (size_t pos = dequeue_pos; destroy && pos != enqueue_pos; pos++) {
+    destroy(ring->elems + (pos & ring->mask) * ring->elem_size);
+  }
+
+  free(ring->sequences);
+  free(ring->elems);
+  *ring = (struct ring){0};
+}
+
+bool ring_push(struct ring *restrict ring, void const *restrict elem) {
+  size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+
+  for (;;) {
+    size_t seq = atomic_load_explicit(&ring->sequences[pos & ring->mask], memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+    if (diff == 0) {
+      // the slot is free. claim the position
+      if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos,
+                                                &pos,
+                                                pos + 1,
+                                                memory_order_seq_cst,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;  // the slot still holds the element pushed one lap ago
+    } else {
+      pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    }
+  }
+
+  memcpy(ring->elems + (pos & ring->mask) * ring->elem_size, elem, ring->elem_size);
+  atomic_store_explicit(&ring->sequences[pos & ring->mask], pos + 1, memory_order_release);
+  return true;
+}
+
+size_t ring_push_many(struct ring *restrict ring, void const *restrict elems, size_t count) {
+  size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+  size_t claimed;
+
+  for (;;) {
+    // the number of free slots from `pos` on. a free slot stays free until its position is claimed
+    for (claimed = 0; claimed < count && claimed <= ring->mask; claimed++) {
+      size_t seq = atomic_load_explicit(&ring->sequences[(pos + claimed) & ring->mask], memory_order_acquire);
+      if (seq != pos + claimed) break;
+    }
+
+    if (!claimed) {
+      size_t seq = atomic_load_explicit(&ring->sequences[pos & ring->mask], memory_order_acquire);
+      if ((intptr_t)seq - (intptr_t)pos < 0) return 0;  // full
+
+      pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+      continue;
+    }
+
+    if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos,
+                                              &pos,
+                                              pos + claimed,
+                                              memory_order_seq_cst,
+                                              memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  for (size_t i = 0; i < claimed; i++) {
+    memcpy(ring->elems + ((pos + i) & ring->mask) * ring->elem_size,
+           (unsigned char const *)elems + i * ring->elem_size,
+           ring->elem_size);
+    atomic_store_explicit(&ring->sequences[(pos + i) & ring->mask], pos + i + 1, memory_order_release);
+  }
+
+  return claimed;
+}
+
+bool ring_pop(struct ring *restrict ring, void *restrict elem) {
+  size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+
+  for (;;) {
+    size_t seq = atomic_load_explicit(&ring->sequences[pos & ring->mask], memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+    if (diff == 0) {
+      // the slot holds the element for this position. claim it
+      if (atomic_compare_exchange_weak_explicit(&ring->dequeue_pos,
+                                                &pos,
+                                                pos + 1,
+                                                memory_order_seq_cst,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;  // nothing was pushed into the slot yet
+    } else {
+      pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    }
+  }
+
+  memcpy(elem, ring->elems + (pos & ring->mask) * ring->elem_size, ring->elem_size);
+
+  // free the slot for the producer one lap ahead
+  atomic_store_explicit(&ring->sequences[pos & ring->mask], pos + ring->mask + 1, memory_order_release);
+  return true;
+}
+
+bool ring_empty(struct ring *ring) {
+  size_t dequeue_pos = atomic_load(&ring->dequeue_pos);
+  size_t enqueue_pos = atomic_load(&ring->enqueue_pos);
+  return enqueue_pos == dequeue_pos;
+}
+
+size_t ring_size(struct ring *ring) {
+  size_t dequeue_pos = atomic_load(&ring->dequeue_pos);
+  size_t enqueue_pos = atomic_load(&ring->enqueue_pos);
+  return enqueue_pos - dequeue_pos;
+}
+
+bool ring_full(struct ring *ring) {
+  size_t dequeue_pos = atomic_load(&ring->dequeue_pos);
+  size_t enqueue_pos = atomic_load(&ring->enqueue_pos);
+  return enqueue_pos - dequeue_pos > ring->mask;
+}
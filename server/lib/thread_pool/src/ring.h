@@ -0,0 +1,105 @@
+#pragma once
+
+/**
+ * @file ring.h
+ * @brief a bounded lock free multi producer multi consumer queue ("Bounded MPMC queue", D. Vyukov).
+ *
+ * every slot carries a sequence number which tells whether it's free for the producer at a given position or holds an
+ * element for the consumer at a given position. producers & consumers claim positions with a single CAS each and never
+ * wait on one another unless the ring is full / empty. elements are copied in and out of the ring by value
+ */
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define RING_CACHE_LINE 64
+
+struct ring {
+  size_t elem_size;
+  size_t mask;
+  atomic_size_t *sequences;
+  unsigned char *elems;
+
+  // producers & consumers mustn't share a cache line
+  alignas(RING_CACHE_LINE) atomic_size_t enqueue_pos;
+  alignas(RING_CACHE_LINE) atomic_size_t dequeue_pos;
+};
+
+/**
+ * @brief initializes an empty ring
+ *
+ * @param[out] ring
+ * @param[in] elem_size - the size of a single element
+ * @param[in] capacity - must be a power of 2
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool ring_init(struct ring *ring, size_t elem_size, size_t capacity);
+
+/**
+ * @brief destroys a ring. `destroy` is called for every element left in it. may be `NULL`. no other thread may access
+ * the ring. destroying a zero initialized ring is a no-op
+ *
+ * @param[in] ring
+ * @param[in] destroy
+ */
+void ring_destroy(struct ring *ring, void (*destroy)(void *elem));
+
+/**
+ * @brief copies `elem` into the ring
+ *
+ * @param[in] ring
+ * @param[in] elem
+ * @return `true` on success
+ * @return `false` if the ring is full
+ */
+bool ring_push(struct ring *restrict ring, void const *restrict elem);
+
+/**
+ * @brief copies up to `count` consecutive elements into the ring, claiming their slots at once
+ *
+ * @param[in] ring
+ * @param[in] elems - an array of `count` elements
+ * @param[in] count
+ * @return `size_t` - the number of elements pushed, starting at the first one. less than `count` if the ring got full
+ */
+size_t ring_push_many(struct ring *restrict ring, void const *restrict elems, size_t count);
+
+/**
+ * @brief copies the oldest element out of the ring
+ *
+ * @param[in] ring
+ * @param[out] elem
+ * @return `true` on success
+ * @return `false` if the ring is empty
+ */
+bool ring_pop(struct ring *restrict ring, void *restrict elem);
+
+/**
+ * @brief checks whether the ring is empty. a position which was claimed by a producer counts as taken even if the
+ * element isn't written yet. sequentially consistent
+ *
+ * @param[in] ring
+ * @return `true` if the ring is empty
+ * @return `false` otherwise
+ */
+bool ring_empty(struct ring *ring);
+
+/**
+ * @brief the number of elements in the ring. may be stale by the time it's returned
+ *
+ * @param[in] ring
+ * @return `size_t`
+ */
+size_t ring_size(struct ring *ring);
+
+/**
+ * @brief checks whether the ring is full. sequentially consistent
+ *
+ * @param[in] ring
+ * @return `true` if the ring is full
+ * @return `false` otherwise
+ */
+bool ring_full(struct ring *ring);
@@ -0,0 +1,208 @@
+#include <stdalign.h>
+#include <stdlib.h>
+#include <threads.h>
+#include "thread_pool.h"
+
+#define SLAB_CHUNK 64                   // the objects allocated at once, once the depot ran dry
+#define SLAB_BATCH (TP_SLAB_CACHE / 2)  // the objects a thread trades with the depot at once
+
+struct slab_object {
+  struct slab_object *next;
+};
+
+struct slab_chunk {
+  struct slab_chunk *next;
+  max_align_t objects[];  // `SLAB_CHUNK` objects of `tp_slab::object_size` each
+};
+
+// the free objects a thread keeps for itself. only its own thread touches `head` & `count`
+struct slab_cache {
+  struct slab_cache *next;  // the caches of a slab, one per thread which used it. guarded by `tp_slab::mtx`
+  struct tp_slab *slab;
+  struct slab_object *head;
+  size_t count;
+};
+
+struct tp_slab {
+  size_t object_size;
+  tss_t cache;  // the `struct slab_cache` of the calling thread
+
+  mtx_t mtx;
+  struct slab_object *depot;  // the free objects no thread keeps. guarded by `mtx`
+  struct slab_chunk *chunks;  // guarded by `mtx`
+  struct slab_cache *caches;  // guarded by `mtx`
+};
+
+// moves the first `count` objects of `*head` to the depot. the caller holds `slab->mtx`
+static void depot_put(struct tp_slab *slab, struct slab_object **head, size_t count) {
+  for (size_t i = 0; i < count && *head; i++) {
+    struct slab_object *object = *head;
+    *head = object->next;
+    object->next = slab->depot;
+    slab->depot = object;
+  }
+}
+
+// a thread which exits hands its objects back to the depot
+static void cache_destroy(void *_cache) {
+  struct slab_cache *cache = _cache;
+  struct tp_slab *slab = cache->slab;
+
+  while (mtx_lock(&slab->mtx) != thrd_success) { continue; }
+
+  depot_put(slab, &cache->head, cache->count);
+  for (struct slab_cache **curr = &slab->caches; *curr; curr = &(*curr)->next) {
+    if (*curr == cache) {
+      *curr = cache->next;
+      break;
+    }
+  }
+
+  while (mtx_unlock(&slab->mtx) != thrd_success) { continue; }
+
+  free(cache);
+}
+
+static struct slab_cache *cache_get(struct tp_slab *slab) {
+  struct slab_cache *cache = tss_get(slab->cache);
+  if (cache) return cache;
+
+  cache = malloc(sizeof *cache);
+  if (!cache) return NULL;
+
+  *cache = (struct slab_cache){.slab = slab};
+  if (tss_set(slab->cache, cache) != thrd_success) {
+    free(cache);
+    return NULL;
+  }
+
+  while (mtx_lock(&slab->mtx) != thrd_success) { continue; }
+
+  cache->next = slab->caches;
+  slab->caches = cache;
+
+  while (mtx_unlock(&slab->mtx) != thrd_success) { continue; }
+
+  return cache;
+}
+
+// takes a batch of objects from the depot, carving a new chunk up if it's empty
+static bool cache_refill(struct slab_cache *cache) {
+  struct tp_slab *slab = cache->slab;
+  bool refilled = false;
+
+  while (mtx_lock(&slab->mtx) != thrd_success) { continue; }
+
+  if (!slab->depot) {
+    struct slab_chunk *chunk = malloc(sizeof *chunk + SLAB_CHUNK * slab->object_size);
+    if (!chunk) goto cache_refill_cleanup;
+
+    chunk->next = slab->chunks;
+    slab->chunks = chunk;
+    for (size_t i = 0; i < SLAB_CHUNK; i++) {
+      struct slab_object *object = (struct slab_object *)((unsigned char *)chunk->objects + i * slab->object_size);
+      object->next = slab->depot;
+      slab->depot = object;
+    }
+  }
+
+  for (; cache->count < SLAB_BATCH && slab->depot; cache->count++) {
+    struct slab_object *object = slab->depot;
+    slab->depot = object->next;
+    object->next = cache->head;
+    cache->head = object;
+  }
+  refilled = true;
+
+cache_refill_cleanup:
+  while (mtx_unlock(&slab->mtx) != thrd_success) { continue; }
+
+  return refilled;
+}
+
+struct tp_slab *tp_slab_create(size_t object_size) {
+  if (!object_size) return NULL;
+
+  struct tp_slab *slab = malloc(sizeof *slab);
+  if (!slab) return NULL;
+
+  if (object_size < sizeof(struct slab_object)) object_size = sizeof(struct slab_object);
+  *slab = (struct tp_slab){.object_size = (object_size + alignof(max_align_t) - 1) / alignof(max_align_t) *
+                                          alignof(max_align_t)};
+
+  if (tss_create(&slab->cache, cache_destroy) != thrd_success) goto slab_cleanup;
+  if (mtx_init(&slab->mtx, mtx_plain) != thrd_success) goto tss_cleanup;
+
+  return slab;
+
+tss_cleanup:
+  tss_delete(slab->cache);
+slab_cleanup:
+  free(slab);
+  return NULL;
+}
+
+void *tp_slab_alloc(struct tp_slab *slab) {
+  if (!slab) return NULL;
+
+  struct slab_cache *cache = cache_get(slab);
+  if (!cache) return NULL;
+  if (!cache->head && !cache_refill(cache)) return NULL;
+
+  struct slab_object *object = cache->head;
+  cache->head = object->next;
+  cache->count--;
+  return object;
+}
+
+void tp_slab_free(struct tp_slab *restrict slab, void *restrict _object) {
+  if (!slab || !_object) return;
+
+  struct slab_object *object = _object;
+  struct slab_cache *cache = cache_get(slab);
+  if (!cache) {
+    // no cache to put it in. straight to the depot then
+    while (mtx_lock(&slab->mtx) != thrd_success) { continue; }
+
+    object->next = slab->depot;
+    slab->depot = object;
+
+    while (mtx_unlock(&slab->mtx) != thrd_success) { continue; }
+    return;
+  }
+
+  object->next = cache->head;
+  cache->head = object;
+  if (++cache->count <= TP_SLAB_CACHE) return;
+
+  // e.g. a thread which frees the objects another one allocates. the other one takes them from the depot
+  while (mtx_lock(&slab->mtx) != thrd_success) { continue; }
+
+  depot_put(slab, &cache->head, SLAB_BATCH);
+
+  while (mtx_unlock(&slab->mtx) != thrd_success) { continue; }
+
+  cache->count -= SLAB_BATCH;
+}
+
+void tp_slab_destroy(struct tp_slab *slab) {
+  if (!slab) return;
+
+  // the destructors of the caches won't run once the key is deleted, not even for the threads which are still around
+  tss_delete(slab->cache);
+
+  for (struct slab_cache *cache = slab->caches; cache;) {
+    struct slab_cache *next = cache->next;
+    free(cache);
+    cache = next;
+  }
+
+  for (struct slab_chunk *chunk = slab->chunks; chunk;) {
+    struct slab_chunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+
+  mtx_destroy(&slab->mtx);
+  free(slab);
+}
@@ -0,0 +1,79 @@
+#include "stats.h"
+#include <time.h>
+
+uint64_t stats_now_ns(void) {
+  struct timespec now;
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000u * 1000u * 1000u + (uint64_t)now.tv_nsec;
+}
+
+void stats_bump(_Atomic uint64_t *counter, uint64_t value) {
+  atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+// the index of the most significant bit, i.e. floor(log2(ns)). 0 & 1 share the first bucket
+static unsigned bucket_of(uint64_t ns) {
+  unsigned bucket = ns ? 63u - (unsigned)__builtin_clzll(ns) : 0;
+  return bucket < TP_STATS_BUCKETS ? bucket : TP_STATS_BUCKETS - 1;
+}
+
+void stats_record(struct histogram *histogram, uint64_t ns) {
+  stats_bump(&histogram->buckets[bucket_of(ns)], 1);
+  stats_bump(&histogram->sum_ns, ns);
+  if (ns > atomic_load_explicit(&histogram->max_ns, memory_order_relaxed)) {
+    atomic_store_explicit(&histogram->max_ns, ns, memory_order_relaxed);
+  }
+}
+
+static void histogram_collect(struct histogram *restrict histogram, struct tp_histogram *restrict out) {
+  for (unsigned i = 0; i < TP_STATS_BUCKETS; i++) {
+    size_t count = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+    out->buckets[i] += count;
+    out->count += count;
+  }
+
+  out->sum_ns += atomic_load_explicit(&histogram->sum_ns, memory_order_relaxed);
+
+  uint64_t max_ns = atomic_load_explicit(&histogram->max_ns, memory_order_relaxed);
+  if (max_ns > out->max_ns) out->max_ns = max_ns;
+}
+
+void stats_collect(struct thread_stats *restrict stats, uint64_t now_ns, struct tp_stats *restrict out) {
+  histogram_collect(&stats->wait, &out->wait);
+  histogram_collect(&stats->run, &out->run);
+  out->aborted += atomic_load_explicit(&stats->aborted, memory_order_relaxed);
+
+  // a thread is busy whenever it isn't waiting for tasks. only the waits are timed, they're rare while it's busy
+  uint64_t idle_ns = atomic_load_explicit(&stats->idle_ns, memory_order_relaxed);
+  uint64_t lived_ns = atomic_load_explicit(&stats->lived_ns, memory_order_relaxed);
+  uint64_t started_ns = atomic_load_explicit(&stats->started_ns, memory_order_relaxed);
+  if (started_ns && now_ns > started_ns) lived_ns += now_ns - started_ns;
+
+  out->idle_ns += idle_ns;
+  out->busy_ns += lived_ns > idle_ns ? lived_ns - idle_ns : 0;
+}
+
+uint64_t tp_histogram_percentile(struct tp_histogram const *histogram, double percentile) {
+  if (!histogram || !histogram->count) return 0;
+  if (percentile < 0) percentile = 0;
+  if (percentile > 100) percentile = 100;
+
+  // the rank of the sample, rounded up: the p-th percentile of 10 samples is the 1st for p in (0, 10]
+  double exact = percentile / 100 * (double)histogram->count;
+  size_t rank = (size_t)exact;
+  if (rank < exact || !rank) rank++;
+
+  size_t seen = 0;
+  for (unsigned i = 0; i < TP_STATS_BUCKETS; i++) {
+    seen += histogram->buckets[i];
+    if (seen < rank) continue;
+
+    // the upper bound of the bucket. no sample is longer than the longest one, the last bucket has no bound of its own
+    if (i + 1 == TP_STATS_BUCKETS) break;
+
+    uint64_t bound = (UINT64_C(2) << i) - 1;
+    return bound < histogram->max_ns ? bound : histogram->max_ns;
+  }
+
+  return histogram->max_ns;
+}
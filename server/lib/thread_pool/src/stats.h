@@ -0,0 +1,60 @@
+#pragma once
+
+/**
+ * @file stats.h
+ * @brief the telemetry a thread keeps about the tasks it runs. written to by its own thread only, thus the counters are
+ * bumped with a plain load & store rather than a read-modify-write: a bump costs no more than a cache hit & the threads
+ * never share a line. any thread may read them at any time (see `tp_stats`). a snapshot may thus miss the tasks which
+ * complete while it's taken
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "thread_pool.h"
+
+struct histogram {
+  _Atomic uint64_t buckets[TP_STATS_BUCKETS];
+  _Atomic uint64_t sum_ns;
+  _Atomic uint64_t max_ns;
+};
+
+struct thread_stats {
+  struct histogram wait;  // from the task being added till it's taken
+  struct histogram run;   // from the task being taken till it's done with, a fiber's suspensions included
+  _Atomic uint64_t aborted;
+  _Atomic uint64_t idle_ns;     // waiting for tasks
+  _Atomic uint64_t lived_ns;    // by the threads which ran in the slot & exited
+  _Atomic uint64_t started_ns;  // of the thread running in the slot. 0 if there's none
+};
+
+/**
+ * @brief the current time on the `CLOCK_MONOTONIC` clock
+ *
+ * @return `uint64_t` - in ns
+ */
+uint64_t stats_now_ns(void);
+
+/**
+ * @brief adds `value` to a counter of the calling thread
+ *
+ * @param[in] counter
+ * @param[in] value
+ */
+void stats_bump(_Atomic uint64_t *counter, uint64_t value);
+
+/**
+ * @brief records a duration into a histogram of the calling thread
+ *
+ * @param[in] histogram
+ * @param[in] ns
+ */
+void stats_record(struct histogram *histogram, uint64_t ns);
+
+/**
+ * @brief adds the telemetry of a thread's slot to `out`
+ *
+ * @param[in] stats
+ * @param[in] now_ns - the time the snapshot is taken at
+ * @param[in, out] out
+ */
+void stats_collect(struct thread_stats *restrict stats, uint64_t now_ns, struct tp_stats *restrict out);
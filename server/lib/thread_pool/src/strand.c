@@ -0,0 +1,160 @@
+#include <stdbool.h>
+#include <threads.h>
+#include "thread_pool.h"
+
+struct strand_node {
+  struct strand_node *next;
+  struct tp_strand *strand;
+  struct task task;  // the task as it was added
+};
+
+// a strand hands its tasks to the pool one at a time: the next one is added once the previous one was destroyed. every
+// task thus goes through the pool as itself, with its own id, priority & node. the strand holds no thread while idle
+struct tp_strand {
+  struct thread_pool *pool;
+
+  mtx_t mtx;
+  struct strand_node *head;  // the tasks waiting for their turn. guarded by `mtx`
+  struct strand_node *tail;
+  bool running;   // a task of the strand is in the pool. set as long as `head` isn't empty. guarded by `mtx`
+  bool released;  // `tp_strand_destroy` was called. the strand is freed once it's idle. guarded by `mtx`
+};
+
+// a node per command & a strand per session. both are often freed by a thread other than the one which allocated them.
+// the slabs live as long as the process does
+static struct tp_slab *strands;
+static struct tp_slab *nodes;
+static once_flag slabs_once = ONCE_FLAG_INIT;
+
+static void slabs_create(void) {
+  strands = tp_slab_create(sizeof(struct tp_strand));
+  nodes = tp_slab_create(sizeof(struct strand_node));
+}
+
+static void strand_free(struct tp_strand *strand) {
+  mtx_destroy(&strand->mtx);
+  tp_slab_free(strands, strand);
+}
+
+static void strand_handle_task(void *_node) {
+  struct strand_node *node = _node;
+
+  if (node->task.handle_task) node->task.handle_task(tp_task_args(&node->task));
+}
+
+static void strand_destroy_task(void *_task);
+
+static bool strand_add(struct strand_node *node) {
+  struct task wrapper = {.id = node->task.id,
+                         .priority = node->task.priority,
+                         .node = node->task.node,
+                         .args = node,
+                         .handle_task = strand_handle_task,
+                         .destroy_task = strand_destroy_task};
+  return tp_add_task(node->strand->pool, &wrapper);
+}
+
+static void node_drop(struct strand_node *node) {
+  if (node->task.destroy_task) node->task.destroy_task(&node->task);
+  tp_slab_free(nodes, node);
+}
+
+// hands the next task to the pool. a task the pool refuses (e.g. it's being destroyed) is destroyed without being run,
+// like a refused timer
+static void strand_next(struct tp_strand *strand) {
+  while (true) {
+    while (mtx_lock(&strand->mtx) != thrd_success) { continue; }
+
+    struct strand_node *node = strand->head;
+    if (node) {
+      strand->head = node->next;
+      if (!strand->head) strand->tail = NULL;
+    } else {
+      strand->running = false;
+    }
+    bool released = strand->released;
+
+    while (mtx_unlock(&strand->mtx) != thrd_success) { continue; }
+
+    if (!node) {
+      if (released) strand_free(strand);
+      return;
+    }
+
+    if (strand_add(node)) return;
+    node_drop(node);
+  }
+}
+
+// the pool destroys every task, whether it ran or not. thus it's where the strand moves on
+static void strand_destroy_task(void *_task) {
+  struct task *task = _task;
+  struct strand_node *node = task->args;
+  struct tp_strand *strand = node->strand;
+
+  if (node->task.destroy_task) node->task.destroy_task(&node->task);
+  tp_slab_free(nodes, node);
+
+  strand_next(strand);
+}
+
+struct tp_strand *tp_strand_create(struct thread_pool *thread_pool) {
+  if (!thread_pool) return NULL;
+
+  call_once(&slabs_once, slabs_create);
+  struct tp_strand *strand = tp_slab_alloc(strands);
+  if (!strand) return NULL;
+
+  if (mtx_init(&strand->mtx, mtx_plain) != thrd_success) {
+    tp_slab_free(strands, strand);
+    return NULL;
+  }
+
+  strand->pool = thread_pool;
+  strand->head = strand->tail = NULL;
+  strand->running = strand->released = false;
+  return strand;
+}
+
+bool tp_strand_add_task(struct tp_strand *restrict strand, struct task const *restrict task) {
+  if (!strand || !task) return false;
+
+  struct strand_node *node = tp_slab_alloc(nodes);
+  if (!node) return false;
+
+  *node = (struct strand_node){.strand = strand, .task = *task};
+
+  while (mtx_lock(&strand->mtx) != thrd_success) { continue; }
+
+  bool idle = !strand->running;
+  if (idle) {
+    strand->running = true;
+  } else if (strand->tail) {
+    strand->tail->next = node;
+    strand->tail = node;
+  } else {
+    strand->head = strand->tail = node;
+  }
+
+  while (mtx_unlock(&strand->mtx) != thrd_success) { continue; }
+
+  if (!idle || strand_add(node)) return true;
+
+  // refused. the task is left to the caller, the ones added in the meantime go on without it
+  tp_slab_free(nodes, node);
+  strand_next(strand);
+  return false;
+}
+
+void tp_strand_destroy(struct tp_strand *strand) {
+  if (!strand) return;
+
+  while (mtx_lock(&strand->mtx) != thrd_success) { continue; }
+
+  strand->released = true;
+  bool idle = !strand->running;
+
+  while (mtx_unlock(&strand->mtx) != thrd_success) { continue; }
+
+  if (idle) strand_free(strand);
+}
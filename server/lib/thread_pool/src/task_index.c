@@ -0,0 +1,199 @@
+#include "task_index.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+struct task_record {
+  struct task_record *next;
+  size_t task_id;
+  size_t queued;
+  size_t cancelled;  // the queued tasks which were cancelled. the next ones taken are dropped
+  struct task_index_runner *runners;
+};
+
+// Fibonacci hashing. ids tend to be sequential, the multiplication spreads them over the buckets
+static struct task_index_bucket *bucket_of(struct task_index *index, size_t task_id) {
+  uint64_t hash = (uint64_t)task_id * UINT64_C(11400714819323198485);
+  return &index->buckets[hash >> (64 - TASK_INDEX_BITS)];
+}
+
+static struct task_record *find(struct task_index_bucket *bucket, size_t task_id) {
+  for (struct task_record *curr = bucket->records; curr; curr = curr->next) {
+    if (curr->task_id == task_id) return curr;
+  }
+
+  return NULL;
+}
+
+// removes `record` once there's nothing left in it. keeps a single one around for the next id
+static void release(struct task_index_bucket *bucket, struct task_record *record) {
+  if (record->queued || record->runners) return;
+
+  struct task_record **link = &bucket->records;
+  while (*link != record) { link = &(*link)->next; }
+  *link = record->next;
+
+  if (bucket->spare) {
+    free(record);
+  } else {
+    bucket->spare = record;
+  }
+}
+
+static void lock(struct task_index_bucket *bucket) {
+  while (mtx_lock(&bucket->mtx) != thrd_success) { continue; }
+}
+
+static void unlock(struct task_index_bucket *bucket) {
+  while (mtx_unlock(&bucket->mtx) != thrd_success) { continue; }
+}
+
+bool task_index_init(struct task_index *index) {
+  if (!index) return false;
+
+  index->buckets = calloc(TASK_INDEX_BUCKETS, sizeof *index->buckets);
+  if (!index->buckets) return false;
+
+  for (size_t i = 0; i < TASK_INDEX_BUCKETS; i++) {
+    if (mtx_init(&index->buckets[i].mtx, mtx_plain) == thrd_success) continue;
+
+    while (i--) { mtx_destroy(&index->buckets[i].mtx); }
+    free(index->buckets);
+    index->buckets = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+void task_index_destroy(struct task_index *index) {
+  if (!index || !index->buckets) return;
+
+  for (size_t i = 0; i < TASK_INDEX_BUCKETS; i++) {
+    struct task_index_bucket *bucket = &index->buckets[i];
+    while (bucket->records) {
+      struct task_record *next = bucket->records->next;
+      free(bucket->records);
+      bucket->records = next;
+    }
+
+    free(bucket->spare);
+    mtx_destroy(&bucket->mtx);
+  }
+
+  free(index->buckets);
+  index->buckets = NULL;
+}
+
+bool task_index_queue(struct task_index *index, size_t task_id) {
+  struct task_index_bucket *bucket = bucket_of(index, task_id);
+  lock(bucket);
+
+  struct task_record *record = find(bucket, task_id);
+  if (!record) {
+    record = bucket->spare ? bucket->spare : malloc(sizeof *record);
+    bucket->spare = NULL;
+    if (!record) {
+      unlock(bucket);
+      return false;
+    }
+
+    *record = (struct task_record){.next = bucket->records, .task_id = task_id};
+    bucket->records = record;
+  }
+
+  record->queued++;
+
+  unlock(bucket);
+  return true;
+}
+
+void task_index_unqueue(struct task_index *index, size_t task_id) {
+  struct task_index_bucket *bucket = bucket_of(index, task_id);
+  lock(bucket);
+
+  struct task_record *record = find(bucket, task_id);
+  if (record && record->queued) {
+    record->queued--;
+    if (record->cancelled > record->queued) record->cancelled = record->queued;
+    release(bucket, record);
+  }
+
+  unlock(bucket);
+}
+
+bool task_index_start(struct task_index *index, size_t task_id, struct task_index_runner *runner) {
+  struct task_index_bucket *bucket = bucket_of(index, task_id);
+  lock(bucket);
+
+  bool run = true;
+  struct task_record *record = find(bucket, task_id);
+  if (record && record->queued) {
+    record->queued--;
+    if (record->cancelled) {
+      record->cancelled--;
+      run = false;
+    } else {
+      runner->task_id = task_id;
+      runner->next = record->runners;
+      record->runners = runner;
+    }
+
+    release(bucket, record);
+  }
+
+  unlock(bucket);
+  return run;
+}
+
+void task_index_finish(struct task_index *index, struct task_index_runner *runner) {
+  struct task_index_bucket *bucket = bucket_of(index, runner->task_id);
+  lock(bucket);
+
+  struct task_record *record = find(bucket, runner->task_id);
+  if (record) {
+    struct task_index_runner **link = &record->runners;
+    while (*link && *link != runner) { link = &(*link)->next; }
+    if (*link) *link = runner->next;
+
+    release(bucket, record);
+  }
+
+  runner->next = NULL;
+  unlock(bucket);
+}
+
+bool task_index_cancel(struct task_index *index,
+                       size_t task_id,
+                       bool (*cancel)(struct task_index_runner *runner, void *arg),
+                       void *arg) {
+  struct task_index_bucket *bucket = bucket_of(index, task_id);
+  lock(bucket);
+
+  bool found = false;
+  struct task_record *record = find(bucket, task_id);
+  if (record) {
+    found = record->queued > record->cancelled;
+    record->cancelled = record->queued;
+
+    for (struct task_index_runner *curr = record->runners; curr; curr = curr->next) { found |= cancel(curr, arg); }
+  }
+
+  unlock(bucket);
+  return found;
+}
+
+enum task_index_state task_index_query(struct task_index *index, size_t task_id) {
+  struct task_index_bucket *bucket = bucket_of(index, task_id);
+  lock(bucket);
+
+  enum task_index_state state = TASK_INDEX_NONE;
+  struct task_record *record = find(bucket, task_id);
+  if (record && record->runners) {
+    state = TASK_INDEX_RUNNING;
+  } else if (record && record->queued > record->cancelled) {
+    state = TASK_INDEX_QUEUED;
+  }
+
+  unlock(bucket);
+  return state;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+/**
+ * @file task_index.h
+ * @brief an index from task ids to the tasks of a pool, queued or running. a hash table of `TASK_INDEX_BUCKETS`
+ * buckets with a mutex each, thus threads working on different ids rarely contend.
+ *
+ * a task is counted as queued before it's made visible to the threads, moves to the thread which takes it & leaves the
+ * index once done. several tasks may share an id. queued tasks aren't told apart: cancelling an id cancels every task
+ * queued under it, the next ones taken are dropped
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <threads.h>
+
+#define TASK_INDEX_BITS 10
+#define TASK_INDEX_BUCKETS (1u << TASK_INDEX_BITS)
+
+struct task_record;
+
+/**
+ * @struct a thread running an indexed task. embedded by the thread
+ */
+struct task_index_runner {
+  struct task_index_runner *next;  // the next thread running a task of the same id
+  size_t task_id;
+  void *owner;
+};
+
+struct task_index_bucket {
+  mtx_t mtx;
+  struct task_record *records;
+  struct task_record *spare;  // a record kept around for the next id to spare an allocation
+};
+
+struct task_index {
+  struct task_index_bucket *buckets;
+};
+
+enum task_index_state {
+  TASK_INDEX_NONE,
+  TASK_INDEX_QUEUED,
+  TASK_INDEX_RUNNING,
+};
+
+/**
+ * @brief initializes an empty index
+ *
+ * @param[out] index
+ * @return `true` on success
+ * @return `false` otherwise
+ */
+bool task_index_init(struct task_index *index);
+
+/**
+ * @brief destroys an index, along with whatever is left in it. no other thread may access the index. destroying a
+ * zero initialized index is a no-op
+ *
+ * @param[in] index
+ */
+void task_index_destroy(struct task_index *index);
+
+/**
+ * @brief counts a task as queued. must be called before the task is visible to the threads
+ *
+ * @param[in] index
+ * @param[in] task_id
+ * @return `true` on success
+ * @return `false` if the index failed to grow
+ */
+bool task_index_queue(struct task_index *index, size_t task_id);
+
+/**
+ * @brief undoes `task_index_queue` for a task which wasn't added after all
+ *
+ * @param[in] index
+ * @param[in] task_id
+ */
+void task_index_unqueue(struct task_index *index, size_t task_id);
+
+/**
+ * @brief moves a queued task to `runner`
+ *
+ * @param[in] index
+ * @param[in] task_id
+ * @param[in] runner - the thread which took the task
+ * @return `true` if the task is to run
+ * @return `false` if it was cancelled while queued. it's out of the index & must be dropped
+ */
+bool task_index_start(struct task_index *index, size_t task_id, struct task_index_runner *runner);
+
+/**
+ * @brief removes the task `runner` runs from the index
+ *
+ * @param[in] index
+ * @param[in] runner
+ */
+void task_index_finish(struct task_index *index, struct task_index_runner *runner);
+
+/**
+ * @brief cancels every task of `task_id`: the queued ones are dropped once taken & `cancel(runner, arg)` is called for
+ * every thread running one. `cancel` is called with the bucket's mutex held, it mustn't call into the index
+ *
+ * @param[in] index
+ * @param[in] task_id
+ * @param[in] cancel - returns `true` if it cancelled the task `runner` runs
+ * @param[in] arg - passed into `cancel`
+ * @return `true` if any task was cancelled
+ * @return `false` otherwise
+ */
+bool task_index_cancel(struct task_index *index,
+                       size_t task_id,
+                       bool (*cancel)(struct task_index_runner *runner, void *arg),
+                       void *arg);
+
+/**
+ * @brief the state of the tasks of `task_id`. a running one takes precedence over a queued one. cancelled tasks which
+ * are still queued don't count
+ *
+ * @param[in] index
+ * @param[in] task_id
+ * @return `enum task_index_state`
+ */
+enum task_index_state task_index_query(struct task_index *index, size_t task_id);
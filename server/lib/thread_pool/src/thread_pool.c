@@ -1,42 +1,129 @@
 #include "thread_pool.h"
-#include <setjmp.h>
+#include <sched.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdatomic.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <threads.h>
+#include <time.h>
+#include <unistd.h>
+#include "deque.h"
+#include "fiber.h"
+#include "parking.h"
 #include "queue.h"
+#include "ring.h"
+#include "stats.h"
+#include "task_index.h"
+#include "timers.h"
+#include "topology.h"
 #include "vec.h"
 
-#define INVALID_IDX -1
+#define DEQUE_CAPACITY 256
+#define CONTROLLER_INTERVAL_MS 10
+#define FIBER_EVENTS 64
+#define FIBER_SPARES 64  // the done fibers a thread keeps around at most
+#define SPIN_MIN_NS 1000  // the shortest a spinning thread's window shrinks to
+#define SPIN_CHECKS 64    // the spins between two looks at the clock
+#define SPIN_YIELDS 2     // the times a spinning thread yields its CPU once its window is over, before it parks
+#define STAMP_BATCH 16    // the tasks copied into a ring at once. they're stamped on the way
+
+static unsigned const lane_weights[TP_PRIORITY_COUNT] = {
+  [TP_PRIORITY_INTERACTIVE] = TP_WEIGHT_INTERACTIVE,
+  [TP_PRIORITY_BULK] = TP_WEIGHT_BULK,
+  [TP_PRIORITY_BACKGROUND] = TP_WEIGHT_BACKGROUND,
+};
+
+// the state word of a context: the id of the task it runs along with a few flags. starting & completing a task thus
+// take a single store each, no lock. ids are told apart by their low bits only (all but `STATE_FLAGS`)
+#define STATE_IDLE ((size_t)0)
+#define STATE_BUSY ((size_t)1 << 0)
+#define STATE_CANCELLED ((size_t)1 << 1)
+#define STATE_WAKEUP ((size_t)1 << 2)  // the task registered a wakeup
+#define STATE_FLAGS 3
+#define STATE_OF(task_id) ((size_t)(task_id) << STATE_FLAGS | STATE_BUSY)
+#define STATE_TASK_ID(state) ((size_t)(state) >> STATE_FLAGS)
+
+// the state of the task being run, which others may look at: the thread's own or the one of the fiber the task runs on
+struct task_context {
+  // written to by the thread which runs the context, but for `STATE_CANCELLED`, which a canceller sets
+  atomic_size_t state;
+  struct task_index_runner runner;  // links the context to the indexed task it runs
+  uint64_t started_ns;              // the time the task was taken at. 0 if it isn't timed
+
+  // the task's wakeup (see `tp_on_cancel`). registering one & cancelling a task which has one are rare, thus they
+  // synchronize with a mutex. looked at only if `STATE_WAKEUP` is set
+  struct {
+    mtx_t mtx;
+    void (*wake)(void *arg);
+    void *arg;
+  } wakeup;  // guarded by `wakeup::mtx`
+};
 
-struct context {
-  atomic_int id;
-  uint8_t count;
-  sigjmp_buf *buffers;
+// a task running on a stack of its own. it's bound to the thread which started it up until it's done
+struct task_fiber {
+  struct fiber fiber;
+  struct task_fiber *prev;  // in the thread's suspended fibers
+  struct task_fiber *next;  // in the thread's suspended or spare fibers
+  struct task_context context;
+  struct task task;
+  bool done;
 };
 
 // all elements in this struct shall not be written to unless explicitly stated otherwise
 struct thread_properties {
-  uint8_t id;
+  size_t id;
   atomic_bool terminate;  // may be written to
+  atomic_bool polling;    // waits in `poll_idle`. cleared by whoever wakes the thread up
+
+  // may be written to. `SLOT_RUNNING` is set by whoever starts the thread, `SLOT_EXITED` by the thread itself
+  enum {
+    SLOT_EMPTY,   // no thread was ever started in this slot
+    SLOT_RUNNING,
+    SLOT_EXITED,  // the thread exited & must be joined before the slot is used again
+  } _Atomic status;
+  atomic_size_t taken;  // the number of tasks this thread took. written to by this thread only
+  struct thread_stats stats;  // written to by this thread only. kept over the threads which run in the slot
+  uint64_t sampled_ns;        // the last time this thread sampled the number of queued tasks at
+
+  struct thread_pool *pool;
+  struct deque deque;  // `TP_SCHEDULER_STEALING` only. pushed to & popped from by this thread only, stolen by the rest
+  unsigned seed;       // picks the victims to steal from. may be written to by this thread
+  long spin_ns;        // the thread's spinning window. may be written to by this thread
+
+  size_t node;     // the node group. 0 unless `TP_PLACEMENT_NODE`
+  bool pinned;     // the thread may run on `cpus` only
+  cpu_set_t cpus;
+
+  bool reserved;                         // takes interactive tasks only
+  unsigned credits[TP_PRIORITY_COUNT];  // the tasks left for each lane in the current round. may be written to by this
+                                        // thread
 
   struct {
     mtx_t *mtx;
-    cnd_t *cnd;
-
-    struct queue *queue;  // may be written to if `tasks::mtx` is acquired
+    cnd_t *cnd;  // the condition this thread waits on for tasks
   } tasks;
 
-  struct {
-    mtx_t mtx;
-    size_t task_id;
+  struct task_context own;       // the context of the tasks run on the thread's own stack
+  struct task_context *context;  // the context of the task running right now: `own` or the running fiber's. written to
+                                 // by this thread only
 
-    enum {
-      STATE_IDLE,
-      STATE_BUSY,
-    } value;
-  } state;  // may be written to if `state::mtx` is acquired
+  // `tp_options::fibers` only. written to by this thread only
+  struct {
+    int epoll;                     // the fds the suspended fibers wait for. -1 if the tasks run on the thread's stack
+    int wake;                      // an eventfd in `epoll`, written to to wake the thread up. kept over the threads
+                                   // which run in the slot. -1 if the pool has no fibers
+    ucontext_t loop;               // the thread's loop, switched back to by a fiber once it's done or suspended
+    struct task_fiber *running;    // `NULL` while the loop runs
+    struct task_fiber *suspended;  // waiting for their fds
+    struct task_fiber *spare;      // done, kept around for the next tasks
+    size_t spare_count;
+  } fibers;
 };
 
 struct thread {
@@ -46,35 +133,72 @@ struct thread {
 };
 
 struct thread_pool {
+  char _name[TP_NAME_SIZE];  // names the pool's threads
+  enum tp_scheduler _scheduler;
+  size_t _reserved;  // the threads [0, `_reserved`) take interactive tasks only
+
+  // the pool runs between `_min` & `_max` threads. `_max` slots are allocated up front, the threads in the slots
+  // [`_min`, `_max`) are started by the controller & exit on their own once idle for `_idle_cooldown_ms`
+  size_t _min;
+  size_t _max;
+  bool _elastic;  // `_max > _min`. the controller runs
+  unsigned _target_wait_ms;
+  unsigned _idle_cooldown_ms;
+
+  // idle threads spin for a while before they park. no more than `_spinners` of them at once
+  size_t _spinners;
+  long _spin_ns;            // the longest window
+  atomic_size_t _spinning;  // the number of threads spinning
+  thrd_t _controller;
+  atomic_bool _terminate;
+  atomic_size_t _count;  // the number of threads running
+  atomic_size_t _slots;  // the slots [0, `_slots`) were used at some point. written to by the controller only
+
   mtx_t _tasks_mtx;
   cnd_t _tasks_cnd;
+  cnd_t _reserved_cnd;
+
+  // lets workers tell which lanes have tasks without `_tasks_mtx` & lets submitters wake only as many workers as
+  // needed. written to only if `_tasks_mtx` is acquired
+  atomic_size_t _queued[TP_PRIORITY_COUNT];  // the number of tasks in each of `_tasks`
+  atomic_size_t _sleepers;                   // the number of workers waiting on `_tasks_cnd`
+  atomic_size_t _reserved_sleepers;          // the number of workers waiting on `_reserved_cnd`
+  atomic_size_t _pollers;                    // the number of workers waiting in `poll_idle`, whatever the scheduler
+
+  // `TP_SCHEDULER_RING` only. `_tasks` holds the tasks which spilled over
+  enum tp_overflow _overflow;
+  struct ring _rings[TP_PRIORITY_COUNT];  // ring<task>
+  struct parking _work;                   // idle workers
+  struct parking _reserved_work;          // idle reserved workers
+  struct parking _space;                  // submitters waiting for a free slot
 
   // the vec itself shall not be written to as long as the threads are running thus in this narrow context it can be
-  // assumed to be thread safe. changing its underlying elements (the threads) must be done in a thread safe manner
+  // assumed to be thread safe. changing its underlying elements (the threads) must be done in a thread safe manner.
+  // holds `_max` slots
   struct vec _threads;  // vec<thread>
 
-  struct queue _tasks;  // queue<task>
-};
+  struct queue _tasks[TP_PRIORITY_COUNT];  // queue<task>. one per priority
 
-static struct context global_context;  // IMPORTANT
+  enum tp_placement _placement;
+  struct topology _topology;  // a zeroed one if the threads aren't pinned
 
-static void sig_handler(int signum) {
-  if (signum != SIGUSR1) return;
+  // `TP_PLACEMENT_NODE` on more than a single node only. the tasks of each node, one queue per node & priority (at
+  // `node * TP_PRIORITY_COUNT + lane`). counted in `_queued` as well. guarded by `_tasks_mtx` like `_tasks`
+  size_t _nodes_count;
+  struct queue *_node_tasks;    // queue<task>
+  atomic_size_t *_node_queued;  // the number of tasks in each of `_node_tasks`
 
-  int prev;
-  int idx = atomic_load(&global_context.id);
-  do { prev = idx; } while (!atomic_compare_exchange_weak(&global_context.id, &prev, INVALID_IDX));
+  struct task_index _index;  // the tasks with an id other than 0, queued or running
 
-  if (idx >= 0 && idx < global_context.count) siglongjmp(global_context.buffers[idx], 0);
-}
+  unsigned _stats_every;      // one task in `_stats_every` is timed
+  atomic_size_t _queued_max;  // the high-water mark of the queued tasks. sampled by the threads as they take tasks
 
-static bool thread_block_signal(int signum) {
-  sigset_t sig_to_block;
-  if (sigemptyset(&sig_to_block) != 0) return false;
-  if (sigaddset(&sig_to_block, signum) != 0) return false;
+  size_t _fiber_stack_size;  // 0 unless `tp_options::fibers`
 
-  return pthread_sigmask(SIG_BLOCK, &sig_to_block, NULL) == 0;
-}
+  _Atomic(struct timers *) _timers;  // started along with the first timer. written to only if `_tasks_mtx` is acquired
+};
+
+static thread_local struct thread_properties *current_thread;  // the worker running on this thread. `NULL` otherwise
 
 static bool thread_unblock_signal(int signum) {
   sigset_t sig_to_block;
@@ -92,91 +216,923 @@ static bool process_block_signal(int signum) {
   return sigprocmask(SIG_BLOCK, &sig_to_block, NULL) == 0;
 }
 
-static void update_state(struct thread_properties *properties, int state, size_t task_id) {
-  while (mtx_lock(&properties->state.mtx) != thrd_success) { continue; }
+// runs the wakeup of a cancelled task, once. it can't outlive the task: the task clears it (under the same lock) on its
+// way out
+static void run_wakeup(struct task_context *context) {
+  while (mtx_lock(&context->wakeup.mtx) != thrd_success) { continue; }
 
-  switch (state) {
-    case STATE_BUSY:  // fallthrough
-      properties->state.task_id = task_id;
-    case STATE_IDLE:
-      properties->state.value = state;
-      break;
-    default:
-      break;
+  // the task might have completed in the meantime & the next one registered a wakeup of its own
+  bool cancelled = atomic_load_explicit(&context->state, memory_order_acquire) & STATE_CANCELLED;
+  if (cancelled && context->wakeup.wake) context->wakeup.wake(context->wakeup.arg);
+  context->wakeup.wake = NULL;
+  context->wakeup.arg = NULL;
+
+  while (mtx_unlock(&context->wakeup.mtx) != thrd_success) { continue; }
+}
+
+static void clear_wakeup(struct task_context *context) {
+  while (mtx_lock(&context->wakeup.mtx) != thrd_success) { continue; }
+
+  context->wakeup.wake = NULL;
+  context->wakeup.arg = NULL;
+
+  while (mtx_unlock(&context->wakeup.mtx) != thrd_success) { continue; }
+}
+
+// every task starts out not cancelled & without a wakeup. no one else writes to an idle context's word
+static void start_task(struct task_context *context, size_t task_id) {
+  atomic_store_explicit(&context->state, STATE_OF(task_id), memory_order_release);
+}
+
+// a wakeup never outlives its task. returns the task's last state
+static size_t finish_task(struct task_context *context) {
+  size_t state = atomic_exchange_explicit(&context->state, STATE_IDLE, memory_order_acq_rel);
+  if (state & STATE_WAKEUP) clear_wakeup(context);
+  return state;
+}
+
+// flags the task `context` runs if it's `task_id` & runs its wakeup, if it registered one, on the calling thread
+static bool cancel_running(struct task_context *context, size_t task_id) {
+  // `context` is the calling task's own - don't take any action
+  if (current_thread && context == current_thread->context) return false;
+
+  size_t state = atomic_load_explicit(&context->state, memory_order_acquire);
+  do {
+    if ((state & ~(STATE_CANCELLED | STATE_WAKEUP)) != STATE_OF(task_id)) return false;
+    if (state & STATE_CANCELLED) return true;  // the wakeup runs once
+  } while (!atomic_compare_exchange_weak_explicit(
+    &context->state, &state, state | STATE_CANCELLED, memory_order_acq_rel, memory_order_acquire));
+
+  if (state & STATE_WAKEUP) run_wakeup(context);
+  return true;
+}
+
+static bool cancel_runner(struct task_index_runner *runner, void *arg) {
+  (void)arg;
+  return cancel_running(runner->owner, runner->task_id);
+}
+
+static bool context_init(struct task_context *context) {
+  *context = (struct task_context){.wakeup = {.wake = NULL, .arg = NULL}};
+  context->runner.owner = context;
+  atomic_init(&context->state, STATE_IDLE);
+
+  return mtx_init(&context->wakeup.mtx, mtx_plain) == thrd_success;
+}
+
+static void execute(struct thread_properties *restrict properties,
+                    struct task_context *restrict context,
+                    struct task *task) {
+  struct task_index *index = &properties->pool->_index;
+
+  // update state. the task is moved out of the index's queued ones only once the state was reset, a cancellation from
+  // then on sticks
+  start_task(context, task->id);
+
+  bool indexed = task->id != 0;
+  bool dropped = indexed && !task_index_start(index, task->id, &context->runner);  // cancelled while queued
+
+  // handle the task
+  if (!dropped && task->handle_task) task->handle_task(tp_task_args(task));
+  if (task->destroy_task) task->destroy_task(task);
+
+  // update state
+  if (indexed && !dropped) task_index_finish(index, &context->runner);
+  bool cancelled = finish_task(context) & STATE_CANCELLED;
+
+  if (context->started_ns) stats_record(&properties->stats.run, stats_now_ns() - context->started_ns);
+  if (dropped || cancelled) stats_bump(&properties->stats.aborted, 1);
+}
+
+static void fiber_main(void) {
+  struct thread_properties *properties = current_thread;
+  struct task_fiber *fiber = properties->fibers.running;
+
+  execute(properties, &fiber->context, &fiber->task);
+
+  fiber->done = true;
+  fiber_switch(&fiber->fiber.context, &properties->fibers.loop);
+}
+
+static void fiber_free(struct task_fiber *fiber) {
+  fiber_destroy(&fiber->fiber);
+  mtx_destroy(&fiber->context.wakeup.mtx);
+  free(fiber);
+}
+
+// a spare fiber if there's one, a new one otherwise. `NULL` on failure
+static struct task_fiber *fiber_take(struct thread_properties *properties) {
+  struct task_fiber *fiber = properties->fibers.spare;
+  if (fiber) {
+    properties->fibers.spare = fiber->next;
+    properties->fibers.spare_count--;
+  } else {
+    fiber = malloc(sizeof *fiber);
+    if (!fiber) return NULL;
+
+    if (!fiber_init(&fiber->fiber, properties->pool->_fiber_stack_size)) {
+      free(fiber);
+      return NULL;
+    }
+
+    if (!context_init(&fiber->context)) {
+      fiber_destroy(&fiber->fiber);
+      free(fiber);
+      return NULL;
+    }
   }
 
-  while (mtx_unlock(&properties->state.mtx) != thrd_success) { continue; }
+  fiber->prev = fiber->next = NULL;
+  fiber->done = false;
+  if (fiber_reset(&fiber->fiber, fiber_main)) return fiber;
+
+  fiber_free(fiber);
+  return NULL;
 }
 
-static int thread_launch(void *arg) {
-  thread_block_signal(SIGUSR1);
-  if (!arg) return 1;
+static void fiber_give_back(struct thread_properties *properties, struct task_fiber *fiber) {
+  if (properties->fibers.spare_count >= FIBER_SPARES) {
+    fiber_free(fiber);
+    return;
+  }
+
+  fiber->next = properties->fibers.spare;
+  properties->fibers.spare = fiber;
+  properties->fibers.spare_count++;
+}
+
+// runs `fiber` until it's done or suspends itself
+static void resume(struct thread_properties *properties, struct task_fiber *fiber) {
+  properties->fibers.running = fiber;
+  properties->context = &fiber->context;
+
+  fiber_switch(&properties->fibers.loop, &fiber->fiber.context);
+
+  properties->context = &properties->own;
+  properties->fibers.running = NULL;
+  if (fiber->done) fiber_give_back(properties, fiber);
+}
+
+static void suspend(struct thread_properties *properties, struct task_fiber *fiber) {
+  fiber->prev = NULL;
+  fiber->next = properties->fibers.suspended;
+  if (fiber->next) fiber->next->prev = fiber;
+  properties->fibers.suspended = fiber;
+
+  fiber_switch(&fiber->fiber.context, &properties->fibers.loop);
+}
+
+static void unlink_suspended(struct thread_properties *properties, struct task_fiber *fiber) {
+  if (fiber->prev) {
+    fiber->prev->next = fiber->next;
+  } else {
+    properties->fibers.suspended = fiber->next;
+  }
+  if (fiber->next) fiber->next->prev = fiber->prev;
+
+  fiber->prev = fiber->next = NULL;
+}
+
+// a thread is idle while it waits for tasks. only the waits are timed, thus a busy thread reads the clock for the tasks
+// it times only. `since_ns` is the time the wait started at
+static void idle_until_now(struct thread_properties *properties, uint64_t since_ns) {
+  stats_bump(&properties->stats.idle_ns, stats_now_ns() - since_ns);
+}
+
+// resumes the suspended fibers whose fds are ready. waits for up to `timeout_ms` for one of them (forever if -1) or for
+// the thread to be woken up
+static void poll_fibers(struct thread_properties *properties, int timeout_ms) {
+  if (!properties->fibers.suspended) return;
+
+  struct epoll_event events[FIBER_EVENTS];
+  uint64_t since_ns = timeout_ms ? stats_now_ns() : 0;
+  int count = epoll_wait(properties->fibers.epoll, events, FIBER_EVENTS, timeout_ms);
+  if (timeout_ms) idle_until_now(properties, since_ns);
+  for (int i = 0; i < count; i++) {
+    struct task_fiber *fiber = events[i].data.ptr;
+    if (!fiber) {
+      eventfd_t value;
+      (void)eventfd_read(properties->fibers.wake, &value);
+      continue;
+    }
+
+    unlink_suspended(properties, fiber);
+    resume(properties, fiber);
+  }
+}
+
+// a thread with suspended fibers waits for them & for tasks at once, in `epoll_wait`. a submitter checks `_pollers`
+// after it made its task visible, a poller checks `ready` after it registered itself in `_pollers`. one of them is
+// bound to see the other
+static void poll_idle(struct thread_properties *properties, bool (*ready)(void *arg)) {
+  struct thread_pool *pool = properties->pool;
+  atomic_store(&properties->polling, true);
+  atomic_fetch_add(&pool->_pollers, 1);
+  atomic_thread_fence(memory_order_seq_cst);
+
+  if (!ready(properties)) poll_fibers(properties, -1);
+
+  // a waker which cleared `polling` meanwhile left the eventfd readable. the next poll drains it
+  atomic_store(&properties->polling, false);
+  atomic_fetch_sub(&pool->_pollers, 1);
+}
+
+// wakes up to `count` threads waiting in `poll_idle`, the reserved ones for up to `interactive` of them. returns the
+// number of threads woken up
+static size_t wake_pollers(struct thread_pool *pool, size_t interactive, size_t count) {
+  if (!count || !atomic_load(&pool->_pollers)) return 0;
+
+  size_t woken = 0;
+  for (size_t i = 0; woken < count && i < atomic_load(&pool->_slots); i++) {
+    struct thread *curr = vec_at(&pool->_threads, i);
+    if (curr->properties.reserved && !interactive) continue;
+
+    bool polling = true;
+    if (!atomic_compare_exchange_strong(&curr->properties.polling, &polling, false)) continue;
+
+    (void)eventfd_write(curr->properties.fibers.wake, 1);
+    if (curr->properties.reserved) interactive--;
+    woken++;
+  }
 
-  volatile struct thread_properties *properties = arg;
+  return woken;
+}
+
+// the tasks added but not taken yet
+static size_t backlog(struct thread_pool *pool) {
+  size_t backlog = 0;
+  for (unsigned lane = 0; lane < TP_PRIORITY_COUNT; lane++) {
+    backlog += atomic_load(&pool->_queued[lane]);
+    if (pool->_scheduler == TP_SCHEDULER_RING) backlog += ring_size(&pool->_rings[lane]);
+  }
+
+  for (size_t i = 0; pool->_scheduler == TP_SCHEDULER_STEALING && i < atomic_load(&pool->_slots); i++) {
+    struct thread *curr = vec_at(&pool->_threads, i);
+    backlog += deque_size(&curr->properties.deque);
+  }
+
+  return backlog;
+}
+
+static void note_queued(struct thread_pool *pool, size_t queued) {
+  size_t max = atomic_load_explicit(&pool->_queued_max, memory_order_relaxed);
+  while (queued > max && !atomic_compare_exchange_weak_explicit(
+                           &pool->_queued_max, &max, queued, memory_order_relaxed, memory_order_relaxed)) {
+    continue;
+  }
+}
+
+static void run_task(struct thread_properties *properties, struct task task) {
+  atomic_store_explicit(&properties->taken,
+                        atomic_load_explicit(&properties->taken, memory_order_relaxed) + 1,
+                        memory_order_relaxed);
+
+  // the tasks stamped on their way in are timed (see `tp_options::stats_every`)
+  uint64_t now_ns = task.added_ns ? stats_now_ns() : 0;
+  if (now_ns) stats_record(&properties->stats.wait, now_ns > task.added_ns ? now_ns - task.added_ns : 0);
+
+  // the queue is at its longest just before the threads catch up, i.e. when they take tasks. looking at every queue
+  // costs more than a task though, thus it's done once in a while
+  if (now_ns && now_ns - properties->sampled_ns >= TP_STATS_SAMPLE_US * 1000u) {
+    properties->sampled_ns = now_ns;
+    note_queued(properties->pool, backlog(properties->pool) + 1);
+  }
+
+  // a task which can't get a fiber runs on the thread's stack. it blocks the thread rather than yield
+  struct task_fiber *fiber = properties->fibers.epoll != -1 ? fiber_take(properties) : NULL;
+  if (!fiber) {
+    properties->own.started_ns = now_ns;
+    execute(properties, &properties->own, &task);
+    return;
+  }
+
+  fiber->task = task;
+  fiber->context.started_ns = now_ns;
+  resume(properties, fiber);
+}
+
+static enum tp_priority lane_of(struct task const *task) {
+  return task->priority < TP_PRIORITY_COUNT ? task->priority : TP_PRIORITY_BULK;
+}
+
+static atomic_size_t *sleepers_of(struct thread_properties *properties) {
+  return properties->reserved ? &properties->pool->_reserved_sleepers : &properties->pool->_sleepers;
+}
+
+// the lanes of `_tasks` `properties` may take from which have tasks in them, as a bit mask
+static unsigned queued_lanes(struct thread_properties *properties) {
+  unsigned lanes = 0;
+  for (unsigned lane = 0; lane < TP_PRIORITY_COUNT; lane++) {
+    if (atomic_load(&properties->pool->_queued[lane])) lanes |= 1u << lane;
+  }
+
+  return properties->reserved ? lanes & (1u << TP_PRIORITY_INTERACTIVE) : lanes;
+}
+
+// picks the lane to take the next task from out of `lanes` (a bit mask). every thread serves the lanes in rounds. a
+// lane is served up to its weight in tasks per round, the higher priority lanes first. a lane with tasks in it thus
+// waits for no more than `TP_WEIGHT_INTERACTIVE + TP_WEIGHT_BULK` tasks to be taken before its turn comes
+static unsigned pick_lane(struct thread_properties *properties, unsigned lanes) {
+  for (;;) {
+    for (unsigned lane = 0; lane < TP_PRIORITY_COUNT; lane++) {
+      if ((lanes & (1u << lane)) && properties->credits[lane]) {
+        properties->credits[lane]--;
+        return lane;
+      }
+    }
+
+    // every lane with tasks in it had its turn. start a new round
+    memcpy(properties->credits, lane_weights, sizeof properties->credits);
+  }
+}
+
+// the threads started by the controller exit once idle for long enough, as long as the pool doesn't shrink below `_min`
+static bool retire(struct thread_properties *properties) {
+  struct thread_pool *pool = properties->pool;
+  if (!pool->_elastic || properties->reserved) return false;
+
+  size_t count = atomic_load(&pool->_count);
+  do {
+    if (count <= pool->_min) return false;
+  } while (!atomic_compare_exchange_weak(&pool->_count, &count, count - 1));
+
+  return true;
+}
+
+static bool may_retire(struct thread_properties *properties) {
+  return properties->pool->_elastic && !properties->reserved;
+}
+
+static struct timespec cooldown(struct thread_pool *pool) {
+  return (struct timespec){.tv_sec = pool->_idle_cooldown_ms / 1000,
+                           .tv_nsec = (pool->_idle_cooldown_ms % 1000) * 1000L * 1000L};
+}
+
+static void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+static long elapsed_ns(struct timespec const *since) {
+  struct timespec now;
+  (void)clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - since->tv_sec) * 1000L * 1000L * 1000L + (now.tv_nsec - since->tv_nsec);
+}
+
+// an idle thread spins on `ready(properties)` before it parks, then yields its CPU a few times. a task added meanwhile
+// is taken within a fraction of a microsecond rather than after a wakeup & a trip through the scheduler. the window
+// adapts to the thread's load: it doubles (up to `_spin_ns`) whenever spinning paid off & halves whenever it didn't.
+// returns `true` if `ready` held
+static bool idle_spin(struct thread_properties *properties, bool (*ready)(void *arg)) {
+  struct thread_pool *pool = properties->pool;
+  if (!pool->_spinners || properties->fibers.suspended) return false;
+
+  size_t spinning = atomic_load(&pool->_spinning);
+  do {
+    if (spinning >= pool->_spinners) return false;
+  } while (!atomic_compare_exchange_weak(&pool->_spinning, &spinning, spinning + 1));
+
+  struct timespec start;
+  (void)clock_gettime(CLOCK_MONOTONIC, &start);
+  uint64_t since_ns = (uint64_t)start.tv_sec * 1000u * 1000u * 1000u + (uint64_t)start.tv_nsec;
+
+  bool found = false;
+  for (unsigned i = 1; !(found = ready(properties)); i++) {
+    cpu_relax();
+    if (i % SPIN_CHECKS == 0 && elapsed_ns(&start) >= properties->spin_ns) break;
+  }
+
+  for (unsigned i = 0; !found && i < SPIN_YIELDS; i++) {
+    thrd_yield();
+    found = ready(properties);
+  }
+
+  atomic_fetch_sub(&pool->_spinning, 1);
+  idle_until_now(properties, since_ns);
+
+  if (found) {
+    properties->spin_ns = properties->spin_ns < pool->_spin_ns / 2 ? properties->spin_ns * 2 : pool->_spin_ns;
+  } else {
+    properties->spin_ns = properties->spin_ns > SPIN_MIN_NS * 2 ? properties->spin_ns / 2 : SPIN_MIN_NS;
+  }
+
+  return found;
+}
+
+// waits on `tasks::cnd`. returns `false` if the thread was idle for `_idle_cooldown_ms` & may retire
+static bool idle_wait(struct thread_properties *properties) {
+  uint64_t since_ns = stats_now_ns();
+  if (!may_retire(properties)) {
+    while (cnd_wait(properties->tasks.cnd, properties->tasks.mtx) != thrd_success) { continue; }
+    idle_until_now(properties, since_ns);
+    return true;
+  }
+
+  struct timespec deadline;
+  (void)timespec_get(&deadline, TIME_UTC);
+
+  struct timespec idle = cooldown(properties->pool);
+  deadline.tv_sec += idle.tv_sec;
+  deadline.tv_nsec += idle.tv_nsec;
+  if (deadline.tv_nsec >= 1000L * 1000L * 1000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000L * 1000L * 1000L;
+  }
+
+  int ret;
+  while ((ret = cnd_timedwait(properties->tasks.cnd, properties->tasks.mtx, &deadline)) == thrd_error) { continue; }
+  idle_until_now(properties, since_ns);
+  return ret != thrd_timedout;
+}
+
+// takes a task of `node` out of `lane`. `_tasks_mtx` must be held
+static bool dequeue_node(struct thread_pool *pool, size_t node, unsigned lane, struct task *task) {
+  size_t idx = node * TP_PRIORITY_COUNT + lane;
+  if (!atomic_load(&pool->_node_queued[idx])) return false;
+  if (queue_dequeue(&pool->_node_tasks[idx], task) != DS_VALUE_OK) return false;
+
+  atomic_fetch_sub(&pool->_node_queued[idx], 1);
+  return true;
+}
+
+// takes the next task out of `lane` for a thread of `node`: the tasks of its own node first, then the ones of no node
+// in particular, then the ones of the other nodes. `_tasks_mtx` must be held
+static bool dequeue(struct thread_pool *pool, size_t node, unsigned lane, struct task *task) {
+  size_t nodes = pool->_nodes_count > 1 ? pool->_nodes_count : 0;
+
+  bool taken = nodes && dequeue_node(pool, node, lane, task);
+  if (!taken) taken = queue_dequeue(&pool->_tasks[lane], task) == DS_VALUE_OK;
+  for (size_t i = 1; !taken && i < nodes; i++) { taken = dequeue_node(pool, (node + i) % nodes, lane, task); }
+
+  if (taken) atomic_fetch_sub(&pool->_queued[lane], 1);
+  return taken;
+}
+
+static bool shared_ready(void *_properties) {
+  struct thread_properties *properties = _properties;
+
+  return atomic_load(&properties->terminate) || queued_lanes(properties);
+}
+
+static void shared_loop(struct thread_properties *properties) {
+  struct thread_pool *pool = properties->pool;
 
   // as long as the thread shouldn't terminate
   while (!atomic_load(&properties->terminate)) {
+    poll_fibers(properties, 0);
+    if (!queued_lanes(properties)) (void)idle_spin(properties, shared_ready);
+
     // try to get a task
     while (mtx_lock(properties->tasks.mtx) != thrd_success) { continue; }
 
-    // there are no tasks. release the lock and wait
-    while (queue_empty(properties->tasks.queue)) {
-      while (cnd_wait(properties->tasks.cnd, properties->tasks.mtx) != thrd_success) { continue; }
-
-      // woken up but should terminate - release lock & terminate
+    // there are no tasks. release the lock and wait. `terminate` is checked again under the lock, it might have been
+    // set (& the broadcast sent) right after the check above
+    unsigned lanes;
+    while (!(lanes = queued_lanes(properties))) {
       if (atomic_load(&properties->terminate)) {
         while (mtx_unlock(properties->tasks.mtx) != thrd_success) { continue; }
 
-        goto thread_exit;
+        return;
       }
+
+      // the suspended fibers are waited for without the lock
+      if (properties->fibers.suspended) break;
+
+      atomic_fetch_add(sleepers_of(properties), 1);
+      bool woken = idle_wait(properties);
+      atomic_fetch_sub(sleepers_of(properties), 1);
+
+      // woken up but should terminate or idle for too long - release lock & terminate
+      if (atomic_load(&properties->terminate) || (!woken && !queued_lanes(properties) && retire(properties))) {
+        while (mtx_unlock(properties->tasks.mtx) != thrd_success) { continue; }
+
+        return;
+      }
+    }
+
+    if (!lanes) {
+      while (mtx_unlock(properties->tasks.mtx) != thrd_success) { continue; }
+
+      poll_idle(properties, shared_ready);
+      continue;
     }
 
     // get a task & release the lock
+    unsigned lane = pick_lane(properties, lanes);
     struct task task = {0};
-    enum ds_error ret = queue_dequeue(properties->tasks.queue, &task);
+    bool taken = dequeue(pool, properties->node, lane, &task);
 
     while (mtx_unlock(properties->tasks.mtx) != thrd_success) { continue; }
 
-    // if (!task) continue;
-    if (ret != DS_VALUE_OK) continue;
+    if (!taken) continue;
+
+    run_task(properties, task);
+  }
+}
 
-    // update state
-    update_state((struct thread_properties *)properties, STATE_BUSY, task.id);
-    thread_unblock_signal(SIGUSR1);
+// `TP_SCHEDULER_STEALING` only. the deques hold pointers, the tasks pushed onto them live in these nodes. a node is
+// often freed by the thread which stole it rather than the one which pushed it. lives as long as the process does
+static struct tp_slab *task_nodes;
+static once_flag task_nodes_once = ONCE_FLAG_INIT;
 
-    // handle the task
-    if (sigsetjmp(global_context.buffers[properties->id], 1) == 0) {
-      if (task.handle_task) task.handle_task(task.args);
+static void task_nodes_create(void) {
+  task_nodes = tp_slab_create(sizeof(struct task));
+}
+
+static void task_node_destroy(void *_node) {
+  struct task *node = _node;
+
+  if (node->destroy_task) node->destroy_task(node);
+  tp_slab_free(task_nodes, node);
+}
+
+static bool take_node(struct task *node, struct task *task) {
+  if (!node) return false;
+
+  *task = *node;
+  tp_slab_free(task_nodes, node);
+  return true;
+}
+
+static bool take_queued(struct thread_properties *properties, unsigned lane, struct task *task) {
+  struct thread_pool *pool = properties->pool;
+  if (!atomic_load(&pool->_queued[lane])) return false;
+
+  while (mtx_lock(&pool->_tasks_mtx) != thrd_success) { continue; }
+
+  bool taken = dequeue(pool, properties->node, lane, task);
+
+  while (mtx_unlock(&pool->_tasks_mtx) != thrd_success) { continue; }
+  return taken;
+}
+
+static bool take_injected(struct thread_properties *properties, struct task *task) {
+  unsigned lanes = queued_lanes(properties);
+
+  return lanes && take_queued(properties, pick_lane(properties, lanes), task);
+}
+
+static unsigned xorshift(unsigned *seed) {
+  unsigned x = *seed;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *seed = x;
+}
+
+// tries every other worker once, starting at a random one. the workers of the same node group first, if the threads
+// are split into groups. `contended` is set if a steal lost a race, in which case there might be tasks left to steal.
+// reserved threads don't steal, the tasks in the deques aren't interactive ones
+static bool steal(struct thread_properties *properties, struct task *task, bool *contended) {
+  *contended = false;
+  if (properties->reserved) return false;
+
+  struct vec *threads = &properties->pool->_threads;
+  size_t count = atomic_load(&properties->pool->_slots);
+  size_t start = xorshift(&properties->seed) % count;
+  bool grouped = properties->pool->_nodes_count > 1;
+
+  for (int pass = grouped ? 0 : 1; pass < 2; pass++) {
+    for (size_t i = 0; i < count; i++) {
+      struct thread *victim = vec_at(threads, (start + i) % count);
+      if (&victim->properties == properties) continue;
+      if (grouped && (victim->properties.node == properties->node) != (pass == 0)) continue;
+
+      void *node = NULL;
+      switch (deque_steal(&victim->properties.deque, &node)) {
+        case DEQUE_OK:
+          return take_node(node, task);
+        case DEQUE_ABORT:
+          *contended = true;
+          break;
+        default:
+          break;
+      }
     }
+  }
+
+  return false;
+}
 
-    if (task.destroy_task) task.destroy_task(&task);
+static bool has_work(struct thread_properties *properties) {
+  if (queued_lanes(properties)) return true;
+  if (properties->reserved) return false;
 
-    // update state
-    update_state((struct thread_properties *)properties, STATE_IDLE, 0);
+  struct thread_pool *pool = properties->pool;
+  for (size_t i = 0; i < atomic_load(&pool->_slots); i++) {
+    struct thread *curr = vec_at(&pool->_threads, i);
+    if (!deque_empty(&curr->properties.deque)) return true;
+  }
+
+  return false;
+}
+
+// waits until there might be work. a submitter checks `_sleepers` after it made its task visible, a sleeper checks for
+// work after it registered itself in `_sleepers`. one of them is bound to see the other. returns `true` if the thread
+// retired
+static bool wait_for_work(struct thread_properties *properties) {
+  while (mtx_lock(properties->tasks.mtx) != thrd_success) { continue; }
+  atomic_fetch_add(sleepers_of(properties), 1);
+
+  bool woken = true;
+  while (woken && !atomic_load(&properties->terminate) && !has_work(properties)) { woken = idle_wait(properties); }
+
+  atomic_fetch_sub(sleepers_of(properties), 1);
+  bool retired = !woken && !has_work(properties) && retire(properties);
+
+  while (mtx_unlock(properties->tasks.mtx) != thrd_success) { continue; }
+  return retired;
+}
+
+static bool stealing_ready(void *_properties) {
+  struct thread_properties *properties = _properties;
+
+  return atomic_load(&properties->terminate) || has_work(properties);
+}
+
+// the worker's own deque first (LIFO, the most recent task is the one most likely to be in the cache), then the
+// injection queue, then the other workers
+static void stealing_loop(struct thread_properties *properties) {
+  while (!atomic_load(&properties->terminate)) {
+    struct task task;
+    bool contended = false;
+    poll_fibers(properties, 0);
+
+    if (take_node(deque_pop(&properties->deque), &task) || take_injected(properties, &task) ||
+        steal(properties, &task, &contended)) {
+      run_task(properties, task);
+    } else if (properties->fibers.suspended) {
+      poll_idle(properties, stealing_ready);
+    } else if (!contended && !idle_spin(properties, stealing_ready) && wait_for_work(properties)) {
+      return;
+    }
+  }
+}
+
+// the lanes `properties` may take from which have tasks in them, either in the rings or spilled into `_tasks`
+static unsigned ring_lanes(struct thread_properties *properties) {
+  unsigned lanes = 0;
+  for (unsigned lane = 0; lane < TP_PRIORITY_COUNT; lane++) {
+    if (!ring_empty(&properties->pool->_rings[lane])) lanes |= 1u << lane;
+  }
+
+  lanes |= queued_lanes(properties);
+  return properties->reserved ? lanes & (1u << TP_PRIORITY_INTERACTIVE) : lanes;
+}
+
+static bool ring_ready(void *_properties) {
+  struct thread_properties *properties = _properties;
+
+  return atomic_load(&properties->terminate) || ring_lanes(properties);
+}
+
+static void ring_loop(struct thread_properties *properties) {
+  struct thread_pool *pool = properties->pool;
+  struct parking *lot = properties->reserved ? &pool->_reserved_work : &pool->_work;
+
+  while (!atomic_load(&properties->terminate)) {
+    poll_fibers(properties, 0);
+
+    unsigned lanes = ring_lanes(properties);
+    if (!lanes && properties->fibers.suspended) {
+      poll_idle(properties, ring_ready);
+      continue;
+    }
+
+    if (!lanes && idle_spin(properties, ring_ready)) continue;
+
+    if (!lanes) {
+      struct timespec idle = cooldown(pool);
+      uint64_t since_ns = stats_now_ns();
+      bool woken = parking_park(lot, ring_ready, properties, may_retire(properties) ? &idle : NULL);
+      idle_until_now(properties, since_ns);
+      if (!woken && !ring_lanes(properties) && retire(properties)) return;
+
+      continue;
+    }
+
+    unsigned lane = pick_lane(properties, lanes);
+    struct task task;
+
+    if (ring_pop(&pool->_rings[lane], &task)) {
+      if (pool->_overflow == TP_OVERFLOW_BLOCK) parking_unpark_all(&pool->_space);
+      run_task(properties, task);
+    } else if (take_queued(properties, lane, &task)) {
+      run_task(properties, task);
+    }
+  }
+}
+
+// the tasks run on the thread's own stack if the fds can't be waited for
+static void fibers_start(struct thread_properties *properties) {
+  properties->fibers.running = properties->fibers.suspended = properties->fibers.spare = NULL;
+  properties->fibers.spare_count = 0;
+  properties->fibers.epoll = properties->fibers.wake != -1 ? epoll_create1(EPOLL_CLOEXEC) : -1;
+  if (properties->fibers.epoll == -1) return;
+
+  struct epoll_event event = {.events = EPOLLIN, .data.ptr = NULL};
+  if (epoll_ctl(properties->fibers.epoll, EPOLL_CTL_ADD, properties->fibers.wake, &event) != 0) {
+    close(properties->fibers.epoll);
+    properties->fibers.epoll = -1;
+  }
+}
+
+// the suspended fibers are cancelled & resumed without waiting for their fds. a cancelled task waits for no fd, thus
+// they're bound to be done soon
+static void fibers_stop(struct thread_properties *properties) {
+  if (properties->fibers.epoll == -1) return;
+
+  while (properties->fibers.suspended) {
+    struct task_fiber *fiber = properties->fibers.suspended;
+    (void)cancel_running(&fiber->context, STATE_TASK_ID(atomic_load(&fiber->context.state)));
+
+    unlink_suspended(properties, fiber);
+    resume(properties, fiber);
+  }
+
+  while (properties->fibers.spare) {
+    struct task_fiber *next = properties->fibers.spare->next;
+    fiber_free(properties->fibers.spare);
+    properties->fibers.spare = next;
+  }
+  properties->fibers.spare_count = 0;
+
+  close(properties->fibers.epoll);
+  properties->fibers.epoll = -1;
+}
+
+// e.g. "io:12" for the 13th thread of the pool "io". the name is truncated to what the kernel takes
+static void name_thread(struct thread_pool *pool, char const *suffix, size_t id) {
+  char name[TP_NAME_SIZE + 24];
+  if (suffix) {
+    (void)snprintf(name, sizeof name, "%s:%s", pool->_name, suffix);
+  } else {
+    (void)snprintf(name, sizeof name, "%s:%zu", pool->_name, id);
+  }
+
+  name[TP_NAME_SIZE - 1] = '\0';
+  (void)pthread_setname_np(pthread_self(), name);
+}
+
+static int thread_launch(void *arg) {
+  if (!arg) return 1;
+
+  struct thread_properties *properties = arg;
+  current_thread = properties;
+  name_thread(properties->pool, NULL, properties->id);
+  atomic_store_explicit(&properties->stats.started_ns, stats_now_ns(), memory_order_relaxed);
+  properties->own.runner.owner = &properties->own;
+  properties->context = &properties->own;
+  fibers_start(properties);
+
+  // best effort. a thread which can't be pinned still runs, wherever the kernel sees fit
+  if (properties->pinned) (void)sched_setaffinity(0, sizeof properties->cpus, &properties->cpus);
+
+  switch (properties->pool->_scheduler) {
+    case TP_SCHEDULER_STEALING:
+      stealing_loop(properties);
+      break;
+    case TP_SCHEDULER_RING:
+      ring_loop(properties);
+      break;
+    default:
+      shared_loop(properties);
+      break;
+  }
+
+  fibers_stop(properties);
+
+  uint64_t started_ns = atomic_load_explicit(&properties->stats.started_ns, memory_order_relaxed);
+  stats_bump(&properties->stats.lived_ns, stats_now_ns() - started_ns);
+  atomic_store_explicit(&properties->stats.started_ns, 0, memory_order_relaxed);
+
+  atomic_store(&properties->status, SLOT_EXITED);
+  return 0;
+}
+
+// starts a thread in the first free slot. the controller is the only one to start threads once the pool is running
+static bool spawn(struct thread_pool *pool) {
+  if (atomic_load(&pool->_count) >= pool->_max) return false;
+
+  for (size_t i = pool->_reserved; i < vec_size(&pool->_threads); i++) {
+    struct thread *curr = vec_at(&pool->_threads, i);
+
+    int status = atomic_load(&curr->properties.status);
+    if (status == SLOT_RUNNING) continue;
+    if (status == SLOT_EXITED) thrd_join(curr->id, NULL);
+
+    atomic_store(&curr->properties.status, SLOT_RUNNING);
+    atomic_fetch_add(&pool->_count, 1);
+    if (i >= atomic_load(&pool->_slots)) atomic_store(&pool->_slots, i + 1);
+
+    if (thrd_create(&curr->id, thread_launch, &curr->properties) != thrd_success) {
+      atomic_store(&curr->properties.status, SLOT_EMPTY);
+      atomic_fetch_sub(&pool->_count, 1);
+      return false;
+    }
+
+    return true;
+  }
+
+  return false;
+}
+
+static size_t taken(struct thread_pool *pool) {
+  size_t taken = 0;
+  for (size_t i = 0; i < atomic_load(&pool->_slots); i++) {
+    struct thread *curr = vec_at(&pool->_threads, i);
+    taken += atomic_load_explicit(&curr->properties.taken, memory_order_relaxed);
+  }
+
+  return taken;
+}
+
+// adds a thread whenever tasks wait for longer than `_target_wait_ms` while no thread is idle. the wait is estimated by
+// Little's law: the tasks waiting over the rate threads took tasks at during the last interval. e.g. long transfers
+// which hold all threads up take none, thus any task waiting is late
+static int controller_launch(void *arg) {
+  if (!arg) return 1;
+
+  struct thread_pool *pool = arg;
+  name_thread(pool, "ctl", 0);
+  size_t prev = taken(pool);
+
+  while (!atomic_load(&pool->_terminate)) {
+    thrd_sleep(&(struct timespec){.tv_nsec = CONTROLLER_INTERVAL_MS * 1000L * 1000L}, NULL);
+
+    size_t curr = taken(pool);
+    size_t rate = curr - prev;  // per interval
+    prev = curr;
+
+    size_t waiting = backlog(pool);
+    if (!waiting) continue;
+    if (atomic_load(&pool->_sleepers) || atomic_load(&pool->_work.waiters) || atomic_load(&pool->_pollers)) continue;
+
+    if (!rate || waiting * CONTROLLER_INTERVAL_MS > rate * pool->_target_wait_ms) (void)spawn(pool);
   }
 
-thread_exit:
   return 0;
 }
 
-static void terminate(struct vec *threads, cnd_t *cnd) {
-  if (!threads) return;
+static void terminate(struct thread_pool *tp) {
+  struct vec *threads = &tp->_threads;
+
+  // no thread is started once the controller is gone
+  atomic_store(&tp->_terminate, true);
+  if (tp->_elastic) thrd_join(tp->_controller, NULL);
 
   for (size_t i = 0; i < vec_size(threads); i++) {
     struct thread *curr = vec_at(threads, i);
     atomic_store_explicit(&curr->properties.terminate, true, memory_order_seq_cst);
   }
 
-  while (cnd_broadcast(cnd) != thrd_success) { continue; }
+  // a thread which checked `terminate` right before it was set must be waiting already by the time of the broadcast
+  while (mtx_lock(&tp->_tasks_mtx) != thrd_success) { continue; }
+  while (cnd_broadcast(&tp->_tasks_cnd) != thrd_success) { continue; }
+  while (cnd_broadcast(&tp->_reserved_cnd) != thrd_success) { continue; }
+  while (mtx_unlock(&tp->_tasks_mtx) != thrd_success) { continue; }
+
+  parking_unpark_all(&tp->_work);
+  parking_unpark_all(&tp->_reserved_work);
+  (void)wake_pollers(tp, SIZE_MAX, SIZE_MAX);
+
   for (size_t i = 0; i < vec_size(threads); i++) {
     struct thread *curr = vec_at(threads, i);
-    thrd_join(curr->id, NULL);
+    if (atomic_load(&curr->properties.status) != SLOT_EMPTY) thrd_join(curr->id, NULL);
   }
 }
 
+// the queues & rings store the tasks with no more than pointer alignment, `struct task` needs more. the destructor gets
+// an aligned copy, like the handler does
+static void task_destroy(void *_task) {
+  struct task task;
+  memcpy(&task, _task, sizeof task);
+
+  if (task.destroy_task) task.destroy_task(&task);
+}
+
+static void placement_destroy(struct thread_pool *tp) {
+  for (size_t i = 0; tp->_node_tasks && i < tp->_nodes_count * TP_PRIORITY_COUNT; i++) {
+    queue_destroy(&tp->_node_tasks[i]);
+  }
+  free(tp->_node_tasks);
+  free(tp->_node_queued);
+  topology_destroy(&tp->_topology);
+}
+
 static void tp_destroy_internal(struct thread_pool *tp) {
-  queue_destroy(&tp->_tasks);
+  for (unsigned lane = 0; lane < TP_PRIORITY_COUNT; lane++) {
+    ring_destroy(&tp->_rings[lane], task_destroy);
+    queue_destroy(&tp->_tasks[lane]);
+  }
+  placement_destroy(tp);
+  task_index_destroy(&tp->_index);
   vec_destroy(&tp->_threads);
+  timers_destroy(atomic_load(&tp->_timers));  // the runs of periodic tasks refer to it up until they're destroyed
+  cnd_destroy(&tp->_reserved_cnd);
   cnd_destroy(&tp->_tasks_cnd);
   mtx_destroy(&tp->_tasks_mtx);
   free(tp);
@@ -185,174 +1141,669 @@ static void tp_destroy_internal(struct thread_pool *tp) {
 void tp_destroy(struct thread_pool *thread_pool) {
   if (!thread_pool) return;
 
-  terminate(&thread_pool->_threads, &thread_pool->_tasks_cnd);
+  // no timer adds a task once the threads are gone
+  timers_stop(atomic_load(&thread_pool->_timers));
+  terminate(thread_pool);
   tp_destroy_internal(thread_pool);
-
-  free(global_context.buffers);
-
-  (void)thread_unblock_signal(SIGUSR1);
 }
 
-static void task_destroy(void *_task) {
-  struct task *task = _task;
+static void thread_destroy(void *_thread) {
+  struct thread *thread = _thread;
 
-  if (task->destroy_task) task->destroy_task(task);
+  mtx_destroy(&thread->properties.own.wakeup.mtx);
+  if (thread->properties.fibers.wake != -1) close(thread->properties.fibers.wake);
+  deque_destroy(&thread->properties.deque, task_node_destroy);
 }
 
-static void thread_destroy(void *_thread) {
-  struct thread *thread = _thread;
+// picks the CPUs the thread may run on & its node group
+static void place(struct thread_properties *properties) {
+  struct topology const *topology = &properties->pool->_topology;
+  if (!topology->cpus_count) return;
 
-  mtx_destroy(&thread->properties.state.mtx);
+  properties->pinned = true;
+  CPU_ZERO(&properties->cpus);
+  switch (properties->pool->_placement) {
+    case TP_PLACEMENT_CPU:
+      CPU_SET(topology->cpus[properties->id % topology->cpus_count], &properties->cpus);
+      break;
+    case TP_PLACEMENT_NODE:
+      properties->node = properties->id % topology->nodes_count;
+      topology_node_cpus(topology, properties->node, &properties->cpus);
+      break;
+    default:
+      for (size_t i = 0; i < topology->cpus_count; i++) { CPU_SET(topology->cpus[i], &properties->cpus); }
+      break;
+  }
 }
 
-static bool thread_create(struct thread *restrict thread,
-                          uint8_t id,
-                          struct queue *restrict tasks,
-                          mtx_t *restrict tasks_mtx,
-                          cnd_t *restrict tasks_cnd) {
+static bool thread_create(struct thread *restrict thread, size_t id, struct thread_pool *restrict pool) {
   if (!thread) return false;
-  if (!tasks || !tasks_mtx || !tasks_cnd) return false;
-
-  *thread = (struct thread){.id = 0,
-                            .properties = {.id = id,
-                                           .tasks = {.cnd = tasks_cnd, .mtx = tasks_mtx, .queue = tasks},
-                                           .state = {.task_id = 0, .value = STATE_IDLE}}};
+  if (!pool) return false;
+
+  bool reserved = id < pool->_reserved;
+  *thread = (struct thread){
+    .id = 0,
+    .properties = {.id = id,
+                   .pool = pool,
+                   .seed = id + 1u,  // xorshift never leaves 0
+                   .spin_ns = pool->_spin_ns,
+                   .reserved = reserved,
+                   .tasks = {.cnd = reserved ? &pool->_reserved_cnd : &pool->_tasks_cnd, .mtx = &pool->_tasks_mtx},
+                   .fibers = {.epoll = -1, .wake = -1}}};
+  memcpy(thread->properties.credits, lane_weights, sizeof thread->properties.credits);
+  place(&thread->properties);
 
   atomic_init(&thread->properties.terminate, false);
-  return mtx_init(&thread->properties.state.mtx, mtx_plain) == thrd_success;
+  atomic_init(&thread->properties.polling, false);
+  atomic_init(&thread->properties.status, SLOT_EMPTY);
+  atomic_init(&thread->properties.taken, 0);
+  if (pool->_scheduler == TP_SCHEDULER_STEALING && !deque_init(&thread->properties.deque, DEQUE_CAPACITY)) return false;
+  if (!context_init(&thread->properties.own)) {
+    deque_destroy(&thread->properties.deque, NULL);
+    return false;
+  }
+
+  // the tasks run on the thread's own stack without it (see `fibers_start`)
+  if (pool->_fiber_stack_size) thread->properties.fibers.wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  return true;
 }
 
-static bool install_handler(int signum) {
-  struct sigaction act = {.sa_handler = sig_handler};
+// reads the topology if the threads are to be pinned. the threads of a pool split into node groups have a queue per
+// node on top of the shared ones
+static bool placement_init(struct thread_pool *tp, struct tp_options const *options) {
+  tp->_placement = options->placement;
+  tp->_nodes_count = 1;
+  if (tp->_placement == TP_PLACEMENT_NONE && !options->cpus) return true;
+
+  if (!topology_init(&tp->_topology, options->cpus)) return false;
+  if (tp->_placement != TP_PLACEMENT_NODE || tp->_topology.nodes_count < 2) return true;
+
+  size_t count = tp->_topology.nodes_count * TP_PRIORITY_COUNT;
+  tp->_node_tasks = malloc(count * sizeof *tp->_node_tasks);
+  tp->_node_queued = malloc(count * sizeof *tp->_node_queued);
+  if (!tp->_node_tasks || !tp->_node_queued) {
+    placement_destroy(tp);
+    return false;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    tp->_node_tasks[i] = queue_create(sizeof(struct task), task_destroy);
+    atomic_init(&tp->_node_queued[i], 0);
+  }
 
-  return sigaction(signum, &act, NULL) == 0;
+  tp->_nodes_count = tp->_topology.nodes_count;
+  return true;
 }
 
-// global init
-static bool context_init(uint8_t count) {
-  atomic_init(&global_context.id, INVALID_IDX);
+static size_t ring_capacity(struct tp_options const *options) {
+  size_t capacity = options->ring_capacity ? options->ring_capacity : TP_RING_CAPACITY;
 
-  global_context.count = count;
-  global_context.buffers = malloc(count * sizeof *global_context.buffers);
-  return global_context.buffers != NULL;
+  size_t pow2 = 1;
+  while (pow2 < capacity && pow2 <= SIZE_MAX / 2) { pow2 *= 2; }
+  return pow2;
 }
 
-struct thread_pool *tp_create(uint8_t threads_count) {
+struct thread_pool *tp_create(size_t threads_count) {
+  return tp_create_with_options(&(struct tp_options){.threads_count = threads_count});
+}
+
+struct thread_pool *tp_create_with_options(struct tp_options const *options) {
+  if (!options) goto invalid_thread_pool;
+
+  size_t threads_count = options->threads_count;
+  size_t max_threads = options->max_threads ? options->max_threads : threads_count;
   if (!threads_count) goto invalid_thread_pool;
-  if (!context_init(threads_count)) goto invalid_thread_pool;
+  if (max_threads < threads_count) goto invalid_thread_pool;
+  if (options->interactive_threads >= threads_count) goto invalid_thread_pool;
+
+  if (options->scheduler == TP_SCHEDULER_STEALING) {
+    call_once(&task_nodes_once, task_nodes_create);
+    if (!task_nodes) goto invalid_thread_pool;
+  }
 
-  // constructing the mask for all threads. all threads shall block SIGINT and install a handler for SIGUSR1
-  // the pool uses SIGUSR1 to signal threads to 'abort' their current task
-  if (!install_handler(SIGUSR1)) goto context_cleanup;
-  if (!process_block_signal(SIGINT)) goto context_cleanup;
+  // constructing the mask for all threads. all threads shall block SIGINT
+  if (!process_block_signal(SIGINT)) goto invalid_thread_pool;
 
   struct thread_pool *tp = calloc(1, sizeof *tp);
-  if (!tp) goto context_cleanup;
+  if (!tp) goto invalid_thread_pool;
 
-  if (mtx_init(&tp->_tasks_mtx, mtx_plain) != thrd_success) { goto context_cleanup; }
+  if (mtx_init(&tp->_tasks_mtx, mtx_plain) != thrd_success) { goto tp_cleanup; }
   if (cnd_init(&tp->_tasks_cnd) != thrd_success) { goto mtx_cleanup; }
+  if (cnd_init(&tp->_reserved_cnd) != thrd_success) { goto cnd_cleanup; }
+
+  (void)snprintf(tp->_name, sizeof tp->_name, "%s", options->name ? options->name : TP_NAME);
+  tp->_scheduler = options->scheduler;
+  tp->_reserved = options->interactive_threads;
+  tp->_min = threads_count;
+  tp->_max = max_threads;
+  tp->_elastic = max_threads > threads_count;
+  tp->_target_wait_ms = options->target_wait_ms ? options->target_wait_ms : TP_TARGET_WAIT_MS;
+  tp->_idle_cooldown_ms = options->idle_cooldown_ms ? options->idle_cooldown_ms : TP_IDLE_COOLDOWN_MS;
+  tp->_spinners = options->spinning_threads;
+  tp->_spin_ns = (options->spin_us ? options->spin_us : TP_SPIN_US) * 1000L;
+  atomic_init(&tp->_spinning, 0);
+  if (options->fibers) {
+    tp->_fiber_stack_size = options->fiber_stack_size ? options->fiber_stack_size : TP_FIBER_STACK_SIZE;
+  }
+  atomic_init(&tp->_terminate, false);
+  atomic_init(&tp->_timers, NULL);
+  atomic_init(&tp->_count, threads_count);
+  atomic_init(&tp->_slots, threads_count);
+  for (unsigned lane = 0; lane < TP_PRIORITY_COUNT; lane++) { atomic_init(&tp->_queued[lane], 0); }
+  atomic_init(&tp->_sleepers, 0);
+  atomic_init(&tp->_reserved_sleepers, 0);
+  atomic_init(&tp->_pollers, 0);
+  tp->_stats_every = options->stats_every ? options->stats_every : TP_STATS_EVERY;
+  atomic_init(&tp->_queued_max, 0);
+
+  tp->_overflow = options->overflow;
+  parking_init(&tp->_work);
+  parking_init(&tp->_reserved_work);
+  parking_init(&tp->_space);
+  for (unsigned lane = 0; tp->_scheduler == TP_SCHEDULER_RING && lane < TP_PRIORITY_COUNT; lane++) {
+    if (!ring_init(&tp->_rings[lane], sizeof(struct task), ring_capacity(options))) goto rings_cleanup;
+  }
+
+  if (!placement_init(tp, options)) goto rings_cleanup;
+  if (!task_index_init(&tp->_index)) goto placement_cleanup;
 
   tp->_threads = vec_create(sizeof(struct thread), thread_destroy);
-  vec_reserve(&tp->_threads, threads_count);
+  vec_reserve(&tp->_threads, max_threads);
 
-  tp->_tasks = queue_create(sizeof(struct task), task_destroy);
+  for (unsigned lane = 0; lane < TP_PRIORITY_COUNT; lane++) {
+    tp->_tasks[lane] = queue_create(sizeof(struct task), task_destroy);
+  }
 
-  for (uint8_t i = 0; i < threads_count; i++) {
+  for (size_t i = 0; i < max_threads; i++) {
     struct thread thread;
-    if (!thread_create(&thread, i, &tp->_tasks, &tp->_tasks_mtx, &tp->_tasks_cnd)) {
+    if (!thread_create(&thread, i, tp)) {
       tp_destroy_internal(tp);
       goto invalid_thread_pool;
     }
     vec_push(&tp->_threads, &thread);
   }
 
-  // constructing the mask for the main thread. the main thread shall not handle SIGUSR1
-  if (!thread_block_signal(SIGUSR1)) {
-    tp_destroy_internal(tp);
-    goto invalid_thread_pool;
-  }
-
   // restoring the mask for the main thread. the main thread is no longer blocking SIGINT
   if (!thread_unblock_signal(SIGINT)) {
     tp_destroy_internal(tp);
     goto invalid_thread_pool;
   }
 
-  for (size_t i = 0; i < vec_size(&tp->_threads); i++) {
+  for (size_t i = 0; i < threads_count; i++) {
     struct thread *curr_thrd = vec_at(&tp->_threads, i);
-    if (curr_thrd) thrd_create(&curr_thrd->id, thread_launch, &curr_thrd->properties);
+    if (!curr_thrd) continue;
+
+    atomic_store(&curr_thrd->properties.status, SLOT_RUNNING);
+    thrd_create(&curr_thrd->id, thread_launch, &curr_thrd->properties);
+  }
+
+  if (tp->_elastic && thrd_create(&tp->_controller, controller_launch, tp) != thrd_success) {
+    tp->_elastic = false;
+    tp_destroy(tp);
+    goto invalid_thread_pool;
   }
 
   return tp;
 
+placement_cleanup:
+  placement_destroy(tp);
+rings_cleanup:
+  for (unsigned lane = 0; lane < TP_PRIORITY_COUNT; lane++) { ring_destroy(&tp->_rings[lane], NULL); }
+  cnd_destroy(&tp->_reserved_cnd);
+cnd_cleanup:
+  cnd_destroy(&tp->_tasks_cnd);
 mtx_cleanup:
   mtx_destroy(&tp->_tasks_mtx);
+tp_cleanup:
   free(tp);
-context_cleanup:
-  free(global_context.buffers);
 invalid_thread_pool:
   return NULL;
 }
 
-bool tp_add_task(struct thread_pool *restrict thread_pool, struct task const *restrict task) {
-  if (!thread_pool) return false;
-  if (!task) return false;
+static size_t count_interactive(struct task const *tasks, size_t count) {
+  size_t interactive = 0;
+  for (size_t i = 0; i < count; i++) { interactive += lane_of(&tasks[i]) == TP_PRIORITY_INTERACTIVE; }
+  return interactive;
+}
+
+// wakes up to `count` out of `sleepers` threads waiting on `cnd`. returns the number of threads woken up
+static size_t signal_cnd(cnd_t *cnd, size_t sleepers, size_t count) {
+  if (!count || !sleepers) return 0;
+
+  if (count >= sleepers) {
+    while (cnd_broadcast(cnd) != thrd_success) { continue; }
+    return sleepers;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    while (cnd_signal(cnd) != thrd_success) { continue; }
+  }
+  return count;
+}
+
+// wakes up to `interactive + other` waiting threads. interactive tasks are handed to the reserved threads first, the
+// tasks no sleeper was woken up for to the pollers. `_tasks_mtx` must be held
+static void signal_sleepers(struct thread_pool *thread_pool, size_t interactive, size_t other) {
+  size_t woken = signal_cnd(&thread_pool->_reserved_cnd, atomic_load(&thread_pool->_reserved_sleepers), interactive);
+  woken += signal_cnd(&thread_pool->_tasks_cnd, atomic_load(&thread_pool->_sleepers), interactive - woken + other);
+  (void)wake_pollers(thread_pool, interactive, interactive + other - woken);
+}
+
+// wakes up to `interactive + other` sleepers, if there are any. the fence orders the publication of the tasks before
+// the load of `_sleepers` & `_pollers` (see `wait_for_work` & `poll_idle`)
+static void wake(struct thread_pool *thread_pool, size_t interactive, size_t other) {
+  atomic_thread_fence(memory_order_seq_cst);
+  if (!interactive && !other) return;
+  if (!atomic_load(&thread_pool->_sleepers) && !atomic_load(&thread_pool->_reserved_sleepers)) {
+    (void)wake_pollers(thread_pool, interactive, interactive + other);
+    return;
+  }
+
+  while (mtx_lock(&thread_pool->_tasks_mtx) != thrd_success) { continue; }
+  signal_sleepers(thread_pool, interactive, other);
+  while (mtx_unlock(&thread_pool->_tasks_mtx) != thrd_success) { continue; }
+}
+
+// the node group `task` goes to. `_nodes_count` if any of them may take it
+static size_t node_of(struct thread_pool *thread_pool, struct task const *task) {
+  if (thread_pool->_nodes_count < 2) return thread_pool->_nodes_count;
+  if (task->node == TP_NODE_ANY || task->node > thread_pool->_nodes_count) return thread_pool->_nodes_count;
+
+  return task->node - 1;
+}
+
+static thread_local unsigned stamp_tick;  // the tasks this thread added since it last stamped one
+
+// the tasks are copied into the queues. one in `_stats_every` tasks a thread adds is stamped with the time it was
+// added at on the way & timed by the thread which takes it (see `tp_stats`). the rest cost no clock reads
+static struct task stamped(struct thread_pool *restrict thread_pool, struct task const *restrict task) {
+  struct task copy = *task;
+  copy.added_ns = 0;
+  if (++stamp_tick >= thread_pool->_stats_every) {
+    stamp_tick = 0;
+    copy.added_ns = stats_now_ns();
+  }
+
+  return copy;
+}
+
+// `_tasks_mtx` must be held
+static size_t enqueue(struct thread_pool *restrict thread_pool, struct task const *restrict tasks, size_t count) {
+  size_t added = 0;
+  for (; added < count; added++) {
+    enum tp_priority lane = lane_of(&tasks[added]);
+    size_t node = node_of(thread_pool, &tasks[added]);
+    struct task task = stamped(thread_pool, &tasks[added]);
+
+    if (node < thread_pool->_nodes_count) {
+      size_t idx = node * TP_PRIORITY_COUNT + lane;
+      if (queue_enqueue(&thread_pool->_node_tasks[idx], &task) != DS_OK) break;
 
-  if (!thread_block_signal(SIGUSR1)) return false;
+      atomic_fetch_add(&thread_pool->_node_queued[idx], 1);
+    } else if (queue_enqueue(&thread_pool->_tasks[lane], &task) != DS_OK) {
+      break;
+    }
+
+    atomic_fetch_add(&thread_pool->_queued[lane], 1);
+  }
 
+  return added;
+}
+
+static size_t push_shared(struct thread_pool *restrict thread_pool, struct task const *restrict tasks, size_t count) {
   while (mtx_lock(&thread_pool->_tasks_mtx) != thrd_success) { continue; }
 
-  enum ds_error ret = queue_enqueue(&thread_pool->_tasks, task);
+  size_t added = enqueue(thread_pool, tasks, count);
+  size_t interactive = count_interactive(tasks, added);
+  signal_sleepers(thread_pool, interactive, added - interactive);
 
   while (mtx_unlock(&thread_pool->_tasks_mtx) != thrd_success) { continue; }
+  return added;
+}
+
+// tasks submitted by one of the pool's own workers go to the bottom of the worker's deque regardless of their priority
+static size_t push_local(struct thread_pool *restrict thread_pool, struct task const *restrict tasks, size_t count) {
+  size_t added = 0;
+  for (; added < count; added++) {
+    struct task *node = tp_slab_alloc(task_nodes);
+    if (!node) break;
 
-  if (ret == DS_OK) {
-    while (cnd_broadcast(&thread_pool->_tasks_cnd) != thrd_success) { continue; }
+    *node = stamped(thread_pool, &tasks[added]);
+    if (!deque_push(&current_thread->deque, node)) {
+      tp_slab_free(task_nodes, node);
+      break;
+    }
   }
 
-  (void)thread_unblock_signal(SIGUSR1);
-  return ret == DS_OK;
+  wake(thread_pool, 0, added);
+  return added;
 }
 
-// guaratnee to abort only threads marked as BUSY. i.e. the thread shouldn't block / unblock SIGUSR1 before / after
-// handling a task
-bool tp_abort_task(struct thread_pool *restrict thread_pool, size_t task_id) {
-  if (!thread_block_signal(SIGUSR1)) return false;
+// doesn't wake anyone. the caller decides whom to wake
+static size_t push_injected(struct thread_pool *restrict thread_pool, struct task const *restrict tasks, size_t count) {
+  while (mtx_lock(&thread_pool->_tasks_mtx) != thrd_success) { continue; }
 
-  // nothing fancy. loop over all the threads and look for the one who's BUSY executing `task_id`
-  for (size_t i = 0; i < vec_size(&thread_pool->_threads); i++) {
-    struct thread *curr = vec_at(&thread_pool->_threads, i);
+  size_t added = enqueue(thread_pool, tasks, count);
 
-    if (curr->id == thrd_current()) {  // `curr` is this current self - don't take any action
-      continue;
+  while (mtx_unlock(&thread_pool->_tasks_mtx) != thrd_success) { continue; }
+  return added;
+}
+
+static bool ring_has_space(void *ring) {
+  return !ring_full(ring);
+}
+
+static bool push_ring_one(struct thread_pool *restrict thread_pool, struct task const *restrict task) {
+  struct ring *ring = &thread_pool->_rings[lane_of(task)];
+
+  // a worker never waits for its own pool. every worker might be waiting for a slot & no one would free one
+  enum tp_overflow overflow = thread_pool->_overflow;
+  if (overflow == TP_OVERFLOW_BLOCK && current_thread && current_thread->pool == thread_pool) {
+    overflow = TP_OVERFLOW_SPILL;
+  }
+
+  struct task copy = stamped(thread_pool, task);
+  while (!ring_push(ring, &copy)) {
+    switch (overflow) {
+      case TP_OVERFLOW_FAIL:
+        return false;
+      case TP_OVERFLOW_SPILL:
+        return push_injected(thread_pool, task, 1) == 1;
+      default:
+        // the ring might be full of tasks from this very batch no one was woken for yet
+        parking_unpark_all(&thread_pool->_work);
+        parking_unpark_all(&thread_pool->_reserved_work);
+        (void)wake_pollers(thread_pool, SIZE_MAX, SIZE_MAX);
+        (void)parking_park(&thread_pool->_space, ring_has_space, ring, NULL);
+        break;
     }
+  }
 
-    while (mtx_lock(&curr->properties.state.mtx) != thrd_success) { continue; }
+  return true;
+}
 
-    if (curr->properties.state.value == STATE_BUSY && curr->properties.state.task_id == task_id) {
-      // signal the thread to abort:
-      int idx;
-      do { idx = INVALID_IDX; } while (!atomic_compare_exchange_weak(&global_context.id, &idx, i));
+static size_t push_ring(struct thread_pool *restrict thread_pool, struct task const *restrict tasks, size_t count) {
+  size_t nodes = thread_pool->_nodes_count;
 
-      while (mtx_unlock(&curr->properties.state.mtx) != thrd_success) { continue; }
+  size_t added = 0;
+  while (added < count) {
+    // the rings are shared by all the node groups. the tasks of a node go into its queue
+    if (node_of(thread_pool, &tasks[added]) < nodes) {
+      if (push_injected(thread_pool, &tasks[added], 1) != 1) break;
 
-      bool ret = pthread_kill(curr->id, SIGUSR1) == 0;
-      (void)thread_unblock_signal(SIGUSR1);
+      added++;
+      continue;
+    }
 
-      return ret;
+    // the longest run of tasks of the same priority (up to `STAMP_BATCH`) goes into their ring at once
+    enum tp_priority lane = lane_of(&tasks[added]);
+    size_t run = 1;
+    while (run < STAMP_BATCH && added + run < count && lane_of(&tasks[added + run]) == lane &&
+           node_of(thread_pool, &tasks[added + run]) >= nodes) {
+      run++;
     }
 
-    while (mtx_unlock(&curr->properties.state.mtx) != thrd_success) { continue; }
+    struct task batch[STAMP_BATCH];
+    for (size_t i = 0; i < run; i++) { batch[i] = stamped(thread_pool, &tasks[added + i]); }
+
+    size_t pushed = ring_push_many(&thread_pool->_rings[lane], batch, run);
+    added += pushed;
+
+    // the ring is full. let the overflow policy decide about the next task
+    if (!pushed) {
+      if (!push_ring_one(thread_pool, &tasks[added])) break;
+      added++;
+    }
+  }
+
+  size_t interactive = count_interactive(tasks, added);
+  // the fence orders the publication of the tasks before the load of `_pollers` (see `poll_idle`)
+  atomic_thread_fence(memory_order_seq_cst);
+  size_t woken = parking_unpark_many(&thread_pool->_reserved_work, interactive);
+  woken += parking_unpark_many(&thread_pool->_work, added - woken);
+  (void)wake_pollers(thread_pool, interactive, added - woken);
+  return added;
+}
+
+char const *tp_name(struct thread_pool *thread_pool) {
+  if (!thread_pool) return NULL;
+
+  return thread_pool->_name;
+}
+
+struct thread_pool *tp_current(void) {
+  return current_thread ? current_thread->pool : NULL;
+}
+
+bool tp_stats(struct thread_pool *restrict thread_pool, struct tp_stats *restrict stats) {
+  if (!thread_pool || !stats) return false;
+
+  *stats = (struct tp_stats){.threads = atomic_load(&thread_pool->_count), .queued = backlog(thread_pool)};
+  note_queued(thread_pool, stats->queued);
+  stats->queued_max = atomic_load_explicit(&thread_pool->_queued_max, memory_order_relaxed);
+
+  uint64_t now_ns = stats_now_ns();
+  for (size_t i = 0; i < atomic_load(&thread_pool->_slots); i++) {
+    struct thread *curr = vec_at(&thread_pool->_threads, i);
+    stats_collect(&curr->properties.stats, now_ns, stats);
+    stats->taken += atomic_load_explicit(&curr->properties.taken, memory_order_relaxed);
+  }
+
+  return true;
+}
+
+size_t tp_threads_count(struct thread_pool *thread_pool) {
+  if (!thread_pool) return 0;
+
+  return atomic_load(&thread_pool->_count);
+}
+
+size_t tp_nodes_count(struct thread_pool *thread_pool) {
+  if (!thread_pool) return 0;
+
+  return thread_pool->_nodes_count;
+}
+
+unsigned tp_node_of_cpu(struct thread_pool *thread_pool, int cpu) {
+  if (!thread_pool || thread_pool->_nodes_count < 2) return TP_NODE_ANY;
+
+  int node = topology_node_of(&thread_pool->_topology, cpu);
+  return node < 0 ? TP_NODE_ANY : TP_NODE((unsigned)node);
+}
+
+bool tp_add_task(struct thread_pool *restrict thread_pool, struct task const *restrict task) {
+  return tp_add_tasks(thread_pool, task, 1) == 1;
+}
+
+// counts the tasks with an id as queued, up to the first one which can't be. returns the number of tasks counted
+static size_t index_tasks(struct thread_pool *restrict thread_pool, struct task const *restrict tasks, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (tasks[i].id && !task_index_queue(&thread_pool->_index, tasks[i].id)) return i;
+  }
+
+  return count;
+}
+
+static void unindex_tasks(struct thread_pool *restrict thread_pool, struct task const *restrict tasks, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (tasks[i].id) task_index_unqueue(&thread_pool->_index, tasks[i].id);
+  }
+}
+
+size_t tp_add_tasks(struct thread_pool *restrict thread_pool, struct task const *restrict tasks, size_t count) {
+  if (!thread_pool) return 0;
+  if (!tasks) return 0;
+
+  // e.g. a task destroyed on the way out which adds the next one (see `tp_strand_add_task`)
+  if (atomic_load(&thread_pool->_terminate)) return 0;
+
+  // the tasks are indexed before any thread may take them
+  size_t indexed = index_tasks(thread_pool, tasks, count);
+
+  size_t added;
+  size_t interactive;
+  switch (thread_pool->_scheduler) {
+    case TP_SCHEDULER_STEALING:
+      if (current_thread && current_thread->pool == thread_pool) {
+        added = push_local(thread_pool, tasks, indexed);
+      } else {
+        added = push_injected(thread_pool, tasks, indexed);
+        interactive = count_interactive(tasks, added);
+        wake(thread_pool, interactive, added - interactive);
+      }
+      break;
+    case TP_SCHEDULER_RING:
+      added = push_ring(thread_pool, tasks, indexed);
+      break;
+    default:
+      added = push_shared(thread_pool, tasks, indexed);
+      break;
+  }
+
+  unindex_tasks(thread_pool, tasks + added, indexed - added);
+  return added;
+}
+
+
+// a task is never interrupted. it's flagged as cancelled & the task stops on its own the next time it checks
+// `tp_cancelled`. a queued one is dropped once taken
+bool tp_abort_task(struct thread_pool *restrict thread_pool, size_t task_id) {
+  if (!thread_pool) return false;
+  if (task_id) return task_index_cancel(&thread_pool->_index, task_id, cancel_runner, NULL);
+
+  // tasks without an id aren't indexed. loop over all the threads and look for the one who's BUSY executing one
+  for (size_t i = 0; i < atomic_load(&thread_pool->_slots); i++) {
+    struct thread *curr = vec_at(&thread_pool->_threads, i);
+    if (cancel_running(&curr->properties.own, task_id)) return true;
   }
 
-  (void)thread_unblock_signal(SIGUSR1);
   return false;
 }
 
-bool tp_critical_section_begin(void) {
-  return thread_block_signal(SIGUSR1);
+enum tp_task_state tp_query_task(struct thread_pool *restrict thread_pool, size_t task_id) {
+  if (!thread_pool || !task_id) return TP_TASK_UNKNOWN;
+
+  switch (task_index_query(&thread_pool->_index, task_id)) {
+    case TASK_INDEX_RUNNING:
+      return TP_TASK_RUNNING;
+    case TASK_INDEX_QUEUED:
+      return TP_TASK_QUEUED;
+    default:
+      return TP_TASK_UNKNOWN;
+  }
+}
+
+bool tp_cancelled(void) {
+  if (!current_thread) return false;
+
+  return atomic_load_explicit(&current_thread->context->state, memory_order_relaxed) & STATE_CANCELLED;
 }
 
-bool tp_critical_section_end(void) {
-  return thread_unblock_signal(SIGUSR1);
+bool tp_on_cancel(void (*wake)(void *arg), void *arg) {
+  if (!current_thread) return false;
+
+  struct task_context *context = current_thread->context;
+  while (mtx_lock(&context->wakeup.mtx) != thrd_success) { continue; }
+
+  // the canceller sets `STATE_CANCELLED` before it looks at `STATE_WAKEUP`. either this sees the former or the
+  // canceller sees the latter & waits for the lock, thus the two never miss each other
+  size_t state = wake ? atomic_fetch_or(&context->state, STATE_WAKEUP)
+                      : atomic_fetch_and(&context->state, ~STATE_WAKEUP);
+  bool cancelled = state & STATE_CANCELLED;
+  if (cancelled) (void)atomic_fetch_and(&context->state, ~STATE_WAKEUP);
+
+  context->wakeup.wake = cancelled ? NULL : wake;
+  context->wakeup.arg = cancelled ? NULL : arg;
+
+  while (mtx_unlock(&context->wakeup.mtx) != thrd_success) { continue; }
+  return !cancelled;
+}
+
+// the timers' thread is started on first use. most pools never need it
+static struct timers *timers_of(struct thread_pool *thread_pool) {
+  struct timers *timers = atomic_load(&thread_pool->_timers);
+  if (timers) return timers;
+
+  while (mtx_lock(&thread_pool->_tasks_mtx) != thrd_success) { continue; }
+
+  timers = atomic_load(&thread_pool->_timers);
+  if (!timers) {
+    timers = timers_create(thread_pool);
+    atomic_store(&thread_pool->_timers, timers);
+  }
+
+  while (mtx_unlock(&thread_pool->_tasks_mtx) != thrd_success) { continue; }
+  return timers;
+}
+
+size_t tp_add_delayed_task(struct thread_pool *restrict thread_pool,
+                           struct task const *restrict task,
+                           unsigned delay_ms) {
+  if (!thread_pool || !task) return 0;
+
+  return timers_add(timers_of(thread_pool), task, delay_ms, 0);
+}
+
+size_t tp_add_periodic_task(struct thread_pool *restrict thread_pool,
+                            struct task const *restrict task,
+                            unsigned delay_ms,
+                            unsigned period_ms) {
+  if (!thread_pool || !task || !period_ms) return 0;
+
+  return timers_add(timers_of(thread_pool), task, delay_ms, period_ms);
+}
+
+bool tp_cancel_timer(struct thread_pool *thread_pool, size_t timer_id) {
+  if (!thread_pool) return false;
+
+  return timers_cancel(atomic_load(&thread_pool->_timers), timer_id);
+}
+
+bool tp_task_set_args(struct task *restrict task, void const *restrict args, size_t size) {
+  if (!task || !args || !size || size > sizeof task->inline_args) return false;
+
+  memcpy(task->inline_args, args, size);
+  task->inline_size = size;
+  return true;
+}
+
+void *tp_task_args(struct task *task) {
+  if (!task) return NULL;
+
+  return task->inline_size ? task->inline_args : task->args;
+}
+
+bool tp_in_fiber(void) {
+  return current_thread && current_thread->fibers.running;
+}
+
+static bool poll_fd(int fd, unsigned events) {
+  struct pollfd pollfd = {.fd = fd,
+                          .events = (events & TP_WAIT_READ ? POLLIN : 0) | (events & TP_WAIT_WRITE ? POLLOUT : 0)};
+
+  int ret;
+  while ((ret = poll(&pollfd, 1, -1)) == -1 && errno == EINTR) { continue; }
+  return ret == 1;
+}
+
+// the fd is registered for a single event & unregistered once the fiber is resumed, thus it may be closed or waited
+// for by another fiber right after
+bool tp_wait_fd(int fd, unsigned events) {
+  if (tp_cancelled()) return false;
+  if (!tp_in_fiber()) return poll_fd(fd, events);
+
+  struct thread_properties *properties = current_thread;
+  struct task_fiber *fiber = properties->fibers.running;
+  struct epoll_event event = {.events = EPOLLONESHOT, .data.ptr = fiber};
+  if (events & TP_WAIT_READ) event.events |= EPOLLIN | EPOLLRDHUP;
+  if (events & TP_WAIT_WRITE) event.events |= EPOLLOUT;
+
+  // a regular file can't be registered, it's always ready. anything else, e.g. an fd another fiber of this thread waits
+  // for already, fails the wait: polling for it would block every fiber of this thread
+  if (epoll_ctl(properties->fibers.epoll, EPOLL_CTL_ADD, fd, &event) != 0) return errno == EPERM;
+
+  suspend(properties, fiber);
+
+  (void)epoll_ctl(properties->fibers.epoll, EPOLL_CTL_DEL, fd, NULL);
+  return !tp_cancelled();
 }
@@ -0,0 +1,429 @@
+#include "timers.h"
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <threads.h>
+#include <time.h>
+#include "parking.h"
+
+#define TIMERS_CAPACITY 16
+#define SLOT_BITS 32
+#define SLOT_MASK ((size_t)UINT32_MAX)
+#define NO_SLOT SIZE_MAX
+
+struct timer {
+  struct timers *timers;
+  struct task task;
+  struct timespec due;  // on `CLOCK_MONOTONIC`
+  unsigned period_ms;  // 0 for a task which runs once
+  size_t slot;
+  size_t heap_idx;  // `TIMER_SCHEDULED` only
+
+  enum {
+    TIMER_SCHEDULED,  // in the heap
+    TIMER_RUNNING,    // a periodic task's run is in the pool
+    TIMER_CANCELLED,  // cancelled while running. destroyed once the run is done
+  } state;
+};
+
+// a timer's id is its slot's generation (high bits) & the slot's index (low bits). a slot's generation changes once
+// it's freed, thus a stale id never finds the timer which took the slot over
+struct timer_slot {
+  struct timer *timer;  // `NULL` if free
+  uint32_t generation;
+  size_t next_free;
+};
+
+struct timers {
+  struct thread_pool *pool;
+  thrd_t thread;
+  bool terminate;
+
+  // the thread parks till the earliest timer is due & is unparked whenever it might be earlier. a futex measures its
+  // timeout on `CLOCK_MONOTONIC`, thus a step of the wall clock (e.g. by NTP) neither delays the timers nor fires them
+  // early
+  struct parking parking;
+  atomic_uint changes;  // bumped before every unpark. the thread parks unless it changed since the thread last looked
+
+  mtx_t mtx;
+
+  // all of the below are guarded by `mtx`
+  struct timer **heap;  // ordered by `timer::due`
+  size_t heap_size;
+  size_t heap_capacity;
+
+  struct timer_slot *slots;
+  size_t slots_count;
+  size_t slots_capacity;
+  size_t free_slot;  // the head of the free slots list. `NO_SLOT` if there's none
+};
+
+static struct timespec deadline(unsigned ms) {
+  struct timespec ts;
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  ts.tv_sec += ms / 1000;
+  ts.tv_nsec += (ms % 1000) * 1000L * 1000L;
+  if (ts.tv_nsec >= 1000L * 1000L * 1000L) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000L * 1000L * 1000L;
+  }
+
+  return ts;
+}
+
+static bool earlier(struct timespec const *a, struct timespec const *b) {
+  return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+// the time from `now` till `due`. `now` is earlier than `due`
+static struct timespec until(struct timespec const *now, struct timespec const *due) {
+  struct timespec ts = {.tv_sec = due->tv_sec - now->tv_sec, .tv_nsec = due->tv_nsec - now->tv_nsec};
+  if (ts.tv_nsec < 0) {
+    ts.tv_sec--;
+    ts.tv_nsec += 1000L * 1000L * 1000L;
+  }
+
+  return ts;
+}
+
+// the caller holds `timers->mtx`
+static void timers_wake(struct timers *timers) {
+  atomic_fetch_add(&timers->changes, 1);
+  parking_unpark_one(&timers->parking);
+}
+
+struct timers_wait {
+  struct timers *timers;
+  unsigned changes;  // as seen by the thread before it let go of the lock
+};
+
+static bool timers_changed(void *_wait) {
+  struct timers_wait *wait = _wait;
+
+  return atomic_load(&wait->timers->changes) != wait->changes;
+}
+
+static void heap_set(struct timers *timers, size_t idx, struct timer *timer) {
+  timers->heap[idx] = timer;
+  timer->heap_idx = idx;
+}
+
+static void sift_up(struct timers *timers, size_t idx) {
+  struct timer *timer = timers->heap[idx];
+  while (idx) {
+    size_t parent = (idx - 1) / 2;
+    if (!earlier(&timer->due, &timers->heap[parent]->due)) break;
+
+    heap_set(timers, idx, timers->heap[parent]);
+    idx = parent;
+  }
+
+  heap_set(timers, idx, timer);
+}
+
+static void sift_down(struct timers *timers, size_t idx) {
+  struct timer *timer = timers->heap[idx];
+  while (true) {
+    size_t child = 2 * idx + 1;
+    if (child >= timers->heap_size) break;
+    if (child + 1 < timers->heap_size && earlier(&timers->heap[child + 1]->due, &timers->heap[child]->due)) child++;
+    if (!earlier(&timers->heap[child]->due, &timer->due)) break;
+
+    heap_set(timers, idx, timers->heap[child]);
+    idx = child;
+  }
+
+  heap_set(timers, idx, timer);
+}
+
+static bool heap_push(struct timers *timers, struct timer *timer) {
+  if (timers->heap_size == timers->heap_capacity) {
+    size_t capacity = timers->heap_capacity ? timers->heap_capacity * 2 : TIMERS_CAPACITY;
+    struct timer **heap = realloc(timers->heap, capacity * sizeof *heap);
+    if (!heap) return false;
+
+    timers->heap = heap;
+    timers->heap_capacity = capacity;
+  }
+
+  timers->heap[timers->heap_size++] = timer;
+  sift_up(timers, timers->heap_size - 1);
+  return true;
+}
+
+static void heap_remove(struct timers *timers, size_t idx) {
+  struct timer *last = timers->heap[--timers->heap_size];
+  if (idx == timers->heap_size) return;
+
+  heap_set(timers, idx, last);
+  sift_up(timers, idx);
+  sift_down(timers, last->heap_idx);
+}
+
+static bool slot_take(struct timers *timers, struct timer *timer) {
+  if (timers->free_slot == NO_SLOT) {
+    if (timers->slots_count > SLOT_MASK) return false;
+
+    if (timers->slots_count == timers->slots_capacity) {
+      size_t capacity = timers->slots_capacity ? timers->slots_capacity * 2 : TIMERS_CAPACITY;
+      struct timer_slot *slots = realloc(timers->slots, capacity * sizeof *slots);
+      if (!slots) return false;
+
+      timers->slots = slots;
+      timers->slots_capacity = capacity;
+    }
+
+    timers->slots[timers->slots_count] = (struct timer_slot){.generation = 1, .next_free = NO_SLOT};
+    timers->free_slot = timers->slots_count++;
+  }
+
+  timer->slot = timers->free_slot;
+  timers->free_slot = timers->slots[timer->slot].next_free;
+  timers->slots[timer->slot].timer = timer;
+  return true;
+}
+
+static void slot_free(struct timers *timers, size_t slot) {
+  struct timer_slot *curr = &timers->slots[slot];
+
+  curr->timer = NULL;
+  curr->generation = curr->generation == UINT32_MAX ? 1 : curr->generation + 1;  // an id is never 0
+  curr->next_free = timers->free_slot;
+  timers->free_slot = slot;
+}
+
+static size_t timer_id(struct timers *timers, struct timer *timer) {
+  return (size_t)timers->slots[timer->slot].generation << SLOT_BITS | timer->slot;
+}
+
+static struct timer *timer_of(struct timers *timers, size_t timer_id) {
+  size_t slot = timer_id & SLOT_MASK;
+  if (slot >= timers->slots_count) return NULL;
+  if (timers->slots[slot].generation != timer_id >> SLOT_BITS) return NULL;
+
+  return timers->slots[slot].timer;
+}
+
+static void timer_destroy(struct timer *timer) {
+  if (timer->task.destroy_task) timer->task.destroy_task(&timer->task);
+  free(timer);
+}
+
+static void run_periodic(void *_timer) {
+  struct timer *timer = _timer;
+
+  if (timer->task.handle_task) timer->task.handle_task(tp_task_args(&timer->task));
+}
+
+// the run is done (or was dropped by the pool). the timer is due again `period_ms` from now unless it was cancelled
+// in the meantime
+static void periodic_done(void *_task) {
+  struct task *task = _task;
+  struct timer *timer = task->args;
+  struct timers *timers = timer->timers;
+
+  while (mtx_lock(&timers->mtx) != thrd_success) { continue; }
+
+  bool rescheduled = false;
+  if (timer->state == TIMER_RUNNING && !timers->terminate) {
+    timer->due = deadline(timer->period_ms);
+    timer->state = TIMER_SCHEDULED;
+    rescheduled = heap_push(timers, timer);
+  }
+
+  if (rescheduled) {
+    timers_wake(timers);
+  } else if (timer->state != TIMER_CANCELLED) {
+    slot_free(timers, timer->slot);
+  }
+
+  while (mtx_unlock(&timers->mtx) != thrd_success) { continue; }
+
+  if (!rescheduled) timer_destroy(timer);
+}
+
+// adds the task of a due timer to the pool. the task of a timer which runs once is handed over as is, the runs of a
+// periodic one refer back to the timer
+static void fire(struct timers *timers, struct timer *timer) {
+  if (!timer->period_ms) {
+    if (!tp_add_task(timers->pool, &timer->task) && timer->task.destroy_task) timer->task.destroy_task(&timer->task);
+    free(timer);
+    return;
+  }
+
+  struct task run = {.id = timer->task.id,
+                     .priority = timer->task.priority,
+                     .node = timer->task.node,
+                     .args = timer,
+                     .handle_task = run_periodic,
+                     .destroy_task = periodic_done};
+  if (!tp_add_task(timers->pool, &run)) periodic_done(&run);
+}
+
+static bool thread_block_signal(int signum) {
+  sigset_t sig_to_block;
+  if (sigemptyset(&sig_to_block) != 0) return false;
+  if (sigaddset(&sig_to_block, signum) != 0) return false;
+
+  return pthread_sigmask(SIG_BLOCK, &sig_to_block, NULL) == 0;
+}
+
+static int timers_launch(void *arg) {
+  if (!arg) return 1;
+
+  struct timers *timers = arg;
+
+  // like the pool's threads, the timers' thread leaves SIGINT to the main thread
+  (void)thread_block_signal(SIGINT);
+
+  while (mtx_lock(&timers->mtx) != thrd_success) { continue; }
+
+  while (!timers->terminate) {
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+
+    struct timer *timer = timers->heap_size ? timers->heap[0] : NULL;
+    if (!timer || earlier(&now, &timer->due)) {
+      // waits for as long as it takes while there's no timer at all
+      struct timespec timeout = timer ? until(&now, &timer->due) : (struct timespec){0};
+      struct timers_wait wait = {.timers = timers, .changes = atomic_load(&timers->changes)};
+
+      while (mtx_unlock(&timers->mtx) != thrd_success) { continue; }
+      (void)parking_park(&timers->parking, timers_changed, &wait, timer ? &timeout : NULL);
+      while (mtx_lock(&timers->mtx) != thrd_success) { continue; }
+      continue;
+    }
+
+    heap_remove(timers, 0);
+    if (timer->period_ms) {
+      timer->state = TIMER_RUNNING;
+    } else {
+      slot_free(timers, timer->slot);
+    }
+
+    // the pool might be full (`TP_OVERFLOW_BLOCK`), thus the task is added without the lock
+    while (mtx_unlock(&timers->mtx) != thrd_success) { continue; }
+    fire(timers, timer);
+    while (mtx_lock(&timers->mtx) != thrd_success) { continue; }
+  }
+
+  while (mtx_unlock(&timers->mtx) != thrd_success) { continue; }
+  return 0;
+}
+
+struct timers *timers_create(struct thread_pool *pool) {
+  if (!pool) return NULL;
+
+  struct timers *timers = calloc(1, sizeof *timers);
+  if (!timers) return NULL;
+
+  timers->pool = pool;
+  timers->free_slot = NO_SLOT;
+  parking_init(&timers->parking);
+  atomic_init(&timers->changes, 0);
+
+  if (mtx_init(&timers->mtx, mtx_plain) != thrd_success) goto timers_cleanup;
+  if (thrd_create(&timers->thread, timers_launch, timers) != thrd_success) goto mtx_cleanup;
+
+  return timers;
+
+mtx_cleanup:
+  mtx_destroy(&timers->mtx);
+timers_cleanup:
+  free(timers);
+  return NULL;
+}
+
+void timers_stop(struct timers *timers) {
+  if (!timers) return;
+
+  while (mtx_lock(&timers->mtx) != thrd_success) { continue; }
+
+  timers->terminate = true;
+  timers_wake(timers);
+
+  while (mtx_unlock(&timers->mtx) != thrd_success) { continue; }
+
+  thrd_join(timers->thread, NULL);
+
+  // the thread is gone, nothing but the runs still in the pool touches the timers
+  while (mtx_lock(&timers->mtx) != thrd_success) { continue; }
+
+  size_t count = timers->heap_size;
+  struct timer **heap = timers->heap;
+  for (size_t i = 0; i < count; i++) { slot_free(timers, heap[i]->slot); }
+  timers->heap = NULL;
+  timers->heap_size = timers->heap_capacity = 0;
+
+  while (mtx_unlock(&timers->mtx) != thrd_success) { continue; }
+
+  for (size_t i = 0; i < count; i++) { timer_destroy(heap[i]); }
+  free(heap);
+}
+
+void timers_destroy(struct timers *timers) {
+  if (!timers) return;
+
+  free(timers->heap);
+  free(timers->slots);
+  mtx_destroy(&timers->mtx);
+  free(timers);
+}
+
+size_t timers_add(struct timers *restrict timers,
+                  struct task const *restrict task,
+                  unsigned delay_ms,
+                  unsigned period_ms) {
+  if (!timers || !task) return 0;
+
+  struct timer *timer = malloc(sizeof *timer);
+  if (!timer) return 0;
+
+  *timer = (struct timer){.timers = timers,
+                          .task = *task,
+                          .due = deadline(delay_ms),
+                          .period_ms = period_ms,
+                          .state = TIMER_SCHEDULED};
+
+  while (mtx_lock(&timers->mtx) != thrd_success) { continue; }
+
+  size_t id = 0;
+  if (!timers->terminate && slot_take(timers, timer)) {
+    if (heap_push(timers, timer)) {
+      id = timer_id(timers, timer);
+    } else {
+      slot_free(timers, timer->slot);
+    }
+  }
+
+  // the thread only needs to recheck if this timer is the earliest
+  if (id && !timer->heap_idx) timers_wake(timers);
+
+  while (mtx_unlock(&timers->mtx) != thrd_success) { continue; }
+
+  if (!id) free(timer);
+  return id;
+}
+
+bool timers_cancel(struct timers *timers, size_t timer_id) {
+  if (!timers || !timer_id) return false;
+
+  while (mtx_lock(&timers->mtx) != thrd_success) { continue; }
+
+  struct timer *timer = timer_of(timers, timer_id);
+  bool scheduled = timer && timer->state == TIMER_SCHEDULED;
+  if (scheduled) {
+    heap_remove(timers, timer->heap_idx);
+  } else if (timer) {
+    // a periodic task's run is in the pool. the timer is destroyed once the run is done
+    timer->state = TIMER_CANCELLED;
+  }
+  if (timer) slot_free(timers, timer->slot);
+
+  while (mtx_unlock(&timers->mtx) != thrd_success) { continue; }
+
+  if (scheduled) timer_destroy(timer);
+  return timer != NULL;
+}
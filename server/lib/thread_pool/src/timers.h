@@ -0,0 +1,64 @@
+#pragma once
+
+/**
+ * @file timers.h
+ * @brief the delayed & periodic tasks of a pool. a single thread sleeps until the earliest timer is due & adds its task
+ * to the pool. the timers are kept in a binary min-heap ordered by their due time. every timer also has a slot in a
+ * table through which it's found by its id, thus cancelling one takes O(log n).
+ *
+ * a periodic task is due again `period` after its previous run completed (a fixed delay rather than a fixed rate), thus
+ * no two runs of it ever overlap & a slow one doesn't pile runs up
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "thread_pool.h"
+
+struct timers;
+
+/**
+ * @brief creates the timers of `pool` & starts their thread
+ *
+ * @param[in] pool
+ * @return `struct timers *` - `NULL` on failure
+ */
+struct timers *timers_create(struct thread_pool *pool);
+
+/**
+ * @brief stops the thread. the timers which aren't due yet are destroyed. the runs of periodic tasks still in the pool
+ * are let be, they're destroyed once done instead of being rescheduled. no timer may be added from then on
+ *
+ * @param[in] timers
+ */
+void timers_stop(struct timers *timers);
+
+/**
+ * @brief destroys the timers. `timers_stop` must have been called & the pool mustn't hold any run of a periodic task
+ *
+ * @param[in] timers
+ */
+void timers_destroy(struct timers *timers);
+
+/**
+ * @brief adds a timer
+ *
+ * @param[in] timers
+ * @param[in] task
+ * @param[in] delay_ms - the time until the first run
+ * @param[in] period_ms - the time from the end of a run to the next one. 0 for a task which runs once
+ * @return `size_t` - the timer's id. 0 on failure
+ */
+size_t timers_add(struct timers *restrict timers,
+                  struct task const *restrict task,
+                  unsigned delay_ms,
+                  unsigned period_ms);
+
+/**
+ * @brief cancels a timer
+ *
+ * @param[in] timers
+ * @param[in] timer_id
+ * @return `true` if the timer was cancelled
+ * @return `false` if there's no such timer: it ran already (once), was cancelled or never existed
+ */
+bool timers_cancel(struct timers *timers, size_t timer_id);
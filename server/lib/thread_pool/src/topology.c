@@ -0,0 +1,127 @@
+#include "topology.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NODES_PATH "/sys/devices/system/node"
+#define LIST_SIZE 4096
+
+// parses a list in the kernel's format (e.g. "0-3,8,10-11"). both CPUs & nodes are listed that way
+static bool list_parse(char const *list, cpu_set_t *set) {
+  CPU_ZERO(set);
+
+  char const *curr = list;
+  while (*curr && *curr != '\n') {
+    if (*curr < '0' || *curr > '9') return false;
+
+    char *end;
+    unsigned long first = strtoul(curr, &end, 10);
+    unsigned long last = first;
+    if (*end == '-') {
+      curr = end + 1;
+      if (*curr < '0' || *curr > '9') return false;
+
+      last = strtoul(curr, &end, 10);
+    }
+
+    if (last < first || last >= CPU_SETSIZE) return false;
+    for (unsigned long i = first; i <= last; i++) { CPU_SET(i, set); }
+
+    if (*end == ',') {
+      end++;
+    } else if (*end && *end != '\n') {
+      return false;
+    }
+    curr = end;
+  }
+
+  return true;
+}
+
+static bool list_read(char const *path, cpu_set_t *set) {
+  FILE *file = fopen(path, "r");
+  if (!file) return false;
+
+  char list[LIST_SIZE];
+  bool ret = fgets(list, sizeof list, file) && list_parse(list, set);
+
+  fclose(file);
+  return ret;
+}
+
+static void add_node(struct topology *topology, cpu_set_t const *cpus) {
+  if (!CPU_COUNT(cpus)) return;
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, cpus)) topology->cpus[topology->cpus_count++] = cpu;
+  }
+
+  topology->nodes[++topology->nodes_count] = topology->cpus_count;
+}
+
+bool topology_init(struct topology *topology, char const *cpus) {
+  if (!topology) return false;
+
+  cpu_set_t left;
+  if (sched_getaffinity(0, sizeof left, &left) != 0) return false;
+
+  if (cpus) {
+    cpu_set_t wanted;
+    if (!list_parse(cpus, &wanted)) return false;
+
+    CPU_AND(&left, &left, &wanted);
+  }
+
+  size_t count = CPU_COUNT(&left);
+  if (!count) return false;
+
+  // every node holds at least a single CPU thus there are no more nodes than CPUs
+  *topology = (struct topology){.cpus = malloc(count * sizeof *topology->cpus),
+                                .nodes = calloc(count + 1, sizeof *topology->nodes)};
+  if (!topology->cpus || !topology->nodes) {
+    topology_destroy(topology);
+    return false;
+  }
+
+  cpu_set_t nodes;
+  bool numa = list_read(NODES_PATH "/online", &nodes);
+  for (int node = 0; numa && node < CPU_SETSIZE; node++) {
+    if (!CPU_ISSET(node, &nodes)) continue;
+
+    char path[sizeof NODES_PATH "/node/cpulist" + 16];
+    (void)snprintf(path, sizeof path, NODES_PATH "/node%d/cpulist", node);
+
+    cpu_set_t node_cpus;
+    if (!list_read(path, &node_cpus)) continue;
+
+    CPU_AND(&node_cpus, &node_cpus, &left);
+    CPU_XOR(&left, &left, &node_cpus);
+    add_node(topology, &node_cpus);
+  }
+
+  // the CPUs of no known node (e.g. no NUMA support at all) make up a node of their own
+  add_node(topology, &left);
+  return true;
+}
+
+void topology_destroy(struct topology *topology) {
+  if (!topology) return;
+
+  free(topology->cpus);
+  free(topology->nodes);
+  *topology = (struct topology){0};
+}
+
+int topology_node_of(struct topology const *topology, int cpu) {
+  for (size_t node = 0; node < topology->nodes_count; node++) {
+    for (size_t i = topology->nodes[node]; i < topology->nodes[node + 1]; i++) {
+      if (topology->cpus[i] == cpu) return (int)node;
+    }
+  }
+
+  return -1;
+}
+
+void topology_node_cpus(struct topology const *topology, size_t node, cpu_set_t *set) {
+  CPU_ZERO(set);
+  for (size_t i = topology->nodes[node]; i < topology->nodes[node + 1]; i++) { CPU_SET(topology->cpus[i], set); }
+}
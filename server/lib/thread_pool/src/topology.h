@@ -0,0 +1,58 @@
+#pragma once
+
+/**
+ * @file topology.h
+ * @brief the CPUs a pool may run on, grouped by NUMA node. read from `/sys/devices/system/node`. a machine (or a
+ * kernel) without NUMA support has a single node holding every CPU.
+ *
+ * only the nodes with at least one usable CPU are kept. they're numbered densely from 0 in the order of the kernel's
+ * node ids
+ */
+
+#include <sched.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct topology {
+  size_t cpus_count;
+  int *cpus;  // the usable CPUs, grouped by node
+
+  size_t nodes_count;
+  size_t *nodes;  // `nodes_count + 1` offsets into `cpus`. node `i` holds the CPUs [`nodes[i]`, `nodes[i + 1]`)
+};
+
+/**
+ * @brief reads the topology of the machine
+ *
+ * @param[out] topology
+ * @param[in] cpus - the CPUs to use, a list in the kernel's format (e.g. "0-3,8"). may be `NULL`, in which case every
+ * CPU the calling thread may run on is used. CPUs the calling thread may not run on are left out either way
+ * @return `true` on success
+ * @return `false` if `cpus` is malformed or leaves no CPU to use
+ */
+bool topology_init(struct topology *topology, char const *cpus);
+
+/**
+ * @brief destroys a topology. a no-op on a zeroed one
+ *
+ * @param[in] topology
+ */
+void topology_destroy(struct topology *topology);
+
+/**
+ * @brief the node `cpu` belongs to
+ *
+ * @param[in] topology
+ * @param[in] cpu
+ * @return `int` - the node or -1 if `cpu` isn't a usable one
+ */
+int topology_node_of(struct topology const *topology, int cpu);
+
+/**
+ * @brief the usable CPUs of `node`
+ *
+ * @param[in] topology
+ * @param[in] node - must be less than `topology::nodes_count`
+ * @param[out] set
+ */
+void topology_node_cpus(struct topology const *topology, size_t node, cpu_set_t *set);
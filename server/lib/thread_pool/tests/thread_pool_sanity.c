@@ -1,9 +1,12 @@
 #include <assert.h>
+#include <fcntl.h>
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <threads.h>
 #include <time.h>
+#include <unistd.h>
 #include "ascii_str.h"
 #include "logger.h"
 #include "thread_pool.h"
@@ -17,6 +20,7 @@ struct task_args_long {
   unsigned sec;
   struct logger *logger;
   struct ascii_str string;
+  atomic_bool cancelled;
 };
 
 static int generate_random(int min, int max) {
@@ -75,8 +79,17 @@ static void long_task_handler(void *_args) {
   struct task_args_long *args = _args;
   LOG(args->logger, INFO, "\n\tworker %ld starts a computional heavy task\n", thrd_current());
 
+  // the computation is made of small steps. a cancelled task stops at the next one
   struct timespec reminaing = {0};
-  nanosleep(&(struct timespec){.tv_sec = args->sec}, &reminaing);
+  for (unsigned ms = 0; ms < args->sec * 1000; ms += 10) {
+    if (tp_cancelled()) {
+      atomic_store(&args->cancelled, true);
+      LOG(args->logger, INFO, "\n\tworker %ld was cancelled\n", thrd_current());
+      return;
+    }
+
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &reminaing);
+  }
 
   LOG(args->logger, INFO, "\n\tworker %ld return the result: %s\n", thrd_current(), ascii_str_c_str(&args->string));
 }
@@ -200,6 +213,689 @@ static void tp_add_multiple_tasks_test(struct logger *restrict logger, size_t co
   vec_destroy(&strings);
 }
 
+struct task_args_spawn {
+  struct thread_pool *tp;
+  unsigned depth;
+  atomic_size_t *done;
+};
+
+// every task spawns 2 children from within the pool until `depth` runs out
+static void spawn_task_handler(void *_args) {
+  struct task_args_spawn *args = _args;
+
+  for (int i = 0; args->depth && i < 2; i++) {
+    struct task_args_spawn *child = malloc(sizeof *child);
+    assert(child);
+    *child = (struct task_args_spawn){.tp = args->tp, .depth = args->depth - 1, .done = args->done};
+
+    bool ret = tp_add_task(
+      args->tp,
+      &(struct task){.args = child, .destroy_task = simple_task_destroyer_heap, .handle_task = spawn_task_handler});
+    assert(ret);
+  }
+
+  atomic_fetch_add(args->done, 1);
+}
+
+static void tp_spawn_test(struct logger *restrict logger, struct tp_options options, unsigned depth) {
+  LOG(logger,
+      INFO,
+      "\n\ttesting a spawn tree of depth %u with %d threads (scheduler %d)\n",
+      depth,
+      options.threads_count,
+      options.scheduler);
+
+  // given
+  struct thread_pool *tp = tp_create_with_options(&options);
+  assert(tp);
+
+  atomic_size_t done;
+  atomic_init(&done, 0);
+
+  struct task_args_spawn *root = malloc(sizeof *root);
+  assert(root);
+  *root = (struct task_args_spawn){.tp = tp, .depth = depth, .done = &done};
+
+  // when
+  bool ret = tp_add_task(
+    tp,
+    &(struct task){.args = root, .destroy_task = simple_task_destroyer_heap, .handle_task = spawn_task_handler});
+  assert(ret);
+
+  // then
+  size_t expected = (2u << depth) - 1;
+  struct timespec remaining = {0};
+  for (int i = 0; i < 500 && atomic_load(&done) != expected; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&done) == expected);
+
+  // cleanup
+  after(tp);
+}
+
+struct task_args_count {
+  atomic_size_t *done;
+};
+
+static void count_task_handler(void *_args) {
+  struct task_args_count *args = _args;
+
+  atomic_fetch_add(args->done, 1);
+}
+
+static void tp_add_tasks_test(struct logger *restrict logger, struct tp_options options, size_t batches, size_t count) {
+  LOG(logger,
+      INFO,
+      "\n\ttesting %zu batches of %zu tasks with %d threads (scheduler %d)\n",
+      batches,
+      count,
+      options.threads_count,
+      options.scheduler);
+
+  // given
+  struct thread_pool *tp = tp_create_with_options(&options);
+  assert(tp);
+
+  atomic_size_t done;
+  atomic_init(&done, 0);
+  struct task_args_count args = {.done = &done};
+
+  struct task *tasks = malloc(count * sizeof *tasks);
+  assert(tasks);
+  for (size_t i = 0; i < count; i++) { tasks[i] = (struct task){.args = &args, .handle_task = count_task_handler}; }
+
+  // when
+  for (size_t i = 0; i < batches; i++) { assert(tp_add_tasks(tp, tasks, count) == count); }
+
+  // then
+  struct timespec remaining = {0};
+  for (int i = 0; i < 500 && atomic_load(&done) != batches * count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&done) == batches * count);
+
+  // cleanup
+  after(tp);
+  free(tasks);
+}
+
+struct task_args_gate {
+  atomic_bool *started;
+  atomic_bool *open;
+  atomic_size_t *done;
+};
+
+static void gate_task_handler(void *_args) {
+  struct task_args_gate *args = _args;
+
+  atomic_store(args->started, true);
+
+  struct timespec remaining = {0};
+  while (!atomic_load(args->open)) { nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining); }
+
+  atomic_fetch_add(args->done, 1);
+}
+
+static int open_gate(void *_open) {
+  struct timespec remaining = {0};
+  nanosleep(&(struct timespec){.tv_nsec = 200 * 1000 * 1000}, &remaining);
+
+  atomic_store((atomic_bool *)_open, true);
+  return 0;
+}
+
+static void tp_ring_overflow_test(struct logger *restrict logger, enum tp_overflow overflow) {
+  LOG(logger, INFO, "\n\ttesting a full ring (overflow %d)\n", overflow);
+
+  // given a single thread stuck in a task & a full ring
+  struct thread_pool *tp = tp_create_with_options(
+    &(struct tp_options){.threads_count = 1, .scheduler = TP_SCHEDULER_RING, .ring_capacity = 4, .overflow = overflow});
+  assert(tp);
+
+  atomic_bool started;
+  atomic_bool open;
+  atomic_size_t done;
+  atomic_init(&started, false);
+  atomic_init(&open, false);
+  atomic_init(&done, 0);
+
+  struct task_args_gate args = {.started = &started, .open = &open, .done = &done};
+  struct task task = {.args = &args, .handle_task = gate_task_handler};
+
+  assert(tp_add_task(tp, &task));
+  struct timespec remaining = {0};
+  while (!atomic_load(&started)) { nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining); }
+
+  for (int i = 0; i < 4; i++) { assert(tp_add_task(tp, &task)); }
+
+  // when
+  thrd_t opener;
+  if (overflow == TP_OVERFLOW_BLOCK) assert(thrd_create(&opener, open_gate, &open) == thrd_success);
+  bool ret = tp_add_task(tp, &task);
+
+  // then
+  size_t expected = 5;
+  switch (overflow) {
+    case TP_OVERFLOW_FAIL:
+      assert(!ret);
+      break;
+    case TP_OVERFLOW_BLOCK:
+      assert(ret);
+      assert(atomic_load(&open));  // must have waited for the gate to open
+      thrd_join(opener, NULL);
+      expected++;
+      break;
+    default:
+      assert(ret);
+      expected++;
+      break;
+  }
+
+  atomic_store(&open, true);
+  for (int i = 0; i < 500 && atomic_load(&done) != expected; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&done) == expected);
+
+  // cleanup
+  after(tp);
+}
+
+#define LANES_TASKS_COUNT 20
+
+struct task_args_order {
+  enum tp_priority priority;
+  atomic_size_t *next;
+  enum tp_priority *order;
+};
+
+static void order_task_handler(void *_args) {
+  struct task_args_order *args = _args;
+
+  args->order[atomic_fetch_add(args->next, 1)] = args->priority;
+}
+
+static void tp_lanes_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting priority lanes (scheduler %d)\n", scheduler);
+
+  // given a single thread stuck in a task & tasks of both priorities queued behind it
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = 1, .scheduler = scheduler});
+  assert(tp);
+
+  atomic_bool started;
+  atomic_bool open;
+  atomic_size_t done;
+  atomic_init(&started, false);
+  atomic_init(&open, false);
+  atomic_init(&done, 0);
+
+  struct task_args_gate gate = {.started = &started, .open = &open, .done = &done};
+  assert(tp_add_task(tp, &(struct task){.args = &gate, .handle_task = gate_task_handler}));
+
+  struct timespec remaining = {0};
+  while (!atomic_load(&started)) { nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining); }
+
+  atomic_size_t next;
+  atomic_init(&next, 0);
+  enum tp_priority order[2 * LANES_TASKS_COUNT];
+  struct task_args_order args[2] = {{.priority = TP_PRIORITY_BULK, .next = &next, .order = order},
+                                    {.priority = TP_PRIORITY_INTERACTIVE, .next = &next, .order = order}};
+
+  for (size_t i = 0; i < 2; i++) {
+    struct task tasks[LANES_TASKS_COUNT];
+    for (size_t j = 0; j < LANES_TASKS_COUNT; j++) {
+      tasks[j] = (struct task){.args = &args[i], .priority = args[i].priority, .handle_task = order_task_handler};
+    }
+    assert(tp_add_tasks(tp, tasks, LANES_TASKS_COUNT) == LANES_TASKS_COUNT);
+  }
+
+  // when
+  atomic_store(&open, true);
+
+  // then the interactive tasks, which were added last, go first but don't starve the bulk ones
+  for (int i = 0; i < 500 && atomic_load(&next) != 2 * LANES_TASKS_COUNT; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&next) == 2 * LANES_TASKS_COUNT);
+
+  assert(order[0] == TP_PRIORITY_INTERACTIVE);
+  size_t consecutive = 0;
+  size_t bulk = 0;
+  for (size_t i = 0; i < 2 * LANES_TASKS_COUNT && bulk < LANES_TASKS_COUNT; i++) {
+    if (order[i] == TP_PRIORITY_BULK) {
+      consecutive = 0;
+      bulk++;
+    } else {
+      assert(++consecutive <= TP_WEIGHT_INTERACTIVE);
+    }
+  }
+
+  // cleanup
+  after(tp);
+}
+
+static void tp_interactive_threads_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting interactive threads (scheduler %d)\n", scheduler);
+
+  // given the only thread which takes bulk tasks stuck in one
+  struct thread_pool *tp = tp_create_with_options(
+    &(struct tp_options){.threads_count = 2, .interactive_threads = 1, .scheduler = scheduler});
+  assert(tp);
+
+  atomic_bool started;
+  atomic_bool open;
+  atomic_size_t done;
+  atomic_init(&started, false);
+  atomic_init(&open, false);
+  atomic_init(&done, 0);
+
+  struct task_args_gate gate = {.started = &started, .open = &open, .done = &done};
+  bool ret =
+    tp_add_task(tp, &(struct task){.args = &gate, .priority = TP_PRIORITY_BULK, .handle_task = gate_task_handler});
+  assert(ret);
+
+  struct timespec remaining = {0};
+  while (!atomic_load(&started)) { nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining); }
+
+  // when
+  struct task_args_count args = {.done = &done};
+  assert(tp_add_task(tp, &(struct task){.args = &args, .handle_task = count_task_handler}));
+
+  // then the interactive task doesn't wait for the bulk one
+  for (int i = 0; i < 500 && atomic_load(&done) != 1; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&done) == 1);
+
+  // cleanup
+  atomic_store(&open, true);
+  after(tp);
+}
+
+struct task_args_hold {
+  atomic_size_t *started;
+  atomic_bool *open;
+};
+
+static void hold_task_handler(void *_args) {
+  struct task_args_hold *args = _args;
+
+  atomic_fetch_add(args->started, 1);
+
+  struct timespec remaining = {0};
+  while (!atomic_load(args->open)) { nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining); }
+}
+
+static void tp_elastic_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting an elastic pool (scheduler %d)\n", scheduler);
+
+  // given a pool of a single thread which may grow up to 8
+  size_t const max = 8;
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = 1,
+                                                                       .max_threads = max,
+                                                                       .target_wait_ms = 1,
+                                                                       .idle_cooldown_ms = 100,
+                                                                       .scheduler = scheduler});
+  assert(tp);
+  assert(tp_threads_count(tp) == 1);
+
+  atomic_size_t started;
+  atomic_bool open;
+  atomic_init(&started, 0);
+  atomic_init(&open, false);
+
+  // when every thread is held up by a task
+  struct task_args_hold args = {.started = &started, .open = &open};
+  for (size_t i = 0; i < max; i++) {
+    assert(tp_add_task(tp, &(struct task){.args = &args, .handle_task = hold_task_handler}));
+  }
+
+  // then the pool grows until every task runs
+  struct timespec remaining = {0};
+  for (int i = 0; i < 500 && atomic_load(&started) != max; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&started) == max);
+  assert(tp_threads_count(tp) == max);
+
+  // and shrinks back once idle
+  atomic_store(&open, true);
+  for (int i = 0; i < 500 && tp_threads_count(tp) != 1; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(tp_threads_count(tp) == 1);
+
+  // cleanup
+  after(tp);
+}
+
+static void tp_placement_test(struct logger *restrict logger,
+                              enum tp_placement placement,
+                              enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting placement %d (scheduler %d)\n", placement, scheduler);
+
+  // a list of CPUs which is malformed or leaves no CPU to run on is rejected
+  assert(!tp_create_with_options(&(struct tp_options){.threads_count = 1, .placement = placement, .cpus = "0-"}));
+  assert(!tp_create_with_options(&(struct tp_options){.threads_count = 1, .placement = placement, .cpus = "1048576"}));
+
+  // given a pool pinned to the first CPU
+  struct thread_pool *tp = tp_create_with_options(
+    &(struct tp_options){.threads_count = 4, .placement = placement, .scheduler = scheduler, .cpus = "0"});
+  assert(tp);
+  assert(tp_nodes_count(tp) == 1);
+  assert(tp_node_of_cpu(tp, 0) == TP_NODE_ANY);
+
+  // when tasks of any node are added, including ones of nodes the pool doesn't have
+  atomic_size_t done;
+  atomic_init(&done, 0);
+
+  struct task_args_count args = {.done = &done};
+  unsigned const nodes[] = {TP_NODE_ANY, TP_NODE(0), TP_NODE(1), TP_NODE(100)};
+  size_t const count = 100;
+  for (size_t i = 0; i < count; i++) {
+    struct task task = {.args = &args, .node = nodes[i % 4], .handle_task = count_task_handler};
+    assert(tp_add_task(tp, &task));
+  }
+
+  // then all of them run
+  struct timespec remaining = {0};
+  for (int i = 0; i < 500 && atomic_load(&done) != count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&done) == count);
+
+  // cleanup
+  after(tp);
+}
+
+static void count_task_destroyer(void *_task) {
+  struct task *task = _task;
+  struct task_args_count *args = task->args;
+
+  atomic_fetch_add(args->done, 1);
+}
+
+static void tp_future_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting futures (scheduler %d)\n", scheduler);
+
+  // given
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = 4, .scheduler = scheduler});
+  assert(tp);
+
+  size_t const count = 100;
+  for (size_t i = 0; i < count; i++) {
+    atomic_size_t done;
+    atomic_size_t chained;
+    atomic_init(&done, 0);
+    atomic_init(&chained, 0);
+    struct task_args_count args = {.done = &done};
+    struct task_args_count chained_args = {.done = &chained};
+
+    // when a task is submitted & continuations are chained to it
+    struct tp_future *future = tp_submit(tp, &(struct task){.args = &args, .handle_task = count_task_handler});
+    assert(future);
+    assert(tp_future_then(future, &(struct task){.args = &chained_args, .handle_task = count_task_handler}));
+    assert(tp_future_then(future, &(struct task){.args = &chained_args, .handle_task = count_task_handler}));
+
+    // then waiting for it waits for the continuations as well
+    assert(tp_future_wait(future) == TP_FUTURE_DONE);
+    assert(tp_future_poll(future) == TP_FUTURE_DONE);
+    assert(atomic_load(&done) == 1);
+    assert(atomic_load(&chained) == 2);
+
+    // and a continuation chained once it's done runs at once
+    assert(tp_future_then(future, &(struct task){.args = &chained_args, .handle_task = count_task_handler}));
+    assert(atomic_load(&chained) == 3);
+
+    tp_future_release(future);
+  }
+
+  // cleanup
+  after(tp);
+}
+
+static void tp_future_dropped_test(struct logger *restrict logger) {
+  LOG(logger, INFO, "\n\ttesting a future of a task which never ran%s\n", "");
+
+  // given a single thread held up by a task until after the pool is destroyed
+  struct thread_pool *tp = tp_create(1);
+  assert(tp);
+
+  atomic_size_t started;
+  atomic_bool open;
+  atomic_init(&started, 0);
+  atomic_init(&open, false);
+  struct task_args_hold hold_args = {.started = &started, .open = &open};
+  assert(tp_add_task(tp, &(struct task){.args = &hold_args, .handle_task = hold_task_handler}));
+
+  struct timespec remaining = {0};
+  while (!atomic_load(&started)) { nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining); }
+
+  atomic_size_t done;
+  atomic_size_t destroyed;
+  atomic_init(&done, 0);
+  atomic_init(&destroyed, 0);
+  struct task_args_count args = {.done = &done};
+  struct task_args_count destroyed_args = {.done = &destroyed};
+
+  struct tp_future *future = tp_submit(
+    tp, &(struct task){.args = &args, .handle_task = count_task_handler, .destroy_task = count_task_destroyer});
+  assert(future);
+  assert(tp_future_then(future, &(struct task){.args = &destroyed_args, .destroy_task = count_task_destroyer}));
+
+  // when
+  thrd_t opener;
+  assert(thrd_create(&opener, open_gate, &open) == thrd_success);
+  after(tp);
+  thrd_join(opener, NULL);
+
+  // then the task & its continuation were destroyed without being run
+  assert(tp_future_wait(future) == TP_FUTURE_DROPPED);
+  assert(atomic_load(&done) == 1);  // by the task's destructor
+  assert(atomic_load(&destroyed) == 1);
+
+  // cleanup
+  tp_future_release(future);
+}
+
+static void tp_abort_queued_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting aborting queued tasks (scheduler %d)\n", scheduler);
+
+  // given a single thread held up by a task
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = 1, .scheduler = scheduler});
+  assert(tp);
+
+  atomic_size_t started;
+  atomic_bool open;
+  atomic_init(&started, 0);
+  atomic_init(&open, false);
+  struct task_args_hold hold_args = {.started = &started, .open = &open};
+  assert(tp_add_task(tp, &(struct task){.args = &hold_args, .handle_task = hold_task_handler, .id = 9}));
+
+  struct timespec remaining = {0};
+  while (!atomic_load(&started)) { nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining); }
+  assert(tp_query_task(tp, 9) == TP_TASK_RUNNING);
+
+  // & tasks queued behind it
+  atomic_size_t done;
+  atomic_size_t destroyed;
+  atomic_init(&done, 0);
+  atomic_init(&destroyed, 0);
+  struct task_args_count args = {.done = &done};
+  struct task_args_count destroyed_args = {.done = &destroyed};
+  size_t const ids[] = {7, 7, 8, 7};
+  for (size_t i = 0; i < sizeof ids / sizeof *ids; i++) {
+    assert(tp_add_task(tp, &(struct task){.args = &args, .handle_task = count_task_handler, .id = ids[i]}));
+    assert(tp_add_task(
+      tp, &(struct task){.args = &destroyed_args, .destroy_task = count_task_destroyer, .id = ids[i] + 100}));
+  }
+  assert(tp_query_task(tp, 7) == TP_TASK_QUEUED);
+  assert(tp_query_task(tp, 42) == TP_TASK_UNKNOWN);
+
+  // when
+  assert(tp_abort_task(tp, 7));
+  assert(tp_abort_task(tp, 107));
+  assert(!tp_abort_task(tp, 42));
+
+  // then the aborted tasks never run but are destroyed all the same
+  assert(tp_query_task(tp, 7) == TP_TASK_UNKNOWN);
+  assert(tp_query_task(tp, 8) == TP_TASK_QUEUED);
+
+  atomic_store(&open, true);
+  for (int i = 0; i < 500 && (atomic_load(&destroyed) != 4 || tp_query_task(tp, 8) != TP_TASK_UNKNOWN); i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&destroyed) == 4);
+  assert(atomic_load(&done) == 1);
+  assert(tp_query_task(tp, 8) == TP_TASK_UNKNOWN);
+  assert(tp_query_task(tp, 9) == TP_TASK_UNKNOWN);
+
+  // cleanup
+  after(tp);
+}
+
+static void tp_delayed_task_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting delayed tasks (scheduler %d)\n", scheduler);
+
+  // given
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = 2, .scheduler = scheduler});
+  assert(tp);
+
+  atomic_size_t done;
+  atomic_size_t destroyed;
+  atomic_init(&done, 0);
+  atomic_init(&destroyed, 0);
+  struct task_args_count args = {.done = &done};
+  struct task_args_count destroyed_args = {.done = &destroyed};
+
+  // when many timers are added & every other one is cancelled
+  size_t const count = 1000;
+  size_t *ids = malloc(count * sizeof *ids);
+  assert(ids);
+  for (size_t i = 0; i < count; i++) {
+    struct task task = {.args = i % 2 ? &destroyed_args : &args,
+                        .handle_task = count_task_handler,
+                        .destroy_task = i % 2 ? count_task_destroyer : NULL};
+    ids[i] = tp_add_delayed_task(tp, &task, 100 + (unsigned)generate_random(0, 50));
+    assert(ids[i]);
+  }
+
+  for (size_t i = 1; i < count; i += 2) { assert(tp_cancel_timer(tp, ids[i])); }
+
+  // then the cancelled ones are destroyed at once & never run
+  assert(atomic_load(&destroyed) == count / 2);
+  assert(!tp_cancel_timer(tp, ids[1]));
+  assert(atomic_load(&done) == 0);
+
+  // & the rest run once due
+  struct timespec remaining = {0};
+  for (int i = 0; i < 500 && atomic_load(&done) != count / 2; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&done) == count / 2);
+  assert(!tp_cancel_timer(tp, ids[0]));
+
+  // cleanup
+  after(tp);
+  free(ids);
+}
+
+static void tp_periodic_task_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting periodic tasks (scheduler %d)\n", scheduler);
+
+  // given
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = 2, .scheduler = scheduler});
+  assert(tp);
+
+  atomic_size_t runs;
+  atomic_size_t destroyed;
+  atomic_init(&runs, 0);
+  atomic_init(&destroyed, 0);
+  struct task_args_count runs_args = {.done = &runs};
+  struct task_args_count destroyed_args = {.done = &destroyed};
+
+  // when a periodic task runs a few times
+  size_t id = tp_add_periodic_task(tp, &(struct task){.args = &runs_args, .handle_task = count_task_handler}, 0, 5);
+  assert(id);
+  assert(!tp_add_periodic_task(tp, &(struct task){.args = &runs_args, .handle_task = count_task_handler}, 0, 0));
+
+  struct timespec remaining = {0};
+  for (int i = 0; i < 500 && atomic_load(&runs) < 5; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&runs) >= 5);
+
+  // then it stops once cancelled. a run which was in the pool already may still complete
+  assert(tp_cancel_timer(tp, id));
+  assert(!tp_cancel_timer(tp, id));
+  size_t cancelled_at = atomic_load(&runs);
+  nanosleep(&(struct timespec){.tv_nsec = 50 * 1000 * 1000}, &remaining);
+  assert(atomic_load(&runs) <= cancelled_at + 1);
+
+  // & a periodic task left running is destroyed along with the pool
+  struct task left_running = {.args = &destroyed_args, .destroy_task = count_task_destroyer};
+  assert(tp_add_periodic_task(tp, &left_running, 0, 1));
+  nanosleep(&(struct timespec){.tv_nsec = 20 * 1000 * 1000}, &remaining);
+
+  // cleanup
+  after(tp);
+  assert(atomic_load(&destroyed) == 1);
+}
+
+struct task_args_inline {
+  atomic_size_t *done;
+  size_t value;
+  size_t seen;  // written by the handler, read by the destructor
+};
+
+static void inline_task_handler(void *_args) {
+  struct task_args_inline *args = _args;
+
+  args->seen = args->value;
+}
+
+static void inline_task_destroyer(void *_task) {
+  struct task_args_inline *args = tp_task_args(_task);
+
+  if (args->seen == args->value) atomic_fetch_add(args->done, 1);
+}
+
+static void tp_inline_args_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting inline arguments (scheduler %d)\n", scheduler);
+
+  // given
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = 4, .scheduler = scheduler});
+  assert(tp);
+
+  atomic_size_t done;
+  atomic_init(&done, 0);
+
+  struct task task = {0};
+  unsigned char too_big[TP_INLINE_ARGS_SIZE + 1] = {0};
+  assert(!tp_task_set_args(&task, too_big, sizeof too_big));
+  assert(!task.inline_size);
+
+  // when tasks carry their arguments by value
+  size_t const count = 1000;
+  for (size_t i = 0; i < count; i++) {
+    task = (struct task){.handle_task = inline_task_handler, .destroy_task = inline_task_destroyer};
+    struct task_args_inline args = {.done = &done, .value = i + 1};
+    assert(tp_task_set_args(&task, &args, sizeof args));
+    assert(tp_add_task(tp, &task));
+  }
+
+  // then every handler & destructor of a task share the same copy of its arguments
+  struct timespec remaining = {0};
+  for (int i = 0; i < 500 && atomic_load(&done) != count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&done) == count);
+
+  // cleanup
+  after(tp);
+}
+
 static void tp_add_task_and_abort_test(struct logger *restrict logger, unsigned worker_delay, unsigned manager_delay) {
   // given
   struct thread_pool *tp = before(1);
@@ -224,12 +920,554 @@ static void tp_add_task_and_abort_test(struct logger *restrict logger, unsigned
 
   assert(tp_abort_task(tp, INT16_MAX));
 
+  // then the task stops long before it would have completed
+  for (int i = 0; i < 100 && !atomic_load(&args.cancelled); i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&args.cancelled));
+
   LOG(logger, INFO, "\n\tworker %ld (main) successfully aborted (id: %zu)\n", thrd_current(), (size_t)INT16_MAX);
 
   // cleanup
   after(tp);
 }
 
+struct task_args_blocked {
+  int fds[2];  // the task blocks on reading `fds[0]`. its wakeup writes into `fds[1]`
+  atomic_bool registered;
+  atomic_bool reregistered;
+  atomic_bool cancelled;
+  atomic_bool done;
+};
+
+static void pipe_wake(void *_args) {
+  struct task_args_blocked *args = _args;
+
+  assert(write(args->fds[1], "", 1) == 1);
+}
+
+static void blocked_task_handler(void *_args) {
+  struct task_args_blocked *args = _args;
+
+  atomic_store(&args->registered, tp_on_cancel(pipe_wake, args));
+
+  char c;
+  (void)read(args->fds[0], &c, 1);
+
+  // a cancelled task can't register another wakeup
+  atomic_store(&args->reregistered, tp_on_cancel(pipe_wake, args));
+  atomic_store(&args->cancelled, tp_cancelled());
+  atomic_store(&args->done, true);
+}
+
+struct task_args_fiber {
+  int fds[2];  // the task waits for `fds[0]` to be readable. non blocking
+  atomic_size_t *started;
+  atomic_size_t *done;
+  atomic_bool on_fiber;
+  atomic_bool woken;  // `tp_wait_fd` returned `true`
+};
+
+static void fiber_wake(void *_args) {
+  struct task_args_fiber *args = _args;
+
+  assert(write(args->fds[1], "", 1) == 1);
+}
+
+static void fiber_task_handler(void *_args) {
+  struct task_args_fiber *args = _args;
+
+  atomic_store(&args->on_fiber, tp_in_fiber());
+  (void)tp_on_cancel(fiber_wake, args);
+  atomic_fetch_add(args->started, 1);
+
+  char c;
+  while (read(args->fds[0], &c, 1) != 1) {
+    if (!tp_wait_fd(args->fds[0], TP_WAIT_READ)) break;
+  }
+
+  atomic_store(&args->woken, !tp_cancelled());
+  atomic_fetch_add(args->done, 1);
+}
+
+static void tp_fiber_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting tasks on fibers (scheduler %d)\n", scheduler);
+
+  // outside of a pool a wait blocks the thread
+  assert(!tp_in_fiber());
+
+  // given far more tasks blocked on pipes than threads
+  struct tp_options options = {.threads_count = 2, .scheduler = scheduler, .fibers = true, .fiber_stack_size = 16384};
+  struct thread_pool *tp = tp_create_with_options(&options);
+  assert(tp);
+
+  enum { count = 200 };
+  static struct task_args_fiber args[count];
+  atomic_size_t started;
+  atomic_size_t done;
+  atomic_init(&started, 0);
+  atomic_init(&done, 0);
+
+  for (size_t i = 0; i < count; i++) {
+    args[i] = (struct task_args_fiber){.started = &started, .done = &done};
+    assert(pipe(args[i].fds) == 0);
+    assert(fcntl(args[i].fds[0], F_SETFL, O_NONBLOCK) == 0);
+
+    struct task task = {.id = i + 1, .args = &args[i], .handle_task = fiber_task_handler};
+    assert(tp_add_task(tp, &task));
+  }
+
+  // when every task waits
+  struct timespec remaining = {0};
+  for (int i = 0; i < 500 && atomic_load(&started) != count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&started) == count);
+  assert(atomic_load(&done) == 0);
+  assert(tp_query_task(tp, 1) == TP_TASK_RUNNING);
+
+  // then a task added while the threads wait in `epoll_wait` wakes one of them up
+  atomic_size_t late;
+  atomic_init(&late, 0);
+  struct task_args_count late_args = {.done = &late};
+  assert(tp_add_task(tp, &(struct task){.args = &late_args, .handle_task = count_task_handler}));
+  for (int i = 0; i < 500 && !atomic_load(&late); i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&late) == 1);
+  assert(atomic_load(&done) == 0);
+
+  // then a suspended task is cancelled through its wakeup, the rest resume once their pipes are ready
+  assert(tp_abort_task(tp, 1));
+  for (size_t i = 1; i < count; i++) { assert(write(args[i].fds[1], "", 1) == 1); }
+
+  for (int i = 0; i < 500 && atomic_load(&done) != count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&done) == count);
+  assert(!atomic_load(&args[0].woken));
+  for (size_t i = 0; i < count; i++) {
+    assert(atomic_load(&args[i].on_fiber));
+    assert(atomic_load(&args[i].woken) == (i != 0));
+  }
+
+  // cleanup
+  after(tp);
+  for (size_t i = 0; i < count; i++) {
+    close(args[i].fds[0]);
+    close(args[i].fds[1]);
+  }
+}
+
+struct strand_state {
+  atomic_bool busy;  // a task of the strand runs
+  atomic_size_t next;  // the sequence number of the task expected to run next
+  atomic_bool overlapped;
+  atomic_bool reordered;
+};
+
+struct task_args_strand {
+  struct strand_state *state;
+  size_t seq;
+};
+
+static void strand_task_handler(void *_args) {
+  struct task_args_strand *args = _args;
+  struct strand_state *state = args->state;
+
+  if (atomic_exchange(&state->busy, true)) atomic_store(&state->overlapped, true);
+  if (atomic_load(&state->next) != args->seq) atomic_store(&state->reordered, true);
+
+  thrd_yield();
+
+  atomic_store(&state->next, args->seq + 1);
+  atomic_store(&state->busy, false);
+}
+
+static void tp_strand_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting strands (scheduler %d)\n", scheduler);
+
+  // given
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = 4, .scheduler = scheduler});
+  assert(tp);
+
+  enum { strands_count = 8, tasks_count = 200 };
+  struct tp_strand *strands[strands_count];
+  static struct strand_state states[strands_count];
+  for (size_t i = 0; i < strands_count; i++) {
+    strands[i] = tp_strand_create(tp);
+    assert(strands[i]);
+
+    states[i] = (struct strand_state){0};
+  }
+
+  // when the tasks of several strands are added interleaved
+  for (size_t seq = 0; seq < tasks_count; seq++) {
+    for (size_t i = 0; i < strands_count; i++) {
+      struct task task = {.handle_task = strand_task_handler};
+      struct task_args_strand args = {.state = &states[i], .seq = seq};
+      assert(tp_task_set_args(&task, &args, sizeof args));
+      assert(tp_strand_add_task(strands[i], &task));
+    }
+  }
+
+  // released while they still have tasks
+  for (size_t i = 0; i < strands_count; i++) { tp_strand_destroy(strands[i]); }
+
+  // then the tasks of each strand run one at a time, in order
+  struct timespec remaining = {0};
+  for (size_t i = 0; i < strands_count; i++) {
+    for (int j = 0; j < 500 && atomic_load(&states[i].next) != tasks_count; j++) {
+      nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+    }
+    assert(atomic_load(&states[i].next) == tasks_count);
+    assert(!atomic_load(&states[i].overlapped));
+    assert(!atomic_load(&states[i].reordered));
+  }
+
+  // cleanup
+  after(tp);
+}
+
+static void tp_strand_dropped_test(struct logger *restrict logger) {
+  LOG(logger, INFO, "\n\ttesting a strand on a pool being destroyed%s\n", "");
+
+  // given a strand with tasks waiting for their turn
+  struct thread_pool *tp = before(1);
+  assert(tp);
+
+  struct tp_strand *strand = tp_strand_create(tp);
+  assert(strand);
+
+  atomic_size_t run;
+  atomic_size_t destroyed;
+  atomic_init(&run, 0);
+  atomic_init(&destroyed, 0);
+  struct task_args_count run_args = {.done = &run};
+  struct task_args_count destroyed_args = {.done = &destroyed};
+
+  size_t const count = 100;
+  for (size_t i = 0; i < count; i++) {
+    // the handler is passed the inline arguments, the destructor looks at `task::args`
+    struct task task = {.handle_task = count_task_handler};
+    assert(tp_task_set_args(&task, &run_args, sizeof run_args));
+    task.args = &destroyed_args;
+    task.destroy_task = count_task_destroyer;
+    assert(tp_strand_add_task(strand, &task));
+  }
+  tp_strand_destroy(strand);
+
+  // when
+  after(tp);
+
+  // then every task was destroyed, whether it ran or not
+  assert(atomic_load(&destroyed) == count);
+  assert(atomic_load(&run) <= count);
+}
+
+static void tp_spin_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting spinning idle threads (scheduler %d)\n", scheduler);
+
+  // given a pool with a spinning thread
+  struct tp_options options = {.threads_count = 2, .scheduler = scheduler, .spinning_threads = 1, .spin_us = 20};
+  struct thread_pool *tp = tp_create_with_options(&options);
+  assert(tp);
+
+  atomic_size_t done;
+  atomic_init(&done, 0);
+  struct task_args_count args = {.done = &done};
+
+  // when tasks trickle in, one at a time
+  size_t const count = 200;
+  struct timespec remaining = {0};
+  for (size_t i = 0; i < count; i++) {
+    assert(tp_add_task(tp, &(struct task){.args = &args, .handle_task = count_task_handler}));
+
+    for (int j = 0; j < 500 && atomic_load(&done) != i + 1; j++) {
+      nanosleep(&(struct timespec){.tv_nsec = 100 * 1000}, &remaining);
+    }
+
+    // then every one of them is taken, whether a thread spins or sleeps by the time it's added
+    assert(atomic_load(&done) == i + 1);
+
+    // some are added while the threads sleep
+    if (i % 50 == 0) nanosleep(&(struct timespec){.tv_nsec = 2 * 1000 * 1000}, &remaining);
+  }
+
+  // cleanup
+  after(tp);
+}
+
+struct task_args_stall {
+  atomic_bool *released;
+  atomic_bool *started;  // optional. set once the task runs
+};
+
+// holds its thread up until released, e.g. like an `open` on a stalled mount
+static void stall_task_handler(void *_args) {
+  struct task_args_stall *args = _args;
+  if (args->started) atomic_store(args->started, true);
+
+  struct timespec remaining = {0};
+  while (!atomic_load(args->released)) { nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining); }
+}
+
+struct task_args_offload {
+  struct thread_pool *cpu;
+  struct thread_pool *io;
+  atomic_size_t *called;  // by the calls run on `io`
+  atomic_size_t *done;    // by the tasks run on `cpu`, once their call returned
+};
+
+static void count_call(void *done) {
+  atomic_fetch_add((atomic_size_t *)done, 1);
+}
+
+static void offload_task_handler(void *_args) {
+  struct task_args_offload *args = _args;
+
+  bool ran = tp_run_on(args->io, count_call, args->called);
+  if (ran && tp_current() == args->cpu) atomic_fetch_add(args->done, 1);
+}
+
+static void tp_run_on_test(struct logger *restrict logger) {
+  LOG(logger, INFO, "\n\ttesting calls handed to another pool%s\n", "");
+
+  // given a cpu pool & an io pool whose only thread is stalled
+  struct tp_options cpu_options = {.name = "cpu", .threads_count = 2, .fibers = true};
+  struct tp_options io_options = {.name = "io", .threads_count = 1};
+  struct thread_pool *cpu = tp_create_with_options(&cpu_options);
+  struct thread_pool *io = tp_create_with_options(&io_options);
+  assert(cpu && io);
+  assert(strcmp(tp_name(cpu), "cpu") == 0);
+  assert(strcmp(tp_name(io), "io") == 0);
+  assert(!tp_current());
+
+  atomic_bool released;
+  atomic_init(&released, false);
+  struct task_args_stall stall_args = {.released = &released};
+  assert(tp_add_task(io, &(struct task){.args = &stall_args, .handle_task = stall_task_handler}));
+
+  // when the tasks of the cpu pool hand calls to the io pool
+  atomic_size_t called;
+  atomic_size_t done;
+  atomic_init(&called, 0);
+  atomic_init(&done, 0);
+  struct task_args_offload offload_args = {.cpu = cpu, .io = io, .called = &called, .done = &done};
+
+  size_t const count = 20;
+  for (size_t i = 0; i < count; i++) {
+    assert(tp_add_task(cpu, &(struct task){.args = &offload_args, .handle_task = offload_task_handler}));
+  }
+
+  // then the cpu pool goes on with other tasks while they wait
+  atomic_size_t other;
+  atomic_init(&other, 0);
+  struct task_args_count other_args = {.done = &other};
+  for (size_t i = 0; i < count; i++) {
+    assert(tp_add_task(cpu, &(struct task){.args = &other_args, .handle_task = count_task_handler}));
+  }
+
+  struct timespec remaining = {0};
+  for (int i = 0; i < 2000 && atomic_load(&other) != count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&other) == count);
+  assert(atomic_load(&called) == 0);
+  assert(atomic_load(&done) == 0);
+
+  // and every call returns once the io pool gets going
+  atomic_store(&released, true);
+  for (int i = 0; i < 2000 && atomic_load(&done) != count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&called) == count);
+  assert(atomic_load(&done) == count);
+
+  // a caller which isn't one of the pools' threads blocks
+  assert(tp_run_on(io, count_call, &called));
+  assert(atomic_load(&called) == count + 1);
+
+  // cleanup
+  after(cpu);
+  after(io);
+}
+
+static void tp_stats_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting the telemetry of a pool (scheduler %d)\n", scheduler);
+
+  // given a pool which times every task & whose only thread is held up while tasks pile up
+  struct tp_options options = {.threads_count = 1, .scheduler = scheduler, .stats_every = 1};
+  struct thread_pool *tp = tp_create_with_options(&options);
+  assert(tp);
+
+  atomic_bool released;
+  atomic_bool started;
+  atomic_init(&released, false);
+  atomic_init(&started, false);
+  struct task_args_stall stall_args = {.released = &released, .started = &started};
+  assert(tp_add_task(tp, &(struct task){.args = &stall_args, .handle_task = stall_task_handler}));
+
+  // the thread may pick the stalled task up late. the tasks pile up & the stall is timed only once it runs
+  struct timespec remaining = {0};
+  for (int i = 0; i < 2000 && !atomic_load(&started); i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&started));
+
+  atomic_size_t done;
+  atomic_size_t dropped;
+  atomic_init(&done, 0);
+  atomic_init(&dropped, 0);
+  struct task_args_count args = {.done = &done};
+  struct task_args_count dropped_args = {.done = &dropped};
+
+  size_t const count = 100;
+  for (size_t i = 0; i < count; i++) {
+    assert(tp_add_task(tp, &(struct task){.args = &args, .handle_task = count_task_handler}));
+  }
+  assert(tp_add_task(tp, &(struct task){.id = 7, .args = &dropped_args, .handle_task = count_task_handler}));
+  assert(tp_abort_task(tp, 7));
+
+  nanosleep(&(struct timespec){.tv_nsec = 20 * 1000 * 1000}, &remaining);
+
+  // when they're let through
+  atomic_store(&released, true);
+
+  struct tp_stats stats = {0};
+  for (int i = 0; i < 2000 && stats.run.count != count + 2; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining);
+    assert(tp_stats(tp, &stats));
+  }
+
+  // then the snapshot accounts for every one of them
+  assert(atomic_load(&done) == count);
+  assert(atomic_load(&dropped) == 0);
+  assert(stats.threads == 1);
+  assert(stats.taken == count + 2);
+  assert(stats.run.count == count + 2);
+  assert(stats.wait.count == count + 2);
+  assert(stats.aborted == 1);
+  assert(stats.queued == 0);
+  assert(stats.queued_max >= count);
+
+  // the tasks waited for the stalled one, which ran for as long as it was held up
+  uint64_t const stalled_ns = 20 * 1000 * 1000;
+  assert(stats.wait.max_ns >= stalled_ns);
+  assert(stats.run.max_ns >= stalled_ns);
+  assert(stats.busy_ns >= stalled_ns);
+  assert(tp_histogram_percentile(&stats.wait, 50) <= tp_histogram_percentile(&stats.wait, 99));
+  assert(tp_histogram_percentile(&stats.wait, 100) == stats.wait.max_ns);
+
+  // cleanup
+  after(tp);
+}
+
+struct task_args_slab_free {
+  struct tp_slab *slab;
+  void *object;
+  atomic_size_t *done;
+};
+
+static void slab_free_task_handler(void *_args) {
+  struct task_args_slab_free *args = _args;
+
+  tp_slab_free(args->slab, args->object);
+  atomic_fetch_add(args->done, 1);
+}
+
+static void tp_slab_test(struct logger *restrict logger, enum tp_scheduler scheduler) {
+  LOG(logger, INFO, "\n\ttesting a slab freed into by other threads with scheduler %d\n", scheduler);
+
+  // given a slab of objects of an odd size
+  struct tp_slab *slab = tp_slab_create(20);
+  assert(slab);
+
+  enum { objects_count = 300 };
+  unsigned char *objects[objects_count];
+  for (size_t i = 0; i < objects_count; i++) {
+    objects[i] = tp_slab_alloc(slab);
+    assert(objects[i]);
+    assert((uintptr_t)objects[i] % alignof(max_align_t) == 0);
+    memset(objects[i], (int)i, 20);
+  }
+
+  // every object is an object of its own
+  for (size_t i = 0; i < objects_count; i++) {
+    for (size_t j = 0; j < 20; j++) { assert(objects[i][j] == (unsigned char)i); }
+  }
+
+  // when the threads of a pool free them
+  struct thread_pool *tp = tp_create_with_options(&(struct tp_options){.threads_count = 4, .scheduler = scheduler});
+  assert(tp);
+
+  atomic_size_t done;
+  atomic_init(&done, 0);
+  for (size_t i = 0; i < objects_count; i++) {
+    struct task task = {.handle_task = slab_free_task_handler};
+    struct task_args_slab_free args = {.slab = slab, .object = objects[i], .done = &done};
+    assert(tp_task_set_args(&task, &args, sizeof args));
+    assert(tp_add_task(tp, &task));
+  }
+
+  struct timespec remaining = {0};
+  for (int i = 0; i < 2000 && atomic_load(&done) != objects_count; i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&done) == objects_count);
+
+  // then the objects they kept for themselves go back to the depot once they exit, the ones they had too many of went
+  // there already. this thread gets them all back
+  after(tp);
+
+  for (size_t i = 0; i < objects_count; i++) {
+    objects[i] = tp_slab_alloc(slab);
+    assert(objects[i]);
+  }
+  for (size_t i = 0; i < objects_count; i++) { tp_slab_free(slab, objects[i]); }
+
+  // cleanup
+  tp_slab_destroy(slab);
+}
+
+static void tp_on_cancel_test(struct logger *restrict logger) {
+  LOG(logger, INFO, "\n\ttesting a wakeup on cancellation%s\n", "");
+
+  // outside of a pool there is nothing to cancel
+  assert(!tp_cancelled());
+  assert(!tp_on_cancel(pipe_wake, NULL));
+
+  // given a task blocked on a pipe
+  struct thread_pool *tp = before(1);
+  assert(tp);
+
+  struct task_args_blocked args = {0};
+  assert(pipe(args.fds) == 0);
+  assert(tp_add_task(tp, &(struct task){.args = &args, .handle_task = blocked_task_handler, .id = 1}));
+
+  struct timespec remaining = {0};
+  for (int i = 0; i < 500 && !atomic_load(&args.registered); i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&args.registered));
+
+  // when
+  assert(tp_abort_task(tp, 1));
+
+  // then its wakeup unblocks it
+  for (int i = 0; i < 500 && !atomic_load(&args.done); i++) {
+    nanosleep(&(struct timespec){.tv_nsec = 10 * 1000 * 1000}, &remaining);
+  }
+  assert(atomic_load(&args.done));
+  assert(atomic_load(&args.cancelled));
+  assert(!atomic_load(&args.reregistered));
+
+  // cleanup
+  after(tp);
+  close(args.fds[0]);
+  close(args.fds[1]);
+}
+
 static void tp_add_task_abort_then_add_another_test(struct logger *restrict logger,
                                                     unsigned worker_delay,
                                                     unsigned manager_delay,
@@ -306,7 +1544,7 @@ static void tp_add_task_abort_then_add_another_test(struct logger *restrict logg
 
 int main(void) {
   srand((unsigned)time(NULL));
-  struct logger *logger = logger_create("tp_sanity.log", SIGUSR1);
+  struct logger *logger = logger_create("tp_sanity.log", SIG_NONE);
   assert(logger);
 
   tp_create_invalid_test(logger);
@@ -322,7 +1560,81 @@ int main(void) {
   tp_add_multiple_tasks_test(logger, 100, 10);
   tp_add_multiple_tasks_test(logger, 100, 50);
 
+  tp_spawn_test(logger, (struct tp_options){.threads_count = 1, .scheduler = TP_SCHEDULER_STEALING}, 10);
+  tp_spawn_test(logger, (struct tp_options){.threads_count = 4, .scheduler = TP_SCHEDULER_STEALING}, 14);
+  tp_spawn_test(logger, (struct tp_options){.threads_count = 50, .scheduler = TP_SCHEDULER_STEALING}, 14);
+  tp_spawn_test(logger, (struct tp_options){.threads_count = 4, .scheduler = TP_SCHEDULER_RING}, 14);
+  tp_spawn_test(logger,
+                (struct tp_options){.threads_count = 50, .scheduler = TP_SCHEDULER_RING, .ring_capacity = 16},
+                14);
+
+  tp_add_tasks_test(logger, (struct tp_options){.threads_count = 10}, 100, 64);
+  tp_add_tasks_test(logger, (struct tp_options){.threads_count = 10, .scheduler = TP_SCHEDULER_STEALING}, 100, 64);
+  tp_add_tasks_test(logger,
+                    (struct tp_options){.threads_count = 10, .scheduler = TP_SCHEDULER_RING, .ring_capacity = 16},
+                    100,
+                    64);
+
+  tp_ring_overflow_test(logger, TP_OVERFLOW_FAIL);
+  tp_ring_overflow_test(logger, TP_OVERFLOW_SPILL);
+  tp_ring_overflow_test(logger, TP_OVERFLOW_BLOCK);
+
+  tp_lanes_test(logger, TP_SCHEDULER_SHARED);
+  tp_lanes_test(logger, TP_SCHEDULER_STEALING);
+  tp_lanes_test(logger, TP_SCHEDULER_RING);
+  tp_interactive_threads_test(logger, TP_SCHEDULER_SHARED);
+  tp_interactive_threads_test(logger, TP_SCHEDULER_STEALING);
+  tp_interactive_threads_test(logger, TP_SCHEDULER_RING);
+  tp_elastic_test(logger, TP_SCHEDULER_SHARED);
+  tp_elastic_test(logger, TP_SCHEDULER_STEALING);
+  tp_elastic_test(logger, TP_SCHEDULER_RING);
+  tp_placement_test(logger, TP_PLACEMENT_CPU, TP_SCHEDULER_SHARED);
+  tp_placement_test(logger, TP_PLACEMENT_NODE, TP_SCHEDULER_SHARED);
+  tp_placement_test(logger, TP_PLACEMENT_NODE, TP_SCHEDULER_STEALING);
+  tp_placement_test(logger, TP_PLACEMENT_NODE, TP_SCHEDULER_RING);
+
+  tp_future_test(logger, TP_SCHEDULER_SHARED);
+  tp_future_test(logger, TP_SCHEDULER_STEALING);
+  tp_future_test(logger, TP_SCHEDULER_RING);
+  tp_future_dropped_test(logger);
+
+  tp_abort_queued_test(logger, TP_SCHEDULER_SHARED);
+  tp_abort_queued_test(logger, TP_SCHEDULER_STEALING);
+  tp_abort_queued_test(logger, TP_SCHEDULER_RING);
+  tp_delayed_task_test(logger, TP_SCHEDULER_SHARED);
+  tp_delayed_task_test(logger, TP_SCHEDULER_RING);
+  tp_periodic_task_test(logger, TP_SCHEDULER_SHARED);
+  tp_periodic_task_test(logger, TP_SCHEDULER_STEALING);
+  tp_periodic_task_test(logger, TP_SCHEDULER_RING);
+
+  tp_inline_args_test(logger, TP_SCHEDULER_SHARED);
+  tp_inline_args_test(logger, TP_SCHEDULER_STEALING);
+  tp_inline_args_test(logger, TP_SCHEDULER_RING);
+
+  tp_fiber_test(logger, TP_SCHEDULER_SHARED);
+  tp_fiber_test(logger, TP_SCHEDULER_STEALING);
+  tp_fiber_test(logger, TP_SCHEDULER_RING);
+
+  tp_strand_test(logger, TP_SCHEDULER_SHARED);
+  tp_strand_test(logger, TP_SCHEDULER_STEALING);
+  tp_strand_test(logger, TP_SCHEDULER_RING);
+  tp_strand_dropped_test(logger);
+
+  tp_spin_test(logger, TP_SCHEDULER_SHARED);
+  tp_spin_test(logger, TP_SCHEDULER_STEALING);
+  tp_spin_test(logger, TP_SCHEDULER_RING);
+
+  tp_run_on_test(logger);
+
+  tp_stats_test(logger, TP_SCHEDULER_SHARED);
+  tp_stats_test(logger, TP_SCHEDULER_STEALING);
+  tp_stats_test(logger, TP_SCHEDULER_RING);
+
+  tp_slab_test(logger, TP_SCHEDULER_SHARED);
+  tp_slab_test(logger, TP_SCHEDULER_STEALING);
+
   tp_add_task_and_abort_test(logger, 5, 1);
+  tp_on_cancel_test(logger);
   tp_add_task_abort_then_add_another_test(logger, 5, 1, 1);
   tp_add_task_abort_then_add_another_test(logger, 5, 1, 2);
   tp_add_task_abort_then_add_another_test(logger, 5, 1, 10);
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <sys/types.h>
 #include <time.h>
 #include "ascii_str.h"
 
+struct tp_strand;
+
 enum data_socket_mode {
   SOCKET_PASSIVE,
   SOCKET_ACTIVE,
@@ -37,6 +40,19 @@ struct session {
   struct ascii_str working_dir; /**< the root directory. 'user space' is considered to be <working_dir>/<user_name>.
                                    working_dir better be an absolute path*/
   struct ascii_str current_dir;
+
+  off_t allocated; /**< the size declared by ALLO for the next upload. 0 if none was declared */
+  off_t restart;   /**< the offset set by REST for the next transfer. 0 if none was set */
+
+  struct ascii_str copy_from; /**< the resolved source set by SITE CPFR for the next SITE CPTO. empty if none */
+
+  unsigned node; /**< the node group of the thread pool the session's tasks go to (see `socket_node`). 0 (any node) if
+                    none */
+
+  struct tp_strand *strand; /**< the session's commands run on it one at a time, in order (e.g. RNFR before RNTO), thus
+                               a command sees the session as the previous one left it. ABOR & STAT skip it, they're
+                               about the command which runs (see `command_serialized`). set once the session is
+                               registered. `NULL` if none. released by `session_destroy` */
 };
 
 /**
@@ -58,3 +74,15 @@ struct session session_create(struct ascii_str *restrict ip,
                               int control_sockfd);
 
 void session_destroy(struct session *session);
+
+/**
+ * @brief resolves `path` against the user space of `session`. an absolute `path` is resolved against the root of the
+ * user space, a relative one against `session::current_dir`. a path which may lead out of the user space (i.e. one with
+ * a `..` component) is refused
+ *
+ * @param[in] session
+ * @param[in] path - may be `NULL` or empty in which case the current directory is returned
+ * @return `struct ascii_str` - the resolved path. i.e. <working_dir>/<username>/<current_dir>/<path>. empty if
+ * `path` was refused
+ */
+struct ascii_str session_path(struct session const *restrict session, struct ascii_str const *restrict path);
@@ -1,5 +1,8 @@
 #include "session.h"
+#include <stdbool.h>
+#include <string.h>
 #include <unistd.h>
+#include "thread_pool.h"
 
 // TODO: default data_sockfd shouldn't be -1
 struct session session_create(struct ascii_str *restrict ip,
@@ -27,6 +30,7 @@ struct session session_create(struct ascii_str *restrict ip,
     .password = *password,
     .working_dir = wd,
     .current_dir = ascii_str_create(NULL, 0),
+    .copy_from = ascii_str_create(NULL, 0),
     .last_seen = time(NULL),
   };
 
@@ -46,4 +50,46 @@ void session_destroy(struct session *session) {
 
   ascii_str_destroy(&session->username);
   ascii_str_destroy(&session->current_dir);
+  ascii_str_destroy(&session->copy_from);
+
+  tp_strand_destroy(session->strand);
+}
+
+// whether `path` has a `..` component, i.e. whether it may lead out of the directory it's resolved against
+static bool has_parent_component(char const *path) {
+  for (char const *component = path; *component;) {
+    size_t len = strcspn(component, "/");
+    if (len == 2 && component[0] == '.' && component[1] == '.') return true;
+
+    component += len;
+    if (*component) component++;
+  }
+
+  return false;
+}
+
+struct ascii_str session_path(struct session const *restrict session, struct ascii_str const *restrict path) {
+  struct ascii_str resolved = ascii_str_create(NULL, 0);
+  if (!session) return resolved;
+
+  // the user space is a jail. nothing resolved against it may lead out of it
+  if (has_parent_component(ascii_str_c_str(&session->current_dir))) return resolved;
+  if (path && has_parent_component(ascii_str_c_str(path))) return resolved;
+
+  ascii_str_append(&resolved, ascii_str_c_str(&session->working_dir));
+  ascii_str_push(&resolved, '/');
+  ascii_str_append(&resolved, ascii_str_c_str(&session->username));
+
+  bool absolute = path && !ascii_str_empty(path) && ascii_str_c_str(path)[0] == '/';
+  if (!absolute && !ascii_str_empty(&session->current_dir)) {
+    ascii_str_push(&resolved, '/');
+    ascii_str_append(&resolved, ascii_str_c_str(&session->current_dir));
+  }
+
+  if (path && !ascii_str_empty(path)) {
+    if (!absolute) ascii_str_push(&resolved, '/');
+    ascii_str_append(&resolved, ascii_str_c_str(path));
+  }
+
+  return resolved;
 }
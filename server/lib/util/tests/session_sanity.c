@@ -0,0 +1,49 @@
+#include <assert.h>
+#include <string.h>
+#include "ascii_str.h"
+#include "session.h"
+
+static struct session before(char const *restrict current_dir) {
+  return (struct session){.working_dir = ascii_str_create("/srv/ftp", STR_C_STR),
+                          .username = ascii_str_create("user", STR_C_STR),
+                          .current_dir = ascii_str_create(current_dir, STR_C_STR)};
+}
+
+static void after(struct session *session) {
+  ascii_str_destroy(&session->working_dir);
+  ascii_str_destroy(&session->username);
+  ascii_str_destroy(&session->current_dir);
+}
+
+static void test_path(char const *restrict current_dir, char const *restrict path, char const *restrict expected) {
+  struct session session = before(current_dir);
+  struct ascii_str arg = ascii_str_create(path, STR_C_STR);
+
+  struct ascii_str resolved = session_path(&session, path ? &arg : NULL);
+  assert(strcmp(ascii_str_c_str(&resolved), expected) == 0);
+
+  ascii_str_destroy(&resolved);
+  ascii_str_destroy(&arg);
+  after(&session);
+}
+
+int main(void) {
+  // a path is resolved against the current directory, an absolute one against the root of the user space
+  test_path("", NULL, "/srv/ftp/user");
+  test_path("", "some_file", "/srv/ftp/user/some_file");
+  test_path("dir", "some_file", "/srv/ftp/user/dir/some_file");
+  test_path("dir", "/some_file", "/srv/ftp/user/some_file");
+  test_path("dir", "sub/./some_file", "/srv/ftp/user/dir/sub/./some_file");
+  test_path("", "..some_file", "/srv/ftp/user/..some_file");
+  test_path("", "some_file..", "/srv/ftp/user/some_file..");
+
+  // a path which may lead out of the user space is refused
+  test_path("", "..", "");
+  test_path("", "../other_user", "");
+  test_path("", "../../../etc/shadow", "");
+  test_path("", "/../etc/shadow", "");
+  test_path("dir", "sub/../../..", "");
+  test_path("dir", "sub/..", "");
+  test_path("..", "some_file", "");
+  test_path("..", NULL, "");
+}
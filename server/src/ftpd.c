@@ -22,22 +22,42 @@ int main(int argc, char *argv[]) {
    * create logger
    */
   char const *logger_file = "ftpd.log";  // TODO: logger file should be read from a config file
-  struct logger *logger = logger_create(logger_file, SIGUSR1);
+  struct logger *logger = logger_create(logger_file, SIG_NONE);
   if (!logger) {
     fprintf(stderr, "failed to create a logger\n");
     return 1;
   }
 
   /*
-   * create a thread pool
+   * create the thread pools
    */
-  uint8_t threads_count = 100;  // TODO: the thread count should be read from a config file
-  struct thread_pool *tp = tp_create(threads_count);
-  if (!tp) {
-    LOG(logger, ERROR, "failed to create a thread pool with %hhd threads", threads_count);
+  // TODO: the thread counts should be read from a config file
+  // the file system calls which may block for long (`open`, `stat`, `fsync` on a slow or stalled NFS mount) run on the
+  // io pool (see `task_args_blocking`). a stalled mount holds its threads up, never the ones the commands run on. they
+  // wait in the kernel rather than burn a CPU, thus the pool is far larger than the number of cores
+  struct tp_options io_options = {.name = "io", .threads_count = 32, .max_threads = 256};
+  struct thread_pool *io_tp = tp_create_with_options(&io_options);
+  if (!io_tp) {
+    LOG(logger, ERROR, "failed to create a thread pool with %zu threads", io_options.threads_count);
     goto logger_cleanup;
   }
 
+  // the commands run on the cpu pool. control commands get threads of their own so they never wait for transfers to
+  // free one up. the pool starts with a thread per core & grows while transfers hold every thread up. a task waiting
+  // for its socket or for the io pool suspends its fiber & frees its thread up meanwhile. created last & destroyed
+  // first: its tasks may wait for the io pool
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  struct tp_options tp_options = {.name = "cpu",
+                                  .threads_count = 10 + (cores > 0 ? (size_t)cores : 1),
+                                  .max_threads = 1024,
+                                  .interactive_threads = 10,
+                                  .fibers = true};
+  struct thread_pool *tp = tp_create_with_options(&tp_options);
+  if (!tp) {
+    LOG(logger, ERROR, "failed to create a thread pool with %zu threads", tp_options.threads_count);
+    goto io_thread_pool_cleanup;
+  }
+
   /*
    * create a vec of sessions
    */
@@ -47,9 +67,16 @@ int main(int argc, char *argv[]) {
     goto thread_pool_cleanup;
   }
 
-  if (sig_handler_install(SIGINT, sigint_handler)) {
+  if (!sig_handler_install(SIGINT, sigint_handler)) {
     LOG(logger, ERROR, "failed to install a signal handler for signal: %d\n", SIGINT);
-    goto logger_cleanup;
+    goto sessions_cleanup;
+  }
+
+  // a client which closes its data connection mid transfer must not take the server down. unlike `send`, `sendfile`
+  // has no way to suppress SIGPIPE
+  if (!sig_handler_install(SIGPIPE, SIG_IGN)) {
+    LOG(logger, ERROR, "failed to ignore signal: %d\n", SIGPIPE);
+    goto sessions_cleanup;
   }
 
   atomic_store(&global_terminate, false);  // global init
@@ -62,6 +89,8 @@ sessions_cleanup:
   vec_destroy(&sessions);
 thread_pool_cleanup:
   tp_destroy(tp);
+io_thread_pool_cleanup:
+  tp_destroy(io_tp);
 logger_cleanup:
   logger_destroy(logger);
 